@@ -23,6 +23,7 @@ import (
 	"fmt"
 	"runtime"
 	"sync"
+	"time"
 	"unsafe"
 )
 
@@ -92,6 +93,8 @@ type AgoraServiceConfig struct {
 
 	// date: 2025-11-03, idle mode, if true, the connection will be released when idle for a period of time
 	IdleMode bool
+	// the number of goroutines destroying the connections released in idle mode, 0: 4
+	IdleDestroyWorkers int
 }
 
 // const def for map type
@@ -119,11 +122,10 @@ type AgoraService struct {
 	mediaFactory                *MediaNodeFactory
 	apmConfig                   *APMConfig
 	//timer related
-	timer          *PrecisionTimer
-	idleQueue      []*IdleItem
-	idleQueueMutex sync.Mutex
-	idleMode       bool
-	apmModel       int
+	timer     *PrecisionTimer
+	idleQueue *idleDestroyQueue
+	idleMode  bool
+	apmModel  int
 }
 
 // / newAgoraService creates a new instance of AgoraService
@@ -133,13 +135,12 @@ func newAgoraService() *AgoraService {
 		service: nil,
 		//isSteroEncodeMode: false,
 		//audioScenario: AudioScenarioChorus,
-		mediaFactory:   nil,
-		apmConfig:      nil,
-		timer:          nil,
-		idleQueue:      make([]*IdleItem, 0),
-		idleQueueMutex: sync.Mutex{},
-		idleMode:       false,
-		apmModel:       0,
+		mediaFactory: nil,
+		apmConfig:    nil,
+		timer:        nil,
+		idleQueue:    nil,
+		idleMode:     false,
+		apmModel:     0,
 	}
 }
 
@@ -249,6 +250,9 @@ func Initialize(cfg *AgoraServiceConfig) int {
 	// and start the timer
 	if cfg.IdleMode {
 		agoraService.idleMode = true
+		agoraService.idleQueue = newIdleDestroyQueue(cfg.IdleDestroyWorkers, func(handle unsafe.Pointer) {
+			C.agora_rtc_conn_destroy(handle)
+		})
 		agoraService.timer = NewPrecisionTimer(50) // 50ms
 		agoraService.timer.Start(timerTask)
 	}
@@ -260,46 +264,29 @@ func timerTask() {
 	removeIdleItem()
 }
 func addIdleItem(handle unsafe.Pointer, lifeCycleInMs int) {
-	idleItem := newIdleItem(handle, lifeCycleInMs/50) // convert to 50ms interval
-	agoraService.idleQueueMutex.Lock()
-	agoraService.idleQueue = append(agoraService.idleQueue, idleItem)
-	agoraService.idleQueueMutex.Unlock()
-}
-func removeIdleItem() {
-	agoraService.idleQueueMutex.Lock()
-	defer agoraService.idleQueueMutex.Unlock()
-
-	//check size
-	if len(agoraService.idleQueue) == 0 {
+	queue := agoraService.idleQueue
+	if queue == nil {
+		C.agora_rtc_conn_destroy(handle)
 		return
 	}
-
-	for _, item := range agoraService.idleQueue {
-		item.LifeCycle -= 1
-	}
-	//check the first one, if the LifeCycle is 0, remove it
-	item := agoraService.idleQueue[0]
-	if item.LifeCycle <= 0 {
-		agoraService.idleQueue = agoraService.idleQueue[1:]
-		// and release it
-		C.agora_rtc_conn_destroy(item.Handle)
-		fmt.Printf("remove idle item: %p\n", item.Handle)
-		// reset
-		item = nil
+	queue.add(handle, time.Duration(lifeCycleInMs)*time.Millisecond)
+}
+func removeIdleItem() {
+	// destroys all the expired items, in batches on the workers of the queue
+	if queue := agoraService.idleQueue; queue != nil {
+		queue.expire(time.Now())
 	}
-
 }
 func releaseAllIdleItems() {
-	agoraService.idleQueueMutex.Lock()
-	defer agoraService.idleQueueMutex.Unlock()
+	agoraService.idleQueue.close()
+}
 
-	for _, item := range agoraService.idleQueue {
-		C.agora_rtc_conn_destroy(item.Handle)
-		fmt.Printf("release all idle item: %p\n", item.Handle)
-		item = nil
+// GetIdleDestroyStats returns the counters of the connections released in idle mode.
+func GetIdleDestroyStats() IdleDestroyStats {
+	if agoraService.idleQueue == nil {
+		return IdleDestroyStats{}
 	}
-	agoraService.idleQueue = make([]*IdleItem, 0)
-
+	return agoraService.idleQueue.stats()
 }
 
 // Release the Agora service.
@@ -315,6 +302,8 @@ func Release() int {
 		agoraService.timer = nil
 
 		releaseAllIdleItems()
+		agoraService.idleQueue = nil
+		agoraService.idleMode = false
 	}
 	// cleanup go layer resources
 	agoraService.cleanup()
@@ -310,24 +310,33 @@ func min(a, b int) int {
 * vadDump.Open()
 * vadDump.Write(frame, vadFrame, state) // frame: the audio frame, vadFrame: the vad result, state: the vad state
 * vadDump.Close()
+* Write only copies the frame into a ring, files are written by a background goroutine(ref to vad_dump_writer.go).
+* if the disk can not keep up, frames are dropped and counted, ref to DroppedFrames
+* files in the dump dir:
+*   source.pcm: the source pcm
+*   label.bin: one VadDumpLabelRecordSize bytes record per frame, ref to DecodeVadDumpLabel
+*   voice_prob.txt, rms.txt, pitch.txt: int16 waveforms aligned with source.pcm
+*   vad_N.pcm: the pcm of the Nth vad section
+* call SetFormat(VadDumpFormatCompact) before Open to write a single compressed and indexed dump.vdc instead,
+* which is suitable for long running dumps, ref to vad_dump_container.go
  */
 type VadDump struct {
 	mode       int    // 0: dump source; 1 dump source + far; 2 dump source + far + pitch;3 dump source + far + pitch + rms
 	path       string // dir path of the dump file, and the file name is path/vad/source_.pcm
 	count      int    // current count of the vad section dump file
-	sourceFile *os.File
-	vadFile    *os.File
-	labelFile  *os.File
 	isOpen     bool
 	frameCount int
-	// date: 2025-11-03, add voice prob, rms, pitch file for debug
-	voiceProbFile *os.File
-	rmsFile       *os.File
-	pitchFile     *os.File
-	// data for viceprob, rms, pitch file
-	itemData []byte
+	writer     *vadDumpWriter
+	format     VadDumpFormat
 }
 
+type VadDumpFormat int
+
+const (
+	VadDumpFormatRaw     VadDumpFormat = 0 // source.pcm, label.bin, waveform files and vad_N.pcm
+	VadDumpFormatCompact VadDumpFormat = 1 // dump.vdc: lossless compressed audio, columnar labels and a segment index
+)
+
 func NewVadDump(path string) *VadDump {
 	//check path is a dir or not, and is writable
 	if info, err := os.Stat(path); os.IsNotExist(err) || !info.IsDir() || !info.Mode().IsDir() {
@@ -346,184 +355,103 @@ func NewVadDump(path string) *VadDump {
 		}
 	}
 	ret := &VadDump{
-		mode:          1,
-		path:          vadPath,
-		count:         0, // count of the vad section dump file
-		sourceFile:    nil,
-		vadFile:       nil,
-		labelFile:     nil,
-		isOpen:        false,
-		frameCount:    0, // count of audio frame
-		voiceProbFile: nil,
-		rmsFile:       nil,
-		pitchFile:     nil,
-		// 960 bytes or 10ms is big enough for voice prob, rms, pitch data, i.e can support up to 48khz
-		itemData: nil,
+		mode:       1,
+		path:       vadPath,
+		count:      0, // count of the vad section dump file
+		isOpen:     false,
+		frameCount: 0, // count of audio frame
+		writer:     nil,
+		format:     VadDumpFormatRaw,
 	}
 	return ret
 }
 
-func (v *VadDump) newVadFile() *os.File {
-	var err error
-	v.vadFile, err = os.OpenFile(fmt.Sprintf("%s/vad_%d.pcm", v.path, v.count), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
-	if err != nil {
-		fmt.Println("Failed to create dump file: ", err)
-		return nil
-	}
-	return v.vadFile
-}
-func (v *VadDump) closeVadFile() int {
-	if v.vadFile != nil {
-		v.vadFile.Close()
-		v.vadFile = nil
-
-		return 0
+// SetFormat sets the dump format, it must be called before Open. return -1 if the dump is opened
+func (v *VadDump) SetFormat(format VadDumpFormat) int {
+	if v.isOpen {
+		return -1
 	}
-
-	return -1
+	v.format = format
+	return 0
 }
 
 func (v *VadDump) Open() int {
-
-	var err error
-
 	if v.isOpen {
 		return 1
 	}
 	v.isOpen = true
 	v.count = 0
 	v.frameCount = 0
-
-	// open source file
-	v.sourceFile, err = os.OpenFile(fmt.Sprintf("%s/source.pcm", v.path), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
-	if err != nil {
-		fmt.Println("Failed to create dump file: ", err)
-	}
-
-	//open label file
-	v.labelFile, err = os.OpenFile(fmt.Sprintf("%s/label.txt", v.path), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
-	if err != nil {
-		fmt.Println("Failed to create label file: ", err)
-	}
-	//open voice prob file
-	v.voiceProbFile, err = os.OpenFile(fmt.Sprintf("%s/voice_prob.txt", v.path), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
-	if err != nil {
-		fmt.Println("Failed to create voice prob file: ", err)
-	}
-	//open rms file
-	v.rmsFile, err = os.OpenFile(fmt.Sprintf("%s/rms.txt", v.path), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
-	if err != nil {
-		fmt.Println("Failed to create rms file: ", err)
-	}
-	//open pitch file
-	v.pitchFile, err = os.OpenFile(fmt.Sprintf("%s/pitch.txt", v.path), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
-	if err != nil {
-		fmt.Println("Failed to create pitch file: ", err)
-	}
+	v.writer = newVadDumpWriter(v.path, v.format)
 
 	return 0
 }
-func (v *VadDump) fillItemData(value int16, leninBytes int) {
-	if v.itemData == nil || len(v.itemData) < leninBytes {
-		v.itemData = make([]byte, leninBytes)
-	}
-	// chang byte to int16 ptr
-	int16Ptr := (*int16)(unsafe.Pointer(&v.itemData[0]))
-	count := leninBytes / 2
-	for i := 0; i < count; i++ {
-		elem := (*int16)(unsafe.Pointer(uintptr(unsafe.Pointer(int16Ptr)) + uintptr(i)*2))
-		*elem = int16(value)
-	}
-}
-func (v *VadDump) Write(frame *AudioFrame, vadFrame *AudioFrame, state VadState) int {
-	//len := len(frame.Buffer)
 
-	// write source
-	if v.sourceFile != nil {
-		if _, err := v.sourceFile.Write(frame.Buffer); err != nil {
-			fmt.Println("Failed to write dump file: ", err)
-		}
-	}
-	//write voice prob info: date: 2025-11-03, add voice prob info to file
-	if v.voiceProbFile != nil {
-		v.fillItemData(int16(frame.VoiceProb*127*127), len(frame.Buffer))
-		v.voiceProbFile.Write(v.itemData)
-	}
-	//write rms info
-	if v.rmsFile != nil {
-		v.fillItemData(int16(frame.Rms*127), len(frame.Buffer))
-		v.rmsFile.Write(v.itemData)
-	}
-	//write pitch info
-	if v.pitchFile != nil {
-		v.fillItemData(int16(frame.Pitch), len(frame.Buffer))
-		v.pitchFile.Write(v.itemData)
+// Write never blocks on the disk; it returns -1 if the frame is dropped because the dump ring is full.
+func (v *VadDump) Write(frame *AudioFrame, vadFrame *AudioFrame, state VadState) int {
+	if v.writer == nil || frame == nil {
+		return -1
 	}
 
-	// write label info
-	if v.labelFile != nil {
-		info := fmt.Sprintf("ct:%d fct:%d state:%d far:%d vop:%d rms:%d pitch:%d mup:%d\n", v.count, v.frameCount, state,
-			frame.FarFieldFlag, frame.VoiceProb, frame.Rms, frame.Pitch, frame.MusicProb)
-		v.labelFile.WriteString(info)
-
-		// increment frame count
-		v.frameCount++
-
+	label := VadDumpLabel{
+		FrameCount:   uint32(v.frameCount),
+		SectionCount: uint16(v.count),
+		State:        state,
+		FarFieldFlag: frame.FarFieldFlag,
+		VoiceProb:    frame.VoiceProb,
+		Rms:          frame.Rms,
+		Pitch:        frame.Pitch,
+		MusicProb:    frame.MusicProb,
 	}
+	v.frameCount++
 
 	//check vad state
+	var vadData []byte
+	vadState := VadStateInvalid
 	if vadFrame != nil {
-
 		if state == VadStateStartSpeeking {
-			//open a new vad file
-			v.vadFile = v.newVadFile()
-			// write current bytes to file
-			v.vadFile.Write(vadFrame.Buffer)
-			// and increment count
 			v.count++
-		} else if state == VadStateSpeeking {
-			// write current bytes to file
-			v.vadFile.Write(vadFrame.Buffer)
-
-		} else if state == VadStateStopSpeeking {
-			// close current vad file
-			v.closeVadFile()
 		}
+		// the compact format indexes the segments on source audio, vad pcm is not needed
+		if v.format == VadDumpFormatRaw {
+			vadState = state
+			if state == VadStateStartSpeeking || state == VadStateSpeeking {
+				vadData = vadFrame.Buffer
+			}
+		}
+	}
+
+	if !v.writer.push(&label, frame, vadData, vadState) {
+		return -1
 	}
 	return 0
 }
 
-func (v *VadDump) Close() int {
-
-	//close all file
-	if v.sourceFile != nil {
-		v.sourceFile.Close()
-	}
-	if v.vadFile != nil {
-		v.vadFile.Close()
+// DroppedFrames returns the number of frames dropped since Open because the dump ring was full.
+func (v *VadDump) DroppedFrames() uint64 {
+	if v.writer == nil {
+		return 0
 	}
-	if v.labelFile != nil {
-		v.labelFile.Close()
+	return atomic.LoadUint64(&v.writer.droppedFrames)
+}
 
+// DroppedBytes returns the pcm bytes(source + vad) of the dropped frames.
+func (v *VadDump) DroppedBytes() uint64 {
+	if v.writer == nil {
+		return 0
 	}
-	if v.voiceProbFile != nil {
-		v.voiceProbFile.Close()
-	}
-	if v.rmsFile != nil {
-		v.rmsFile.Close()
-	}
-	if v.pitchFile != nil {
-		v.pitchFile.Close()
-	}
+	return atomic.LoadUint64(&v.writer.droppedBytes)
+}
 
-	//assign to nil
-	v.sourceFile = nil
-	v.vadFile = nil
-	v.labelFile = nil
-	v.voiceProbFile = nil
-	v.rmsFile = nil
-	v.pitchFile = nil
-	v.itemData = nil
+// Close flushes all pending frames and closes the dump files.
+func (v *VadDump) Close() int {
+	if v.writer != nil {
+		if dropped := v.DroppedFrames(); dropped > 0 {
+			fmt.Printf("VadDump %s dropped %d frames, %d bytes\n", v.path, dropped, v.DroppedBytes())
+		}
+		v.writer.close()
+		v.writer = nil
+	}
 	v.isOpen = false
 	v.frameCount = 0
 	v.count = 0
@@ -566,6 +494,8 @@ func (q *Queue) Enqueue(item interface{}) {
 	q.mutex.Lock()
 	q.items = append(q.items, item)
 	q.mutex.Unlock()
+	metrics.queueEnqueued.Inc()
+	metrics.queueDepth.Add(1)
 
 	//q.items = append(q.items, item)
 	// notify the dequeue routine: non-blocking mode
@@ -602,6 +532,8 @@ func (q *Queue) Dequeue() interface{} {
 	if size > 0 {
 		item := q.items[0]
 		q.items = q.items[1:]
+		metrics.queueDequeued.Inc()
+		metrics.queueDepth.Add(-1)
 		return item
 	}
 	return nil
@@ -640,6 +572,7 @@ func (q *Queue) Clear() {
 	q.mutex.Lock()
 	defer q.mutex.Unlock()
 
+	metrics.queueDepth.Add(-int64(len(q.items)))
 	q.items = make([]interface{}, 0)
 }
 
@@ -703,12 +636,14 @@ func (pt *PrecisionTimer) Stop() {
 type IdleItem struct {
 	Handle    unsafe.Pointer
 	LifeCycle int // in ms
+	Expiry    time.Time
 }
 
 func newIdleItem(handle unsafe.Pointer, lifeCycle int) *IdleItem {
 	return &IdleItem{
 		Handle:    handle,
 		LifeCycle: lifeCycle,
+		Expiry:    time.Now().Add(time.Duration(lifeCycle) * time.Millisecond),
 	}
 }
 
@@ -751,6 +686,7 @@ func (rb *LockFreeRingBuffer) TryWrite(frame *AudioFrame) bool {
 
 	// use bitwise operation instead of modulo (performance提升 3-5 倍)
 	if (w+1)&rb.mask == r&rb.mask {
+		metrics.ringBufferDropped.Inc()
 		return false // full
 	}
 
@@ -759,6 +695,7 @@ func (rb *LockFreeRingBuffer) TryWrite(frame *AudioFrame) bool {
 
 	// Release semantic ensure write visibility
 	atomic.StoreUint64(&rb.writePos, w+1)
+	metrics.ringBufferWritten.Inc()
 	return true
 }
 
@@ -785,6 +722,7 @@ func (rb *LockFreeRingBuffer) TryRead() (*AudioFrame, bool) {
 
 	frame := rb.buffer[r&rb.mask]
 	atomic.StoreUint64(&rb.readPos, r+1)
+	metrics.ringBufferRead.Inc()
 	return frame, true
 }
 
@@ -64,6 +64,11 @@ const (
 	VadStateSpeeking VadState = 2
 	// VadStateStopSpeeking represents the state when speaking stops.
 	VadStateStopSpeeking VadState = 3
+	// VadStateMaybeSpeaking represents speculative speech, only in AudioVadV2 streaming mode.
+	// it is followed by VadStateStartSpeeking if confirmed, or VadStateRetractSpeaking if not.
+	VadStateMaybeSpeaking VadState = 4
+	// VadStateRetractSpeaking represents that the speculative speech was not confirmed and should be discarded.
+	VadStateRetractSpeaking VadState = 5
 )
 
 // AudioTrackMixingState represents the audio track mixing state.
@@ -16,6 +16,7 @@ import (
 
 //export goOnRecordAudioFrame
 func goOnRecordAudioFrame(cLocalUser unsafe.Pointer, channelId *C.char, frame *C.struct__audio_frame) C.int {
+	defer endCallback(beginCallback(CallbackOnRecordAudioFrame))
 	//validity check
 	if cLocalUser == nil {
 		return C.int(0)
@@ -36,6 +37,7 @@ func goOnRecordAudioFrame(cLocalUser unsafe.Pointer, channelId *C.char, frame *C
 
 //export goOnPlaybackAudioFrame
 func goOnPlaybackAudioFrame(cLocalUser unsafe.Pointer, channelId *C.char, frame *C.struct__audio_frame) C.int {
+	defer endCallback(beginCallback(CallbackOnPlaybackAudioFrame))
 	//validity check
 	if cLocalUser == nil {
 		return C.int(0)
@@ -57,6 +59,7 @@ func goOnPlaybackAudioFrame(cLocalUser unsafe.Pointer, channelId *C.char, frame
 
 //export goOnMixedAudioFrame
 func goOnMixedAudioFrame(cLocalUser unsafe.Pointer, channelId *C.char, frame *C.struct__audio_frame) C.int {
+	defer endCallback(beginCallback(CallbackOnMixedAudioFrame))
 	//validity check
 	if cLocalUser == nil {
 		return C.int(0)
@@ -78,6 +81,7 @@ func goOnMixedAudioFrame(cLocalUser unsafe.Pointer, channelId *C.char, frame *C.
 
 //export goOnEarMonitoringAudioFrame
 func goOnEarMonitoringAudioFrame(cLocalUser unsafe.Pointer, frame *C.struct__audio_frame) C.int {
+	defer endCallback(beginCallback(CallbackOnEarMonitoringAudioFrame))
 	//validity check
 	if cLocalUser == nil {
 		return C.int(0)
@@ -98,13 +102,18 @@ func goOnEarMonitoringAudioFrame(cLocalUser unsafe.Pointer, frame *C.struct__aud
 
 //export goOnPlaybackAudioFrameBeforeMixing
 func goOnPlaybackAudioFrameBeforeMixing(cLocalUser unsafe.Pointer, channelId *C.char, uid *C.char, frame *C.struct__audio_frame) C.int {
+	defer endCallback(beginCallback(CallbackOnPlaybackAudioFrameBeforeMixing))
 	//validity check
 	if cLocalUser == nil {
 		return C.int(0)
 	}
 	// get conn from handle
 	con := agoraService.getConFromHandle(cLocalUser, ConTypeCLocalUser)
-	if con == nil || con.audioObserver == nil || con.audioObserver.OnPlaybackAudioFrameBeforeMixing == nil {
+	if con == nil {
+		return C.int(0)
+	}
+	con.metrics.audioFramesReceived.Inc()
+	if con.audioObserver == nil || con.audioObserver.OnPlaybackAudioFrameBeforeMixing == nil {
 		return C.int(0)
 	}
 	goChannelId := C.GoString(channelId)
@@ -128,6 +137,7 @@ func goOnPlaybackAudioFrameBeforeMixing(cLocalUser unsafe.Pointer, channelId *C.
 
 //export goOnGetAudioFramePosition
 func goOnGetAudioFramePosition(cLocalUser unsafe.Pointer) C.int {
+	defer endCallback(beginCallback(CallbackOnGetAudioFramePosition))
 	//validity check
 	if cLocalUser == nil {
 		return C.int(0)
@@ -143,6 +153,7 @@ func goOnGetAudioFramePosition(cLocalUser unsafe.Pointer) C.int {
 
 //export goOnGetPlaybackAudioFrameParam
 func goOnGetPlaybackAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_params {
+	defer endCallback(beginCallback(CallbackOnGetPlaybackAudioFrameParam))
 	cAudioParam := C.struct__audio_params{}
 	C.memset(unsafe.Pointer(&cAudioParam), 0, C.sizeof_struct__audio_params)
 
@@ -166,6 +177,7 @@ func goOnGetPlaybackAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_p
 
 //export goOnGetRecordAudioFrameParam
 func goOnGetRecordAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_params {
+	defer endCallback(beginCallback(CallbackOnGetRecordAudioFrameParam))
 
 	cAudioParam := C.struct__audio_params{}
 	C.memset(unsafe.Pointer(&cAudioParam), 0, C.sizeof_struct__audio_params)
@@ -189,6 +201,7 @@ func goOnGetRecordAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_par
 
 //export goOnGetMixedAudioFrameParam
 func goOnGetMixedAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_params {
+	defer endCallback(beginCallback(CallbackOnGetMixedAudioFrameParam))
 
 	cAudioParam := C.struct__audio_params{}
 	C.memset(unsafe.Pointer(&cAudioParam), 0, C.sizeof_struct__audio_params)
@@ -212,6 +225,7 @@ func goOnGetMixedAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_para
 
 //export goOnGetEarMonitoringAudioFrameParam
 func goOnGetEarMonitoringAudioFrameParam(cLocalUser unsafe.Pointer) C.struct__audio_params {
+	defer endCallback(beginCallback(CallbackOnGetEarMonitoringAudioFrameParam))
 	cAudioParam := C.struct__audio_params{}
 	C.memset(unsafe.Pointer(&cAudioParam), 0, C.sizeof_struct__audio_params)
 
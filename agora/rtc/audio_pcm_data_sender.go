@@ -70,6 +70,12 @@ func (sender *AudioPcmDataSender) Release() {
 }
 
 func (sender *AudioPcmDataSender) SendAudioPcmData(frame *AudioFrame) int {
+	ret := sender.sendAudioPcmData(frame)
+	observePcmSend(ret)
+	return ret
+}
+
+func (sender *AudioPcmDataSender) sendAudioPcmData(frame *AudioFrame) int {
 	if sender.closed || sender.cSender == nil || frame == nil {
 		return -1
 	}
@@ -17,6 +17,11 @@ type AudioVadConfigV2 struct {
 	StopRms                int     // stop rms, default value is -50
 	EnableAdaptiveRmsThreshold bool    // enable adaptive threshold, default value is false
 	AdaptiveRmsThresholdFactor float32 // default to : 0.67.i.e 2/3
+	// streaming mode: if > 0 and less than StartRecognizeCount, after this count of active frames the buffered audio is
+	// returned with VadStateMaybeSpeaking, and every following frame too, until the speech is confirmed(VadStateStartSpeeking,
+	// with the current frame only, as the earlier audio was already returned) or not(VadStateRetractSpeaking).
+	// default value is 0, i.e disabled
+	StreamingLookaheadCount int
 }
 
 type VadFrame struct {
@@ -45,6 +50,8 @@ type AudioVadV2 struct {
 	silenceCount int
 	totalVoiceRms  int // range from 0 to 127, respond to db: -127db, to 0db
 	refAvgRmsInLastSesseion   int // range from 0 to 127, respond to db: -127db, to 0db
+	isSpeculating bool // streaming mode: VadStateMaybeSpeaking has been returned, and not yet confirmed or retracted
+	lastState     VadState // the state returned by the last Process, for the transition metrics
 }
 
 func newVadFrame(frame *AudioFrame, isActive bool) *VadFrame {
@@ -95,22 +102,35 @@ func (buf *VadBuffer) getActivePercent(lastN int) float32 {
 }
 
 func (buf *VadBuffer) flushAudio() *AudioFrame {
+	ret := buf.peekAudio(buf.queue.Len())
+	buf.queue.Init()
+	return ret
+}
+
+// peekAudio returns the audio of the last N frames in one frame, and keeps them in the buffer
+func (buf *VadBuffer) peekAudio(lastN int) *AudioFrame {
 	l := buf.queue
-	if l.Len() == 0 {
+	if l.Len() == 0 || lastN <= 0 {
 		return nil
 	}
+	if lastN > l.Len() {
+		lastN = l.Len()
+	}
+	first := l.Back()
+	for i := 1; i < lastN; i++ {
+		first = first.Prev()
+	}
 	// copy a frame
 	samplesCount := 0
-	ret := *(l.Front().Value.(*VadFrame).frame)
-	data := make([]byte, 0, l.Len()*ret.SamplesPerChannel*ret.BytesPerSample*ret.Channels)
-	for e := l.Front(); e != nil; e = e.Next() {
+	ret := *(first.Value.(*VadFrame).frame)
+	data := make([]byte, 0, lastN*ret.SamplesPerChannel*ret.BytesPerSample*ret.Channels)
+	for e := first; e != nil; e = e.Next() {
 		v := e.Value.(*VadFrame)
 		data = append(data, v.frame.Buffer...)
 		samplesCount += v.frame.SamplesPerChannel
 	}
 	ret.Buffer = data
 	ret.SamplesPerChannel = samplesCount
-	l.Init()
 	return &ret
 }
 
@@ -159,6 +179,7 @@ func NewAudioVadV2(cfg *AudioVadConfigV2) *AudioVadV2 {
 }
 
 func (vad *AudioVadV2) Release() {
+	vad.isSpeculating = false
 	vad.startBuffer.clear()
 	vad.stopBuffer.clear()
 	vad.startBuffer = nil
@@ -192,6 +213,15 @@ func (vad *AudioVadV2) getRefActiveAvgRms() int {
 }
 
 func (vad *AudioVadV2) Process(frame *AudioFrame) (*AudioFrame, VadState) {
+	out, state := vad.process(frame)
+	if state != vad.lastState {
+		observeVadTransition(vad.lastState, state)
+		vad.lastState = state
+	}
+	return out, state
+}
+
+func (vad *AudioVadV2) process(frame *AudioFrame) (*AudioFrame, VadState) {
 	if vad.expectFormat == nil {
 		vad.expectFormat = &VadFrameFormat{
 			BytesPerSample: frame.BytesPerSample,
@@ -220,6 +250,11 @@ func (vad *AudioVadV2) Process(frame *AudioFrame) (*AudioFrame, VadState) {
 		} else {
 			vad.voiceCount = 0
 			vad.totalVoiceRms = 0
+			if vad.isSpeculating {
+				// the speculative speech was not confirmed
+				vad.isSpeculating = false
+				return nil, VadStateRetractSpeaking
+			}
 		}
 		// todo： 是否需要根据N个isActive来计算avg rms? 而不是开始的时候，直接计算avg rms?
 		// fmt.Printf("[vad] isSpeaking: false, startBuffer: %d\n", vad.startBuffer.queue.Len())
@@ -229,7 +264,15 @@ func (vad *AudioVadV2) Process(frame *AudioFrame) (*AudioFrame, VadState) {
 			if vad.voiceCount >= vad.config.StartRecognizeCount {
 				vad.isSpeaking = true
 				vad.stopBuffer.clear()
-				ret := vad.startBuffer.flushAudio()
+				var ret *AudioFrame
+				if vad.isSpeculating {
+					// the buffered audio was already returned with VadStateMaybeSpeaking
+					vad.isSpeculating = false
+					vad.startBuffer.clear()
+					ret = frame
+				} else {
+					ret = vad.startBuffer.flushAudio()
+				}
 
 				// update ref rms
 				vad.refAvgRmsInLastSesseion = vad.totalVoiceRms / vad.voiceCount
@@ -244,6 +287,14 @@ func (vad *AudioVadV2) Process(frame *AudioFrame) (*AudioFrame, VadState) {
 				return ret, VadStateStartSpeeking
 			}
 		}
+		if vad.isSpeculating {
+			return frame, VadStateMaybeSpeaking
+		}
+		if lookahead := vad.config.StreamingLookaheadCount; lookahead > 0 && lookahead < vad.config.StartRecognizeCount && vad.voiceCount >= lookahead {
+			// return the same pre-roll as StartSpeeking does, i.e PreStartRecognizeCount frames before the active frames
+			vad.isSpeculating = true
+			return vad.startBuffer.peekAudio(vad.config.PreStartRecognizeCount + vad.voiceCount), VadStateMaybeSpeaking
+		}
 		return nil, VadStateNoSpeeking
 	} else {
 		full := vad.stopBuffer.pushBack(vadFrame)
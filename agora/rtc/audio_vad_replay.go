@@ -0,0 +1,361 @@
+package agoraservice
+
+import (
+	"bufio"
+	"fmt"
+	"os"
+	"runtime"
+	"sort"
+	"time"
+)
+
+/*
+* VadReplay feeds the artifacts written by VadDump (source.pcm + label.bin) back
+* through AudioVadV2 or AudioVad as fast as possible, without joining a channel.
+* it's used to tune AudioVadConfigV2 offline and to catch performance regressions.
+* usage:
+* frames, err := LoadVadDump("./dump/20251103120000", 16000, 1)
+* stats := ReplayVadV2(frames, cfg)
+* fmt.Println(stats)
+ */
+
+// VadReplayFrame is one 10ms frame read back from a vad dump directory.
+type VadReplayFrame struct {
+	Frame    *AudioFrame // pcm and audio label(far, vop, rms, pitch, mup) of the frame
+	RefState VadState    // the vad state recorded in the label file when the dump was taken
+}
+
+// VadReplayLatency summarizes the decision latency of one transition kind, in ms.
+// a positive value means the replayed vad decided later than the reference.
+type VadReplayLatency struct {
+	Matched  int // reference transitions matched by a replayed transition
+	Missed   int // reference transitions without a replayed transition in the match window
+	Spurious int // replayed transitions without a reference transition
+	MeanMs   float64
+	P50Ms    int
+	P95Ms    int
+	MaxMs    int
+}
+
+// VadReplayStats is the result of one replay run.
+type VadReplayStats struct {
+	Name            string
+	Frames          int
+	Elapsed         time.Duration
+	FramesPerSecond float64
+	RealtimeFactor  float64 // audio duration / processing time
+	NsPerFrame      float64
+	AllocsPerFrame  float64
+	BytesPerFrame   float64
+	Start           VadReplayLatency
+	Stop            VadReplayLatency
+	Speculative     int        // speculative sections(VadStateMaybeSpeaking), only in AudioVadV2 streaming mode
+	Retracted       int        // speculative sections that were retracted
+	States          []VadState // replayed state for each frame
+}
+
+// max distance(in frames) between a reference and a replayed transition to be matched: 3s
+const vadReplayMatchWindow = 300
+
+// LoadVadDump loads source.pcm and label.bin from a directory created by VadDump.
+// dumps taken before label.bin was introduced are read from label.txt.
+// a compact dump(dump.vdc) is fully loaded, use OpenVadDumpContainer to load a single segment.
+// sampleRate and channels describe the pcm in source.pcm; they are only used when
+// the frame size can not be derived from the label file.
+func LoadVadDump(dir string, sampleRate int, channels int) ([]*VadReplayFrame, error) {
+	if _, err := os.Stat(fmt.Sprintf("%s/%s", dir, vadDumpContainerName)); err == nil {
+		return loadVadDumpContainer(fmt.Sprintf("%s/%s", dir, vadDumpContainerName))
+	}
+	pcm, err := os.ReadFile(fmt.Sprintf("%s/source.pcm", dir))
+	if err != nil {
+		return nil, fmt.Errorf("failed to read source.pcm, %w", err)
+	}
+	labels, err := loadVadDumpBinLabels(fmt.Sprintf("%s/label.bin", dir))
+	if err != nil {
+		return nil, err
+	}
+	if labels == nil {
+		labels, err = loadVadDumpLabels(fmt.Sprintf("%s/label.txt", dir))
+		if err != nil {
+			return nil, err
+		}
+	}
+
+	bytesPerFrame := (sampleRate / 100) * channels * 2
+	if len(labels) > 0 {
+		if len(pcm)%len(labels) != 0 {
+			return nil, fmt.Errorf("source.pcm size %d is not a multiple of %d labels", len(pcm), len(labels))
+		}
+		bytesPerFrame = len(pcm) / len(labels)
+	}
+	if bytesPerFrame <= 0 {
+		return nil, fmt.Errorf("invalid frame size, sampleRate: %d, channels: %d", sampleRate, channels)
+	}
+
+	count := len(pcm) / bytesPerFrame
+	frames := make([]*VadReplayFrame, 0, count)
+	for i := 0; i < count; i++ {
+		frame := &AudioFrame{
+			Type:              AudioFrameTypePCM16,
+			SamplesPerChannel: bytesPerFrame / 2 / channels,
+			BytesPerSample:    2,
+			Channels:          channels,
+			SamplesPerSec:     sampleRate,
+			Buffer:            pcm[i*bytesPerFrame : (i+1)*bytesPerFrame],
+			RenderTimeMs:      int64(i * 10),
+			FarFieldFlag:      1,
+		}
+		refState := VadStateInvalid
+		if i < len(labels) {
+			label := labels[i]
+			frame.FarFieldFlag = label.far
+			frame.VoiceProb = label.vop
+			frame.Rms = label.rms
+			frame.Pitch = label.pitch
+			frame.MusicProb = label.mup
+			refState = VadState(label.state)
+		}
+		frames = append(frames, &VadReplayFrame{Frame: frame, RefState: refState})
+	}
+	return frames, nil
+}
+
+func loadVadDumpContainer(path string) ([]*VadReplayFrame, error) {
+	c, err := OpenVadDumpContainer(path)
+	if err != nil {
+		return nil, err
+	}
+	defer c.Close()
+	return c.ReadFrames(0, c.Frames())
+}
+
+type vadDumpLabel struct {
+	state, far, vop, rms, pitch, mup int
+}
+
+func loadVadDumpBinLabels(path string) ([]vadDumpLabel, error) {
+	data, err := os.ReadFile(path)
+	if os.IsNotExist(err) {
+		return nil, nil
+	}
+	if err != nil {
+		return nil, fmt.Errorf("failed to read label file, %w", err)
+	}
+	if len(data)%VadDumpLabelRecordSize != 0 {
+		return nil, fmt.Errorf("label.bin size %d is not a multiple of %d", len(data), VadDumpLabelRecordSize)
+	}
+
+	labels := make([]vadDumpLabel, 0, len(data)/VadDumpLabelRecordSize)
+	for off := 0; off < len(data); off += VadDumpLabelRecordSize {
+		l := DecodeVadDumpLabel(data[off : off+VadDumpLabelRecordSize])
+		labels = append(labels, vadDumpLabel{
+			state: int(l.State),
+			far:   l.FarFieldFlag,
+			vop:   l.VoiceProb,
+			rms:   l.Rms,
+			pitch: l.Pitch,
+			mup:   l.MusicProb,
+		})
+	}
+	return labels, nil
+}
+
+func loadVadDumpLabels(path string) ([]vadDumpLabel, error) {
+	file, err := os.Open(path)
+	if os.IsNotExist(err) {
+		// label file is optional, replay can still run on pcm only
+		return nil, nil
+	}
+	if err != nil {
+		return nil, fmt.Errorf("failed to open label file, %w", err)
+	}
+	defer file.Close()
+
+	labels := make([]vadDumpLabel, 0, 1024)
+	scanner := bufio.NewScanner(file)
+	line := 0
+	for scanner.Scan() {
+		line++
+		var ct, fct int
+		var l vadDumpLabel
+		_, err := fmt.Sscanf(scanner.Text(), "ct:%d fct:%d state:%d far:%d vop:%d rms:%d pitch:%d mup:%d",
+			&ct, &fct, &l.state, &l.far, &l.vop, &l.rms, &l.pitch, &l.mup)
+		if err != nil {
+			return nil, fmt.Errorf("invalid label at line %d, %w", line, err)
+		}
+		labels = append(labels, l)
+	}
+	if err := scanner.Err(); err != nil {
+		return nil, fmt.Errorf("failed to read label file, %w", err)
+	}
+	return labels, nil
+}
+
+// ReplayVadV2 runs all frames through a fresh AudioVadV2 created from cfg.
+// cfg is copied, so the same config can be used for several runs.
+func ReplayVadV2(frames []*VadReplayFrame, cfg *AudioVadConfigV2) *VadReplayStats {
+	var vadCfg *AudioVadConfigV2
+	if cfg != nil {
+		copied := *cfg
+		vadCfg = &copied
+	}
+	vad := NewAudioVadV2(vadCfg)
+	defer vad.Release()
+
+	return runVadReplay("AudioVadV2", frames, func(frame *AudioFrame) VadState {
+		_, state := vad.Process(frame)
+		return state
+	})
+}
+
+// ReplayVad runs all frames through a fresh AudioVad created from cfg.
+// AudioVad only accepts 16KHz mono pcm.
+func ReplayVad(frames []*VadReplayFrame, cfg *AudioVadConfig) (*VadReplayStats, error) {
+	vad := NewAudioVad(cfg)
+	if vad == nil {
+		return nil, fmt.Errorf("failed to create AudioVad")
+	}
+	defer vad.Release()
+
+	if len(frames) > 0 {
+		f := frames[0].Frame
+		if f.SamplesPerSec != 16000 || f.Channels != 1 {
+			return nil, fmt.Errorf("AudioVad only supports 16KHz mono pcm, got %dHz %d channels", f.SamplesPerSec, f.Channels)
+		}
+	}
+
+	return runVadReplay("AudioVad", frames, func(frame *AudioFrame) VadState {
+		_, state := vad.ProcessPcmFrame(frame)
+		return VadState(state)
+	}), nil
+}
+
+func runVadReplay(name string, frames []*VadReplayFrame, process func(frame *AudioFrame) VadState) *VadReplayStats {
+	stats := &VadReplayStats{
+		Name:   name,
+		Frames: len(frames),
+		States: make([]VadState, len(frames)),
+	}
+	if len(frames) == 0 {
+		return stats
+	}
+
+	var before, after runtime.MemStats
+	runtime.GC()
+	runtime.ReadMemStats(&before)
+	start := time.Now()
+	for i, f := range frames {
+		stats.States[i] = process(f.Frame)
+	}
+	stats.Elapsed = time.Since(start)
+	runtime.ReadMemStats(&after)
+
+	n := float64(len(frames))
+	seconds := stats.Elapsed.Seconds()
+	if seconds > 0 {
+		stats.FramesPerSecond = n / seconds
+		stats.RealtimeFactor = (n * 0.01) / seconds
+	}
+	stats.NsPerFrame = float64(stats.Elapsed.Nanoseconds()) / n
+	stats.AllocsPerFrame = float64(after.Mallocs-before.Mallocs) / n
+	stats.BytesPerFrame = float64(after.TotalAlloc-before.TotalAlloc) / n
+
+	refStates := make([]VadState, len(frames))
+	for i, f := range frames {
+		refStates[i] = f.RefState
+	}
+	for i, state := range stats.States {
+		if state == VadStateMaybeSpeaking && (i == 0 || stats.States[i-1] != VadStateMaybeSpeaking) {
+			stats.Speculative++
+		} else if state == VadStateRetractSpeaking {
+			stats.Retracted++
+		}
+	}
+	refStarts, refStops := vadTransitions(refStates)
+	gotStarts, gotStops := vadTransitions(stats.States)
+	stats.Start = matchVadTransitions(refStarts, gotStarts)
+	stats.Stop = matchVadTransitions(refStops, gotStops)
+	return stats
+}
+
+// vadTransitions returns the frame indexes of start and stop decisions.
+func vadTransitions(states []VadState) ([]int, []int) {
+	starts := make([]int, 0, 16)
+	stops := make([]int, 0, 16)
+	for i, state := range states {
+		switch state {
+		case VadStateStartSpeeking:
+			starts = append(starts, i)
+		case VadStateStopSpeeking:
+			stops = append(stops, i)
+		}
+	}
+	return starts, stops
+}
+
+// matchVadTransitions pairs every reference transition with the closest unmatched
+// replayed transition inside vadReplayMatchWindow.
+func matchVadTransitions(ref []int, got []int) VadReplayLatency {
+	ret := VadReplayLatency{}
+	used := make([]bool, len(got))
+	latencies := make([]int, 0, len(ref))
+	for _, r := range ref {
+		best := -1
+		for j, g := range got {
+			if used[j] {
+				continue
+			}
+			diff := g - r
+			if diff < -vadReplayMatchWindow || diff > vadReplayMatchWindow {
+				continue
+			}
+			if best < 0 || absInt(diff) < absInt(got[best]-r) {
+				best = j
+			}
+		}
+		if best < 0 {
+			ret.Missed++
+			continue
+		}
+		used[best] = true
+		latencies = append(latencies, (got[best]-r)*10)
+	}
+	for _, u := range used {
+		if !u {
+			ret.Spurious++
+		}
+	}
+
+	ret.Matched = len(latencies)
+	if ret.Matched == 0 {
+		return ret
+	}
+	sum := 0
+	for _, l := range latencies {
+		sum += l
+	}
+	sort.Ints(latencies)
+	ret.MeanMs = float64(sum) / float64(ret.Matched)
+	ret.P50Ms = latencies[ret.Matched/2]
+	ret.P95Ms = latencies[(ret.Matched*95)/100]
+	ret.MaxMs = latencies[ret.Matched-1]
+	return ret
+}
+
+func absInt(v int) int {
+	if v < 0 {
+		return -v
+	}
+	return v
+}
+
+func (s *VadReplayStats) String() string {
+	return fmt.Sprintf("[%s] frames: %d, elapsed: %v, fps: %.0f, realtime: %.1fx, ns/frame: %.0f, allocs/frame: %.2f, bytes/frame: %.0f\n"+
+		"  start: matched %d, missed %d, spurious %d, latency mean %.1fms p50 %dms p95 %dms max %dms\n"+
+		"  stop:  matched %d, missed %d, spurious %d, latency mean %.1fms p50 %dms p95 %dms max %dms\n"+
+		"  speculative: %d, retracted: %d",
+		s.Name, s.Frames, s.Elapsed, s.FramesPerSecond, s.RealtimeFactor, s.NsPerFrame, s.AllocsPerFrame, s.BytesPerFrame,
+		s.Start.Matched, s.Start.Missed, s.Start.Spurious, s.Start.MeanMs, s.Start.P50Ms, s.Start.P95Ms, s.Start.MaxMs,
+		s.Stop.Matched, s.Stop.Missed, s.Stop.Spurious, s.Stop.MeanMs, s.Stop.P50Ms, s.Stop.P95Ms, s.Stop.MaxMs,
+		s.Speculative, s.Retracted)
+}
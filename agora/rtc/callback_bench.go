@@ -0,0 +1,69 @@
+package agoraservice
+
+/*
+#include <stdint.h>
+#include "callback_bench_cgo.h"
+*/
+import "C"
+import (
+	"fmt"
+	"sync/atomic"
+)
+
+// CallbackCostBench is the cost of a call from c into an exported go function, the way the sdk calls the
+// observers. NsPerCall is the wall time, CpuNsPerCall the cpu time of the calling threads, which doesn't
+// include the time a thread waits for the cpu when there are more threads than cores.
+type CallbackCostBench struct {
+	Name         string
+	Threads      int
+	Calls        int
+	NsPerCall    float64
+	CpuNsPerCall float64
+}
+
+func (b *CallbackCostBench) String() string {
+	return fmt.Sprintf("[%s] threads: %d, calls: %d, ns/call: %.0f, cpu ns/call: %.0f", b.Name, b.Threads, b.Calls,
+		b.NsPerCall, b.CpuNsPerCall)
+}
+
+func newCallbackCostBench(name string, threads int, calls int, t C.cgo_bench_time) *CallbackCostBench {
+	return &CallbackCostBench{
+		Name:         name,
+		Threads:      threads,
+		Calls:        calls,
+		NsPerCall:    float64(t.wall_ns) / float64(calls),
+		CpuNsPerCall: float64(t.cpu_ns) / float64(calls),
+	}
+}
+
+var benchCallbacks atomic.Uint64
+
+//export goBenchCallback
+func goBenchCallback() {
+	benchCallbacks.Add(1)
+}
+
+// BenchCallbackCost calls an empty exported go function calls times from each of threads c threads, with:
+// "c thread, first call": the first call of a thread, which attaches it to the go runtime(needm). before
+// go1.21 every call of a thread created by the sdk paid it, and detached the thread after(dropm).
+// "c thread, bound": the other calls, the runtime keeps the thread bound to its m until the thread exits,
+// which is what the sdk threads pay per callback.
+// "go thread": calls from a thread of the go runtime, i.e the per item cost of a dispatcher which would hand
+// the callbacks to threads created by go, without its queue.
+// all of them are measured with the same clocks, compare the cpu times of the bound calls and of the go thread.
+func BenchCallbackCost(threads int, calls int) ([]*CallbackCostBench, error) {
+	if threads <= 0 || calls <= 1 {
+		return nil, fmt.Errorf("invalid threads %d or calls %d", threads, calls)
+	}
+	var first, rest, goThread C.cgo_bench_time
+	if ret := C.cgo_bench_callbacks_c_threads(C.int(threads), C.int(calls), &first, &rest); ret != 0 {
+		return nil, fmt.Errorf("failed to create the c threads, error %d", int(ret))
+	}
+	C.cgo_bench_callbacks_go_thread(C.int(calls), &goThread)
+
+	return []*CallbackCostBench{
+		newCallbackCostBench("c thread, first call", threads, threads, first),
+		newCallbackCostBench("c thread, bound", threads, threads*(calls-1), rest),
+		newCallbackCostBench("go thread", 1, calls, goThread),
+	}, nil
+}
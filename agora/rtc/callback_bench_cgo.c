@@ -0,0 +1,114 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include "callback_bench_cgo.h"
+
+extern void goBenchCallback(void);
+
+static inline int64_t clock_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// starts t, see stop
+static inline void start(cgo_bench_time* t) {
+  t->wall_ns -= clock_ns(CLOCK_MONOTONIC);
+  t->cpu_ns -= clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// adds the wall and the cpu time since start to t
+static inline void stop(cgo_bench_time* t) {
+  t->cpu_ns += clock_ns(CLOCK_THREAD_CPUTIME_ID);
+  t->wall_ns += clock_ns(CLOCK_MONOTONIC);
+}
+
+// the first calls are serialized, so each measures the attach alone, then the threads wait for each other
+// and make the other calls together. pthread barriers aren't on darwin.
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int threads;
+  int attached;
+} bench_group;
+
+typedef struct {
+  bench_group* group;
+  int calls;
+  cgo_bench_time first;
+  cgo_bench_time rest;
+} bench_thread;
+
+static void* bench_thread_run(void* arg) {
+  bench_thread* t = (bench_thread*)arg;
+  bench_group* g = t->group;
+
+  pthread_mutex_lock(&g->lock);
+  start(&t->first);
+  goBenchCallback();
+  stop(&t->first);
+  g->attached++;
+  pthread_cond_broadcast(&g->cond);
+  while (g->attached < g->threads) {
+    pthread_cond_wait(&g->cond, &g->lock);
+  }
+  pthread_mutex_unlock(&g->lock);
+
+  // the wall time includes the time the thread waits for the cpu while the others run, the cpu time doesn't
+  start(&t->rest);
+  for (int i = 1; i < t->calls; i++) {
+    goBenchCallback();
+  }
+  stop(&t->rest);
+  return NULL;
+}
+
+int cgo_bench_callbacks_c_threads(int threads, int calls, cgo_bench_time* first, cgo_bench_time* rest) {
+  *first = (cgo_bench_time){0, 0};
+  *rest = (cgo_bench_time){0, 0};
+  bench_group group;
+  pthread_mutex_init(&group.lock, NULL);
+  pthread_cond_init(&group.cond, NULL);
+  group.threads = threads;
+  group.attached = 0;
+  pthread_t* ids = (pthread_t*)calloc(threads, sizeof(pthread_t));
+  bench_thread* args = (bench_thread*)calloc(threads, sizeof(bench_thread));
+  int ret = 0;
+  int started = 0;
+  for (; started < threads; started++) {
+    args[started].group = &group;
+    args[started].calls = calls;
+    ret = pthread_create(&ids[started], NULL, bench_thread_run, &args[started]);
+    if (ret != 0) {
+      break;
+    }
+  }
+  if (started < threads) {
+    // release the started threads
+    pthread_mutex_lock(&group.lock);
+    group.threads = started;
+    pthread_cond_broadcast(&group.cond);
+    pthread_mutex_unlock(&group.lock);
+  }
+  for (int i = 0; i < started; i++) {
+    pthread_join(ids[i], NULL);
+    first->wall_ns += args[i].first.wall_ns;
+    first->cpu_ns += args[i].first.cpu_ns;
+    rest->wall_ns += args[i].rest.wall_ns;
+    rest->cpu_ns += args[i].rest.cpu_ns;
+  }
+  free(args);
+  free(ids);
+  pthread_cond_destroy(&group.cond);
+  pthread_mutex_destroy(&group.lock);
+  return ret;
+}
+
+void cgo_bench_callbacks_go_thread(int calls, cgo_bench_time* t) {
+  *t = (cgo_bench_time){0, 0};
+  start(t);
+  for (int i = 0; i < calls; i++) {
+    goBenchCallback();
+  }
+  stop(t);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+// the wall and the cpu time of calls, both from the clocks of the calling threads(CLOCK_MONOTONIC and
+// CLOCK_THREAD_CPUTIME_ID).
+typedef struct {
+  int64_t wall_ns;
+  int64_t cpu_ns;
+} cgo_bench_time;
+
+// calls goBenchCallback calls times from each of threads new c threads, the first calls one at a time, then
+// the others together like the threads of the sdk. first is the sum of the first calls, which attach the
+// threads to the go runtime, rest the sum of the other calls.
+// returns 0, or the error of pthread_create.
+extern int cgo_bench_callbacks_c_threads(int threads, int calls, cgo_bench_time* first, cgo_bench_time* rest);
+
+// calls goBenchCallback calls times from the calling thread, which is a thread of the go runtime.
+extern void cgo_bench_callbacks_go_thread(int calls, cgo_bench_time* t);
@@ -0,0 +1,377 @@
+package agoraservice
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+/*
+* the callback watchdog reports the cgo callbacks which run longer than a threshold, e.g. a user
+* callback or the vad in goOnPlaybackAudioFrameBeforeMixing which makes the audio glitch.
+* every callback is timed by beginCallback/endCallback, and the last callbackEventRingSize of them are
+* always kept in a ring. while the watchdog runs, the callbacks in flight are also kept in a table
+* which it scans, so the stacks are taken while a slow callback is still stuck, not after it returned.
+* a report has the stacks of all the goroutines, the recent callbacks, and the execution trace of the
+* last seconds if TraceDir is set(a flight recorder, with go1.25). the reports are rate limited.
+* usage:
+* agoraservice.StartCallbackWatchdog(&agoraservice.CallbackWatchdogConfig{Threshold: 5 * time.Millisecond, TraceDir: "/tmp/agora_traces"})
+* defer agoraservice.StopCallbackWatchdog()
+ */
+
+const (
+	defaultCallbackThreshold         = 5 * time.Millisecond
+	defaultCallbackReportInterval    = 10 * time.Second
+	defaultCallbackTraceWindow       = 5 * time.Second
+	callbackEventRingSize            = 1024
+	callbackInflightSlots            = 256
+	callbackInflightProbes           = 8
+	callbackReportStackSize          = 1 << 20
+	callbackReportPrintedEvents      = 32
+	callbackWatchdogMinScanInterval  = time.Millisecond
+	callbackWatchdogReportQueueDepth = 16
+)
+
+type CallbackWatchdogConfig struct {
+	// a callback running longer is reported, default 5ms
+	Threshold time.Duration
+	// at most one report per interval, the others are counted in CallbackReport.Suppressed. default 10s
+	MinReportInterval time.Duration
+	// if set, the execution trace of the last TraceWindow is written to a file of this directory for
+	// every report. it needs go1.25, and fails if another flight recorder runs.
+	TraceDir    string
+	TraceWindow time.Duration // default 5s
+	// called on the watchdog goroutine, default: print the report
+	OnReport func(report *CallbackReport)
+}
+
+// CallbackEvent is a callback which returned.
+type CallbackEvent struct {
+	Type     CallbackType
+	Start    time.Time
+	Duration time.Duration
+}
+
+type CallbackReport struct {
+	Type  CallbackType
+	Start time.Time
+	// the time the callback had run when the stacks were taken, or its duration if it returned before
+	// the watchdog saw it, in which case Stack is nil
+	Duration time.Duration
+	Stack    []byte
+	// the last callbacks which returned, oldest first
+	Recent []CallbackEvent
+	// the execution trace file, if TraceDir is set
+	TraceFile string
+	// the reports dropped by the rate limit since the previous one
+	Suppressed uint64
+}
+
+// callbackScope is returned by beginCallback and passed to endCallback, on the stack:
+// defer endCallback(beginCallback(CallbackOnConnected))
+type callbackScope struct {
+	t        CallbackType
+	start    time.Time
+	watchdog *callbackWatchdog
+	slot     int32
+}
+
+func beginCallback(t CallbackType) callbackScope {
+	s := callbackScope{t: t, start: time.Now(), slot: -1}
+	if w := watchdog.Load(); w != nil {
+		s.watchdog = w
+		s.slot = w.claim(t, s.start)
+	}
+	return s
+}
+
+func endCallback(s callbackScope) {
+	d := time.Since(s.start)
+	metrics.callbacks[s.t].Record(d)
+	callbackEvents.add(s.t, s.start, d)
+	if s.watchdog != nil {
+		s.watchdog.release(s, d)
+	}
+}
+
+/*
+* the ring of the recent callbacks, written by all the callback threads without a lock: a writer takes
+* a position and marks the slot busy(seq 0) while it writes it, a reader skips the slots which are
+* busy or were overwritten while it read them.
+ */
+type callbackEventSlot struct {
+	seq   atomic.Uint64 // position+1 once written, 0 while written
+	t     atomic.Int32
+	start atomic.Int64 // unix ns
+	dur   atomic.Int64
+}
+
+type callbackEventRing struct {
+	pos   atomic.Uint64
+	slots [callbackEventRingSize]callbackEventSlot
+}
+
+var callbackEvents callbackEventRing
+
+func (r *callbackEventRing) add(t CallbackType, start time.Time, d time.Duration) {
+	pos := r.pos.Add(1) - 1
+	slot := &r.slots[pos%callbackEventRingSize]
+	slot.seq.Store(0)
+	slot.t.Store(int32(t))
+	slot.start.Store(start.UnixNano())
+	slot.dur.Store(int64(d))
+	slot.seq.Store(pos + 1)
+}
+
+// recent returns the events of the ring, oldest first.
+func (r *callbackEventRing) recent() []CallbackEvent {
+	end := r.pos.Load()
+	begin := uint64(0)
+	if end > callbackEventRingSize {
+		begin = end - callbackEventRingSize
+	}
+	events := make([]CallbackEvent, 0, end-begin)
+	for pos := begin; pos < end; pos++ {
+		slot := &r.slots[pos%callbackEventRingSize]
+		if slot.seq.Load() != pos+1 {
+			continue
+		}
+		e := CallbackEvent{
+			Type:     CallbackType(slot.t.Load()),
+			Start:    time.Unix(0, slot.start.Load()),
+			Duration: time.Duration(slot.dur.Load()),
+		}
+		if slot.seq.Load() != pos+1 {
+			continue
+		}
+		events = append(events, e)
+	}
+	return events
+}
+
+// a callback in flight, start is 0 when the slot is free
+type callbackInflightSlot struct {
+	start    atomic.Int64 // unix ns
+	t        atomic.Int32
+	reported atomic.Bool
+}
+
+type callbackWatchdog struct {
+	cfg      CallbackWatchdogConfig
+	slots    [callbackInflightSlots]callbackInflightSlot
+	next     atomic.Uint32
+	reports  chan *CallbackReport
+	stop     chan struct{}
+	done     chan struct{}
+	recorder *flightRecorder
+
+	lastReport time.Time
+	suppressed uint64
+}
+
+var (
+	watchdog   atomic.Pointer[callbackWatchdog]
+	watchdogMu sync.Mutex
+)
+
+// StartCallbackWatchdog starts reporting the slow callbacks, it replaces a running watchdog.
+func StartCallbackWatchdog(cfg *CallbackWatchdogConfig) error {
+	w := &callbackWatchdog{
+		reports: make(chan *CallbackReport, callbackWatchdogReportQueueDepth),
+		stop:    make(chan struct{}),
+		done:    make(chan struct{}),
+	}
+	if cfg != nil {
+		w.cfg = *cfg
+	}
+	if w.cfg.Threshold <= 0 {
+		w.cfg.Threshold = defaultCallbackThreshold
+	}
+	if w.cfg.MinReportInterval <= 0 {
+		w.cfg.MinReportInterval = defaultCallbackReportInterval
+	}
+	if w.cfg.TraceWindow <= 0 {
+		w.cfg.TraceWindow = defaultCallbackTraceWindow
+	}
+	if w.cfg.OnReport == nil {
+		w.cfg.OnReport = printCallbackReport
+	}
+
+	watchdogMu.Lock()
+	defer watchdogMu.Unlock()
+	stopCallbackWatchdog()
+
+	if w.cfg.TraceDir != "" {
+		if err := os.MkdirAll(w.cfg.TraceDir, 0755); err != nil {
+			return err
+		}
+		recorder, err := startFlightRecorder(w.cfg.TraceWindow)
+		if err != nil {
+			return err
+		}
+		w.recorder = recorder
+	}
+
+	watchdog.Store(w)
+	go w.run()
+	return nil
+}
+
+// StopCallbackWatchdog stops the watchdog, the callbacks are still timed for GetMetrics.
+func StopCallbackWatchdog() {
+	watchdogMu.Lock()
+	defer watchdogMu.Unlock()
+	stopCallbackWatchdog()
+}
+
+func stopCallbackWatchdog() {
+	w := watchdog.Swap(nil)
+	if w == nil {
+		return
+	}
+	close(w.stop)
+	<-w.done
+	if w.recorder != nil {
+		w.recorder.stop()
+	}
+}
+
+// claim takes a slot for a callback in flight, or returns -1 if the probed slots are taken.
+func (w *callbackWatchdog) claim(t CallbackType, start time.Time) int32 {
+	ns := start.UnixNano()
+	first := w.next.Add(1)
+	for i := uint32(0); i < callbackInflightProbes; i++ {
+		idx := (first + i) % callbackInflightSlots
+		slot := &w.slots[idx]
+		if slot.start.Load() == 0 && slot.start.CompareAndSwap(0, ns) {
+			slot.t.Store(int32(t))
+			slot.reported.Store(false)
+			return int32(idx)
+		}
+	}
+	return -1
+}
+
+// release frees the slot of a callback, and queues a report if it was too slow and the watchdog didn't
+// report it while it ran.
+func (w *callbackWatchdog) release(s callbackScope, d time.Duration) {
+	reported := false
+	if s.slot >= 0 {
+		slot := &w.slots[s.slot]
+		reported = slot.reported.Swap(true)
+		slot.start.Store(0)
+	}
+	if d > w.cfg.Threshold && !reported {
+		w.queue(&CallbackReport{Type: s.t, Start: s.start, Duration: d})
+	}
+}
+
+// queue hands a report to the watchdog goroutine without blocking, it's dropped if the queue is full.
+func (w *callbackWatchdog) queue(r *CallbackReport) {
+	select {
+	case w.reports <- r:
+	default:
+	}
+}
+
+func (w *callbackWatchdog) run() {
+	defer close(w.done)
+	interval := max(w.cfg.Threshold/2, callbackWatchdogMinScanInterval)
+	ticker := time.NewTicker(interval)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-w.stop:
+			return
+		case r := <-w.reports:
+			w.report(r)
+		case now := <-ticker.C:
+			w.scan(now)
+		}
+	}
+}
+
+// scan reports the first callback in flight which is over the threshold, with the stacks taken now.
+func (w *callbackWatchdog) scan(now time.Time) {
+	threshold := int64(w.cfg.Threshold)
+	for i := range w.slots {
+		slot := &w.slots[i]
+		start := slot.start.Load()
+		if start == 0 || now.UnixNano()-start <= threshold {
+			continue
+		}
+		// the callback may return meanwhile, whoever sets reported first reports it
+		if slot.reported.Swap(true) {
+			continue
+		}
+		r := &CallbackReport{
+			Type:     CallbackType(slot.t.Load()),
+			Start:    time.Unix(0, start),
+			Duration: time.Duration(now.UnixNano() - start),
+		}
+		if w.allow(now) {
+			r.Stack = allStacks()
+			w.complete(r)
+		}
+		return
+	}
+}
+
+// report handles a report queued by a callback which returned.
+func (w *callbackWatchdog) report(r *CallbackReport) {
+	if w.allow(time.Now()) {
+		w.complete(r)
+	}
+}
+
+// allow applies the rate limit.
+func (w *callbackWatchdog) allow(now time.Time) bool {
+	if !w.lastReport.IsZero() && now.Sub(w.lastReport) < w.cfg.MinReportInterval {
+		w.suppressed++
+		return false
+	}
+	w.lastReport = now
+	return true
+}
+
+func (w *callbackWatchdog) complete(r *CallbackReport) {
+	r.Suppressed = w.suppressed
+	w.suppressed = 0
+	r.Recent = callbackEvents.recent()
+	if w.recorder != nil {
+		name := filepath.Join(w.cfg.TraceDir, fmt.Sprintf("callback_%s_%d.trace", r.Type, r.Start.UnixNano()))
+		if err := w.recorder.writeFile(name); err != nil {
+			fmt.Printf("[callback watchdog] failed to write the execution trace, %v\n", err)
+		} else {
+			r.TraceFile = name
+		}
+	}
+	w.cfg.OnReport(r)
+}
+
+func allStacks() []byte {
+	buf := make([]byte, callbackReportStackSize)
+	return buf[:runtime.Stack(buf, true)]
+}
+
+func printCallbackReport(r *CallbackReport) {
+	fmt.Printf("[callback watchdog] %s ran %v since %s, %d reports suppressed\n",
+		r.Type, r.Duration, r.Start.Format("15:04:05.000000"), r.Suppressed)
+	recent := r.Recent
+	if len(recent) > callbackReportPrintedEvents {
+		recent = recent[len(recent)-callbackReportPrintedEvents:]
+	}
+	for _, e := range recent {
+		fmt.Printf("[callback watchdog]   %s %s %v\n", e.Start.Format("15:04:05.000000"), e.Type, e.Duration)
+	}
+	if r.TraceFile != "" {
+		fmt.Printf("[callback watchdog] execution trace: %s\n", r.TraceFile)
+	}
+	if r.Stack != nil {
+		fmt.Printf("[callback watchdog] stacks:\n%s\n", r.Stack)
+	}
+}
@@ -0,0 +1,21 @@
+//go:build !go1.25
+
+package agoraservice
+
+import (
+	"errors"
+	"time"
+)
+
+// flightRecorder needs the flight recorder of runtime/trace, added in go1.25.
+type flightRecorder struct{}
+
+func startFlightRecorder(window time.Duration) (*flightRecorder, error) {
+	return nil, errors.New("the execution trace of the callback watchdog needs go1.25")
+}
+
+func (r *flightRecorder) writeFile(name string) error {
+	return nil
+}
+
+func (r *flightRecorder) stop() {}
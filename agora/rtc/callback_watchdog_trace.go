@@ -0,0 +1,38 @@
+//go:build go1.25
+
+package agoraservice
+
+import (
+	"os"
+	"runtime/trace"
+	"time"
+)
+
+// flightRecorder keeps the execution trace of the last window in memory, see CallbackWatchdogConfig.TraceDir.
+type flightRecorder struct {
+	fr *trace.FlightRecorder
+}
+
+func startFlightRecorder(window time.Duration) (*flightRecorder, error) {
+	fr := trace.NewFlightRecorder(trace.FlightRecorderConfig{MinAge: window})
+	if err := fr.Start(); err != nil {
+		return nil, err
+	}
+	return &flightRecorder{fr: fr}, nil
+}
+
+func (r *flightRecorder) writeFile(name string) error {
+	f, err := os.Create(name)
+	if err != nil {
+		return err
+	}
+	if _, err := r.fr.WriteTo(f); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
+
+func (r *flightRecorder) stop() {
+	r.fr.Stop()
+}
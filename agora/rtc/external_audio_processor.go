@@ -17,6 +17,7 @@ import (
 
 //export goOnSinkAudioFrame
 func goOnSinkAudioFrame(sink unsafe.Pointer, frame unsafe.Pointer) C.int {
+	defer endCallback(beginCallback(CallbackOnSinkAudioFrame))
 
 	goFrame := GoSinkAudioFrame((*C.struct__audio_pcm_frame)(frame))
 	// restore external audio processor instance from user data
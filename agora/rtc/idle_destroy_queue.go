@@ -0,0 +1,199 @@
+package agoraservice
+
+import (
+	"container/heap"
+	"sync"
+	"sync/atomic"
+	"time"
+	"unsafe"
+)
+
+/*
+* idleDestroyQueue destroys the released connections of the idle mode after their delay.
+* the items are kept in a min-heap by expiry: a tick pops the expired ones, in O(log n) each, and hands
+* them in batches to a bounded pool of workers which destroy them outside the lock, so a mass hang-up
+* neither falls behind one destroy per tick nor blocks the new releases behind agora_rtc_conn_destroy.
+* the tick blocks when all the workers are busy, the expired items wait in the heap meanwhile.
+* see GetIdleDestroyStats for the queue lengths and the lag of the destroys.
+ */
+
+const (
+	idleDestroyBatchSize      = 16
+	defaultIdleDestroyWorkers = 4
+)
+
+// IdleDestroyStats are the counters of the idle mode.
+type IdleDestroyStats struct {
+	Queued    int    // waiting for their delay to expire
+	Pending   int    // expired, waiting for a worker
+	Destroyed uint64 // destroyed since Initialize
+	// from the expiry of a connection to its destroy
+	LastLag time.Duration
+	MaxLag  time.Duration
+	AvgLag  time.Duration
+}
+
+type idleItemHeap []*IdleItem
+
+func (h idleItemHeap) Len() int           { return len(h) }
+func (h idleItemHeap) Less(i, j int) bool { return h[i].Expiry.Before(h[j].Expiry) }
+func (h idleItemHeap) Swap(i, j int)      { h[i], h[j] = h[j], h[i] }
+func (h *idleItemHeap) Push(x any)        { *h = append(*h, x.(*IdleItem)) }
+func (h *idleItemHeap) Pop() any {
+	old := *h
+	n := len(old)
+	item := old[n-1]
+	old[n-1] = nil
+	*h = old[:n-1]
+	return item
+}
+
+type idleDestroyQueue struct {
+	mu     sync.Mutex
+	items  idleItemHeap
+	closed bool
+
+	// held for reading while sending to batches, so that close doesn't close it under a sender
+	dispatchMu sync.RWMutex
+	batches    chan []*IdleItem
+	wg         sync.WaitGroup
+	destroy    func(handle unsafe.Pointer)
+
+	pending   atomic.Int64
+	destroyed atomic.Uint64
+	lastLag   atomic.Int64
+	maxLag    atomic.Int64
+	totalLag  atomic.Int64
+}
+
+func newIdleDestroyQueue(workers int, destroy func(handle unsafe.Pointer)) *idleDestroyQueue {
+	if workers <= 0 {
+		workers = defaultIdleDestroyWorkers
+	}
+	q := &idleDestroyQueue{
+		batches: make(chan []*IdleItem, workers),
+		destroy: destroy,
+	}
+	q.wg.Add(workers)
+	for i := 0; i < workers; i++ {
+		go q.worker()
+	}
+	return q
+}
+
+// add queues handle to be destroyed after delay, or destroys it now if the queue is closed.
+func (q *idleDestroyQueue) add(handle unsafe.Pointer, delay time.Duration) {
+	item := newIdleItem(handle, int(delay/time.Millisecond))
+	q.mu.Lock()
+	if q.closed {
+		q.mu.Unlock()
+		q.destroy(handle)
+		return
+	}
+	heap.Push(&q.items, item)
+	q.mu.Unlock()
+}
+
+// expire dispatches the items which expired at now.
+func (q *idleDestroyQueue) expire(now time.Time) {
+	for {
+		q.mu.Lock()
+		var batch []*IdleItem
+		for len(q.items) > 0 && len(batch) < idleDestroyBatchSize && !q.items[0].Expiry.After(now) {
+			batch = append(batch, heap.Pop(&q.items).(*IdleItem))
+		}
+		q.mu.Unlock()
+		if len(batch) == 0 {
+			return
+		}
+		if !q.dispatch(batch) {
+			return
+		}
+		if len(batch) < idleDestroyBatchSize {
+			return
+		}
+	}
+}
+
+func (q *idleDestroyQueue) dispatch(batch []*IdleItem) bool {
+	q.dispatchMu.RLock()
+	defer q.dispatchMu.RUnlock()
+	if q.batches == nil {
+		// closed meanwhile, close destroys what is left
+		for _, item := range batch {
+			q.destroy(item.Handle)
+		}
+		return false
+	}
+	q.pending.Add(int64(len(batch)))
+	q.batches <- batch
+	return true
+}
+
+func (q *idleDestroyQueue) worker() {
+	defer q.wg.Done()
+	for batch := range q.batches {
+		for _, item := range batch {
+			q.destroy(item.Handle)
+			q.pending.Add(-1)
+			q.record(time.Since(item.Expiry))
+		}
+	}
+}
+
+func (q *idleDestroyQueue) record(lag time.Duration) {
+	if lag < 0 {
+		lag = 0
+	}
+	q.destroyed.Add(1)
+	q.lastLag.Store(int64(lag))
+	q.totalLag.Add(int64(lag))
+	for {
+		prev := q.maxLag.Load()
+		if int64(lag) <= prev || q.maxLag.CompareAndSwap(prev, int64(lag)) {
+			return
+		}
+	}
+}
+
+// close destroys all the queued items without waiting for their delay and stops the workers.
+// it returns when all of them are destroyed.
+func (q *idleDestroyQueue) close() {
+	q.mu.Lock()
+	q.closed = true
+	items := q.items
+	q.items = nil
+	q.mu.Unlock()
+
+	for len(items) > 0 {
+		n := len(items)
+		if n > idleDestroyBatchSize {
+			n = idleDestroyBatchSize
+		}
+		q.dispatch(items[:n])
+		items = items[n:]
+	}
+
+	q.dispatchMu.Lock()
+	close(q.batches)
+	q.batches = nil
+	q.dispatchMu.Unlock()
+	q.wg.Wait()
+}
+
+func (q *idleDestroyQueue) stats() IdleDestroyStats {
+	q.mu.Lock()
+	queued := len(q.items)
+	q.mu.Unlock()
+	stats := IdleDestroyStats{
+		Queued:    queued,
+		Pending:   int(q.pending.Load()),
+		Destroyed: q.destroyed.Load(),
+		LastLag:   time.Duration(q.lastLag.Load()),
+		MaxLag:    time.Duration(q.maxLag.Load()),
+	}
+	if stats.Destroyed > 0 {
+		stats.AvgLag = time.Duration(q.totalLag.Load() / int64(stats.Destroyed))
+	}
+	return stats
+}
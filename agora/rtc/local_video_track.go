@@ -112,6 +112,15 @@ func (track *LocalVideoTrack) SetEnabled(enable bool) {
 	C.agora_local_video_track_set_enabled(track.cTrack, C.int(cEnable))
 }
 
+// SetVideoEncoderConfiguration configures the encoder of a track owned by the caller, e.g. NewMixedVideoTrack.
+// the track of the connection is configured with RtcConnection.SetVideoEncoderConfiguration.
+func (track *LocalVideoTrack) SetVideoEncoderConfiguration(cfg *VideoEncoderConfiguration) int {
+	if track == nil || track.cTrack == nil || cfg == nil {
+		return -2000
+	}
+	return track.setVideoEncoderConfiguration(cfg)
+}
+
 func (track *LocalVideoTrack) setVideoEncoderConfiguration(cfg *VideoEncoderConfiguration) int {
 	cCfg := C.struct__video_encoder_config{}
 	C.memset(unsafe.Pointer(&cCfg), 0, C.sizeof_struct__video_encoder_config)
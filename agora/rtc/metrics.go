@@ -0,0 +1,523 @@
+package agoraservice
+
+import (
+	"bufio"
+	"fmt"
+	"io"
+	"math/bits"
+	"strconv"
+	"strings"
+	"sync/atomic"
+	"time"
+)
+
+/*
+* the metrics of the hot paths, kept in atomics so that recording never takes a lock:
+* - the count and the duration of every cgo callback, by CallbackType, see beginCallback
+* - the frames received and sent by every connection
+* - the depth of Queue and LockFreeRingBuffer, and the frames LockFreeRingBuffer dropped
+* - the state transitions of AudioVadV2
+* - the sends and failures of AudioPcmDataSender.SendAudioPcmData
+* - the length of the idle destroy queue
+* usage:
+* snapshot := agoraservice.GetMetrics()
+* http.HandleFunc("/metrics", func(w http.ResponseWriter, r *http.Request) {
+*     w.Header().Set("Content-Type", "text/plain; version=0.0.4")
+*     agoraservice.WritePrometheusMetrics(w)
+* })
+ */
+
+// Counter is a monotonic counter, safe for concurrent use.
+type Counter struct {
+	v atomic.Uint64
+}
+
+func (c *Counter) Add(n uint64) { c.v.Add(n) }
+func (c *Counter) Inc()         { c.v.Add(1) }
+func (c *Counter) Load() uint64 { return c.v.Load() }
+
+// Gauge is a value which goes up and down, safe for concurrent use.
+type Gauge struct {
+	v atomic.Int64
+}
+
+func (g *Gauge) Set(n int64) { g.v.Store(n) }
+func (g *Gauge) Add(n int64) { g.v.Add(n) }
+func (g *Gauge) Load() int64 { return g.v.Load() }
+
+const (
+	// every power of two of nanoseconds is split into histogramSubBuckets buckets, as hdr histograms do,
+	// so a quantile is within 1/histogramSubBuckets of the recorded values. the values below
+	// histogramSubBuckets have a bucket each, and the values over 2^histogramMaxExponent ns(18min) are
+	// in the last bucket.
+	histogramSubBits     = 3
+	histogramSubBuckets  = 1 << histogramSubBits
+	histogramMaxExponent = 40
+	histogramBuckets     = (histogramMaxExponent - histogramSubBits + 2) * histogramSubBuckets
+
+	// the powers of two of nanoseconds exported as prometheus buckets, from 1.024us to 17.2s
+	prometheusMinExponent = 10
+	prometheusMaxExponent = 34
+)
+
+// Histogram records durations in log-linear buckets, safe for concurrent use. Record doesn't allocate.
+// it's the only histogram of the sdk, the root package exports it as LatencyHistogram.
+type Histogram struct {
+	counts [histogramBuckets]atomic.Uint64
+	sum    atomic.Int64
+	max    atomic.Int64
+}
+
+// HistogramBucket is a cumulative bucket: Count values are below UpperBound.
+type HistogramBucket struct {
+	UpperBound time.Duration
+	Count      uint64
+}
+
+type HistogramSnapshot struct {
+	Count uint64
+	Sum   time.Duration
+	Mean  time.Duration
+	Max   time.Duration
+	P50   time.Duration
+	P90   time.Duration
+	P99   time.Duration
+	// the cumulative counts at the powers of two from 1.024us to 17.2s, for the prometheus export
+	Buckets []HistogramBucket
+}
+
+func histogramBucket(ns uint64) int {
+	if ns < histogramSubBuckets {
+		return int(ns)
+	}
+	exp := bits.Len64(ns) - 1
+	if exp > histogramMaxExponent {
+		return histogramBuckets - 1
+	}
+	sub := int(ns>>(exp-histogramSubBits)) & (histogramSubBuckets - 1)
+	return (exp-histogramSubBits+1)*histogramSubBuckets + sub
+}
+
+// histogramBucketBounds returns the range [lower, upper) of the values of bucket i, in ns.
+func histogramBucketBounds(i int) (uint64, uint64) {
+	if i < histogramSubBuckets {
+		return uint64(i), uint64(i) + 1
+	}
+	exp := i/histogramSubBuckets + histogramSubBits - 1
+	sub := uint64(i % histogramSubBuckets)
+	shift := exp - histogramSubBits
+	return (histogramSubBuckets + sub) << shift, (histogramSubBuckets + sub + 1) << shift
+}
+
+func (h *Histogram) Record(d time.Duration) {
+	if d < 0 {
+		d = 0
+	}
+	h.counts[histogramBucket(uint64(d))].Add(1)
+	h.sum.Add(int64(d))
+	for {
+		prev := h.max.Load()
+		if int64(d) <= prev || h.max.CompareAndSwap(prev, int64(d)) {
+			break
+		}
+	}
+}
+
+func (h *Histogram) Snapshot() HistogramSnapshot {
+	var counts [histogramBuckets]uint64
+	var total uint64
+	for i := range h.counts {
+		counts[i] = h.counts[i].Load()
+		total += counts[i]
+	}
+	s := HistogramSnapshot{
+		Count: total,
+		Sum:   time.Duration(h.sum.Load()),
+		Max:   time.Duration(h.max.Load()),
+	}
+	if total > 0 {
+		s.Mean = s.Sum / time.Duration(total)
+	}
+
+	// the quantiles are the middle of their bucket, clamped to the max
+	quantile := func(q float64) time.Duration {
+		if total == 0 {
+			return 0
+		}
+		rank := uint64(q*float64(total-1)) + 1
+		var seen uint64
+		for i, c := range counts {
+			seen += c
+			if seen >= rank {
+				lower, upper := histogramBucketBounds(i)
+				if mid := time.Duration((lower + upper) / 2); mid < s.Max {
+					return mid
+				}
+				return s.Max
+			}
+		}
+		return s.Max
+	}
+	s.P50 = quantile(0.5)
+	s.P90 = quantile(0.9)
+	s.P99 = quantile(0.99)
+
+	s.Buckets = make([]HistogramBucket, 0, prometheusMaxExponent-prometheusMinExponent+1)
+	var cumulative uint64
+	i := 0
+	for exp := prometheusMinExponent; exp <= prometheusMaxExponent; exp++ {
+		bound := uint64(1) << exp
+		for ; i < histogramBuckets; i++ {
+			if _, upper := histogramBucketBounds(i); upper > bound {
+				break
+			}
+			cumulative += counts[i]
+		}
+		s.Buckets = append(s.Buckets, HistogramBucket{UpperBound: time.Duration(bound), Count: cumulative})
+	}
+	return s
+}
+
+// Reset clears the histogram, the records which race with it may be lost.
+func (h *Histogram) Reset() {
+	for i := range h.counts {
+		h.counts[i].Store(0)
+	}
+	h.sum.Store(0)
+	h.max.Store(0)
+}
+
+// CallbackType identifies the cgo callbacks, the exported go functions called by the sdk.
+type CallbackType int
+
+const (
+	CallbackOnConnected CallbackType = iota
+	CallbackOnDisconnected
+	CallbackOnConnecting
+	CallbackOnReconnecting
+	CallbackOnReconnected
+	CallbackOnConnectionLost
+	CallbackOnConnectionFailure
+	CallbackOnTokenPrivilegeWillExpire
+	CallbackOnTokenPrivilegeDidExpire
+	CallbackOnUserJoined
+	CallbackOnUserOffline
+	CallbackOnError
+	CallbackOnStreamMessageError
+	CallbackOnStreamMessage
+	CallbackOnUserInfoUpdated
+	CallbackOnUserAudioTrackSubscribed
+	CallbackOnUserVideoTrackSubscribed
+	CallbackOnUserAudioTrackStateChanged
+	CallbackOnUserVideoTrackStateChanged
+	CallbackOnAudioVolumeIndication
+	CallbackOnAudioPublishStateChanged
+	CallbackOnAudioMetadataReceived
+	CallbackOnLocalAudioTrackStatistics
+	CallbackOnRemoteAudioTrackStatistics
+	CallbackOnLocalVideoTrackStatistics
+	CallbackOnRemoteVideoTrackStatistics
+	CallbackOnEncryptionError
+	CallbackOnAudioTrackPublishSuccess
+	CallbackOnAudioTrackUnpublished
+	CallbackOnCapabilitiesChanged
+	CallbackOnIntraRequestReceived
+	CallbackOnRecordAudioFrame
+	CallbackOnPlaybackAudioFrame
+	CallbackOnMixedAudioFrame
+	CallbackOnEarMonitoringAudioFrame
+	CallbackOnPlaybackAudioFrameBeforeMixing
+	CallbackOnGetAudioFramePosition
+	CallbackOnGetPlaybackAudioFrameParam
+	CallbackOnGetRecordAudioFrameParam
+	CallbackOnGetMixedAudioFrameParam
+	CallbackOnGetEarMonitoringAudioFrameParam
+	CallbackOnSinkAudioFrame
+	CallbackOnVideoFrame
+	CallbackOnEncodedVideoFrame
+	callbackTypes
+)
+
+var callbackNames = [callbackTypes]string{
+	"onConnected",
+	"onDisconnected",
+	"onConnecting",
+	"onReconnecting",
+	"onReconnected",
+	"onConnectionLost",
+	"onConnectionFailure",
+	"onTokenPrivilegeWillExpire",
+	"onTokenPrivilegeDidExpire",
+	"onUserJoined",
+	"onUserOffline",
+	"onError",
+	"onStreamMessageError",
+	"onStreamMessage",
+	"onUserInfoUpdated",
+	"onUserAudioTrackSubscribed",
+	"onUserVideoTrackSubscribed",
+	"onUserAudioTrackStateChanged",
+	"onUserVideoTrackStateChanged",
+	"onAudioVolumeIndication",
+	"onAudioPublishStateChanged",
+	"onAudioMetadataReceived",
+	"onLocalAudioTrackStatistics",
+	"onRemoteAudioTrackStatistics",
+	"onLocalVideoTrackStatistics",
+	"onRemoteVideoTrackStatistics",
+	"onEncryptionError",
+	"onAudioTrackPublishSuccess",
+	"onAudioTrackUnpublished",
+	"onCapabilitiesChanged",
+	"onIntraRequestReceived",
+	"onRecordAudioFrame",
+	"onPlaybackAudioFrame",
+	"onMixedAudioFrame",
+	"onEarMonitoringAudioFrame",
+	"onPlaybackAudioFrameBeforeMixing",
+	"onGetAudioFramePosition",
+	"onGetPlaybackAudioFrameParam",
+	"onGetRecordAudioFrameParam",
+	"onGetMixedAudioFrameParam",
+	"onGetEarMonitoringAudioFrameParam",
+	"onSinkAudioFrame",
+	"onVideoFrame",
+	"onEncodedVideoFrame",
+}
+
+func (t CallbackType) String() string {
+	if t < 0 || t >= callbackTypes {
+		return "unknown(" + strconv.Itoa(int(t)) + ")"
+	}
+	return callbackNames[t]
+}
+
+// the vad states, from VadStateInvalid(-1) to VadStateRetractSpeaking(5)
+const vadStates = int(VadStateRetractSpeaking-VadStateInvalid) + 1
+
+type metricsRegistry struct {
+	callbacks [callbackTypes]Histogram
+
+	queueDepth    Gauge
+	queueEnqueued Counter
+	queueDequeued Counter
+
+	ringBufferWritten Counter
+	ringBufferRead    Counter
+	ringBufferDropped Counter
+
+	vadTransitions [vadStates][vadStates]Counter
+
+	pcmSent         Counter
+	pcmSendFailures Counter
+}
+
+var metrics metricsRegistry
+
+func observeVadTransition(from VadState, to VadState) {
+	if from == to || from < VadStateInvalid || from > VadStateRetractSpeaking || to < VadStateInvalid || to > VadStateRetractSpeaking {
+		return
+	}
+	metrics.vadTransitions[from-VadStateInvalid][to-VadStateInvalid].Inc()
+}
+
+func observePcmSend(ret int) {
+	metrics.pcmSent.Inc()
+	if ret != 0 {
+		metrics.pcmSendFailures.Inc()
+	}
+}
+
+// connectionMetrics are the counters of a connection, labeled by its channel and user once it connects.
+// several connections may join the same channel as the same user, so the series are also labeled by id.
+type connectionMetrics struct {
+	id                  uint64
+	labels              atomic.Pointer[connectionLabels]
+	audioFramesReceived Counter
+	videoFramesReceived Counter
+	audioFramesSent     Counter
+	videoFramesSent     Counter
+}
+
+type connectionLabels struct {
+	channelId string
+	userId    string
+}
+
+var nextConnectionMetricsId atomic.Uint64
+
+type CallbackMetrics struct {
+	Type     CallbackType
+	Duration HistogramSnapshot // Duration.Count is the number of calls
+}
+
+type ConnectionMetrics struct {
+	ConnectionId        uint64 // unique in the process
+	ChannelId           string
+	UserId              string
+	AudioFramesReceived uint64 // per remote user, before mixing
+	VideoFramesReceived uint64 // raw and encoded
+	AudioFramesSent     uint64 // in 10ms frames
+	VideoFramesSent     uint64 // raw and encoded
+}
+
+type VadTransitionMetrics struct {
+	From  VadState
+	To    VadState
+	Count uint64
+}
+
+type MetricsSnapshot struct {
+	// the callbacks which were called at least once
+	Callbacks []CallbackMetrics
+	// the connections which were connected and aren't released
+	Connections []ConnectionMetrics
+
+	// the items in all the Queue instances. a queue which is dropped with items keeps counting.
+	QueueDepth    int64
+	QueueEnqueued uint64
+	QueueDequeued uint64
+
+	// the same for all the LockFreeRingBuffer instances, Dropped are the frames TryWrite refused
+	RingBufferDepth   int64
+	RingBufferWritten uint64
+	RingBufferDropped uint64
+
+	// the AudioVadV2 transitions which happened at least once
+	VadTransitions []VadTransitionMetrics
+
+	PcmSent         uint64
+	PcmSendFailures uint64
+
+	IdleDestroy IdleDestroyStats
+}
+
+// GetMetrics returns a snapshot of the metrics, it doesn't block the recording.
+func GetMetrics() MetricsSnapshot {
+	var s MetricsSnapshot
+	for t := CallbackType(0); t < callbackTypes; t++ {
+		h := metrics.callbacks[t].Snapshot()
+		if h.Count > 0 {
+			s.Callbacks = append(s.Callbacks, CallbackMetrics{Type: t, Duration: h})
+		}
+	}
+
+	agoraService.consByCCon.Range(func(key, value interface{}) bool {
+		con, ok := value.(*RtcConnection)
+		if !ok {
+			return true
+		}
+		labels := con.metrics.labels.Load()
+		if labels == nil {
+			return true
+		}
+		s.Connections = append(s.Connections, ConnectionMetrics{
+			ConnectionId:        con.metrics.id,
+			ChannelId:           labels.channelId,
+			UserId:              labels.userId,
+			AudioFramesReceived: con.metrics.audioFramesReceived.Load(),
+			VideoFramesReceived: con.metrics.videoFramesReceived.Load(),
+			AudioFramesSent:     con.metrics.audioFramesSent.Load(),
+			VideoFramesSent:     con.metrics.videoFramesSent.Load(),
+		})
+		return true
+	})
+
+	s.QueueDepth = metrics.queueDepth.Load()
+	s.QueueEnqueued = metrics.queueEnqueued.Load()
+	s.QueueDequeued = metrics.queueDequeued.Load()
+
+	// read before written, so the depth isn't negative
+	read := metrics.ringBufferRead.Load()
+	s.RingBufferWritten = metrics.ringBufferWritten.Load()
+	s.RingBufferDepth = int64(s.RingBufferWritten - read)
+	s.RingBufferDropped = metrics.ringBufferDropped.Load()
+
+	for from := range metrics.vadTransitions {
+		for to := range metrics.vadTransitions[from] {
+			if n := metrics.vadTransitions[from][to].Load(); n > 0 {
+				s.VadTransitions = append(s.VadTransitions, VadTransitionMetrics{
+					From:  VadState(from) + VadStateInvalid,
+					To:    VadState(to) + VadStateInvalid,
+					Count: n,
+				})
+			}
+		}
+	}
+
+	s.PcmSent = metrics.pcmSent.Load()
+	s.PcmSendFailures = metrics.pcmSendFailures.Load()
+	s.IdleDestroy = GetIdleDestroyStats()
+	return s
+}
+
+// WritePrometheusMetrics writes a snapshot of the metrics in the prometheus text format, e.g. from a
+// http handler of the application.
+func WritePrometheusMetrics(w io.Writer) error {
+	s := GetMetrics()
+	bw := bufio.NewWriter(w)
+
+	writeHeader := func(name, typ, help string) {
+		fmt.Fprintf(bw, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, typ)
+	}
+
+	writeHeader("agora_callback_duration_seconds", "histogram", "Duration of the cgo callbacks of the sdk.")
+	for _, cb := range s.Callbacks {
+		label := `callback="` + cb.Type.String() + `"`
+		for _, b := range cb.Duration.Buckets {
+			fmt.Fprintf(bw, "agora_callback_duration_seconds_bucket{%s,le=\"%g\"} %d\n", label, b.UpperBound.Seconds(), b.Count)
+		}
+		fmt.Fprintf(bw, "agora_callback_duration_seconds_bucket{%s,le=\"+Inf\"} %d\n", label, cb.Duration.Count)
+		fmt.Fprintf(bw, "agora_callback_duration_seconds_sum{%s} %g\n", label, cb.Duration.Sum.Seconds())
+		fmt.Fprintf(bw, "agora_callback_duration_seconds_count{%s} %d\n", label, cb.Duration.Count)
+	}
+
+	writeHeader("agora_connection_frames_received_total", "counter", "Frames received by the connections.")
+	for _, c := range s.Connections {
+		label := connectionLabel(c)
+		fmt.Fprintf(bw, "agora_connection_frames_received_total{%s,media=\"audio\"} %d\n", label, c.AudioFramesReceived)
+		fmt.Fprintf(bw, "agora_connection_frames_received_total{%s,media=\"video\"} %d\n", label, c.VideoFramesReceived)
+	}
+	writeHeader("agora_connection_frames_sent_total", "counter", "Frames sent by the connections, audio in 10ms frames.")
+	for _, c := range s.Connections {
+		label := connectionLabel(c)
+		fmt.Fprintf(bw, "agora_connection_frames_sent_total{%s,media=\"audio\"} %d\n", label, c.AudioFramesSent)
+		fmt.Fprintf(bw, "agora_connection_frames_sent_total{%s,media=\"video\"} %d\n", label, c.VideoFramesSent)
+	}
+
+	writeHeader("agora_queue_depth", "gauge", "Items in the queues.")
+	fmt.Fprintf(bw, "agora_queue_depth %d\n", s.QueueDepth)
+	writeHeader("agora_queue_enqueued_total", "counter", "Items enqueued to the queues.")
+	fmt.Fprintf(bw, "agora_queue_enqueued_total %d\n", s.QueueEnqueued)
+
+	writeHeader("agora_queue_dequeued_total", "counter", "Items dequeued from the queues.")
+	fmt.Fprintf(bw, "agora_queue_dequeued_total %d\n", s.QueueDequeued)
+
+	writeHeader("agora_ring_buffer_depth", "gauge", "Frames in the lock-free ring buffers.")
+	fmt.Fprintf(bw, "agora_ring_buffer_depth %d\n", s.RingBufferDepth)
+	writeHeader("agora_ring_buffer_written_total", "counter", "Frames written to the lock-free ring buffers.")
+	fmt.Fprintf(bw, "agora_ring_buffer_written_total %d\n", s.RingBufferWritten)
+	writeHeader("agora_ring_buffer_dropped_total", "counter", "Frames dropped by the full lock-free ring buffers.")
+	fmt.Fprintf(bw, "agora_ring_buffer_dropped_total %d\n", s.RingBufferDropped)
+
+	writeHeader("agora_vad_transitions_total", "counter", "State transitions of the vad.")
+	for _, t := range s.VadTransitions {
+		fmt.Fprintf(bw, "agora_vad_transitions_total{from=\"%d\",to=\"%d\"} %d\n", int(t.From), int(t.To), t.Count)
+	}
+
+	writeHeader("agora_pcm_sent_total", "counter", "Calls of AudioPcmDataSender.SendAudioPcmData.")
+	fmt.Fprintf(bw, "agora_pcm_sent_total %d\n", s.PcmSent)
+	writeHeader("agora_pcm_send_failures_total", "counter", "Failed calls of AudioPcmDataSender.SendAudioPcmData.")
+	fmt.Fprintf(bw, "agora_pcm_send_failures_total %d\n", s.PcmSendFailures)
+
+	writeHeader("agora_idle_destroy_queue_length", "gauge", "Released connections waiting to be destroyed in the idle mode.")
+	fmt.Fprintf(bw, "agora_idle_destroy_queue_length %d\n", s.IdleDestroy.Queued+s.IdleDestroy.Pending)
+
+	return bw.Flush()
+}
+
+var prometheusLabelEscaper = strings.NewReplacer(`\`, `\\`, `"`, `\"`, "\n", `\n`)
+
+func connectionLabel(c ConnectionMetrics) string {
+	return `connection="` + strconv.FormatUint(c.ConnectionId, 10) + `",channel="` + prometheusLabelEscaper.Replace(c.ChannelId) + `",user="` + prometheusLabelEscaper.Replace(c.UserId) + `"`
+}
@@ -18,6 +18,7 @@ import (
 
 //export goOnConnected
 func goOnConnected(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnConnected))
 	//validity check
 	if cCon == nil {
 		return
@@ -33,6 +34,7 @@ func goOnConnected(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reaso
 
 //export goOnDisconnected
 func goOnDisconnected(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnDisconnected))
 	//validity check
 	if cCon == nil {
 		return
@@ -50,6 +52,7 @@ func goOnDisconnected(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, re
 
 //export goOnConnecting
 func goOnConnecting(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnConnecting))
 	//validity check
 	if cCon == nil {
 		return
@@ -66,6 +69,7 @@ func goOnConnecting(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reas
 
 //export goOnReconnecting
 func goOnReconnecting(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnReconnecting))
 	//validity check
 	if cCon == nil {
 		return
@@ -82,6 +86,7 @@ func goOnReconnecting(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, re
 
 //export goOnReconnected
 func goOnReconnected(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnReconnected))
 
 	//validity check
 	if cCon == nil {
@@ -99,6 +104,7 @@ func goOnReconnected(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, rea
 
 //export goOnConnectionLost
 func goOnConnectionLost(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info) {
+	defer endCallback(beginCallback(CallbackOnConnectionLost))
 	//validity check
 	if cCon == nil {
 		return
@@ -115,6 +121,7 @@ func goOnConnectionLost(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info)
 
 //export goOnConnectionFailure
 func goOnConnectionFailure(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_info, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnConnectionFailure))
 	//validity check
 	if cCon == nil {
 		return
@@ -131,6 +138,7 @@ func goOnConnectionFailure(cCon unsafe.Pointer, cConInfo *C.struct__rtc_conn_inf
 
 //export goOnTokenPrivilegeWillExpire
 func goOnTokenPrivilegeWillExpire(cCon unsafe.Pointer, ctoken *C.char) {
+	defer endCallback(beginCallback(CallbackOnTokenPrivilegeWillExpire))
 	//validity check
 	if cCon == nil {
 		return
@@ -146,6 +154,7 @@ func goOnTokenPrivilegeWillExpire(cCon unsafe.Pointer, ctoken *C.char) {
 
 //export goOnTokenPrivilegeDidExpire
 func goOnTokenPrivilegeDidExpire(cCon unsafe.Pointer) {
+	defer endCallback(beginCallback(CallbackOnTokenPrivilegeDidExpire))
 	//validity check
 	if cCon == nil {
 		return
@@ -161,6 +170,7 @@ func goOnTokenPrivilegeDidExpire(cCon unsafe.Pointer) {
 
 //export goOnUserJoined
 func goOnUserJoined(cCon unsafe.Pointer, uid *C.char) {
+	defer endCallback(beginCallback(CallbackOnUserJoined))
 	//validity check
 	if cCon == nil {
 		return
@@ -176,6 +186,7 @@ func goOnUserJoined(cCon unsafe.Pointer, uid *C.char) {
 
 //export goOnUserOffline
 func goOnUserOffline(cCon unsafe.Pointer, uid *C.char, reason C.int) {
+	defer endCallback(beginCallback(CallbackOnUserOffline))
 	//validity check
 	if cCon == nil {
 		return
@@ -191,6 +202,7 @@ func goOnUserOffline(cCon unsafe.Pointer, uid *C.char, reason C.int) {
 
 //export goOnError
 func goOnError(cCon unsafe.Pointer, err C.int, msg *C.char) {
+	defer endCallback(beginCallback(CallbackOnError))
 	//validity check
 	if cCon == nil {
 		return
@@ -206,6 +218,7 @@ func goOnError(cCon unsafe.Pointer, err C.int, msg *C.char) {
 
 //export goOnStreamMessageError
 func goOnStreamMessageError(cCon unsafe.Pointer, uid *C.char, streamId C.int, err C.int, missed C.int, cached C.int) {
+	defer endCallback(beginCallback(CallbackOnStreamMessageError))
 	//validity check
 	if cCon == nil {
 		return
@@ -221,6 +234,7 @@ func goOnStreamMessageError(cCon unsafe.Pointer, uid *C.char, streamId C.int, er
 
 //export goOnStreamMessage
 func goOnStreamMessage(cLocalUser unsafe.Pointer, uid *C.char, streamId C.int, data *C.char, length C.size_t) {
+	defer endCallback(beginCallback(CallbackOnStreamMessage))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -236,6 +250,7 @@ func goOnStreamMessage(cLocalUser unsafe.Pointer, uid *C.char, streamId C.int, d
 
 //export goOnUserInfoUpdated
 func goOnUserInfoUpdated(cLocalUser unsafe.Pointer, uid *C.char, msg C.int, val C.int) {
+	defer endCallback(beginCallback(CallbackOnUserInfoUpdated))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -251,6 +266,7 @@ func goOnUserInfoUpdated(cLocalUser unsafe.Pointer, uid *C.char, msg C.int, val
 
 //export goOnUserAudioTrackSubscribed
 func goOnUserAudioTrackSubscribed(cLocalUser unsafe.Pointer, uid *C.char, cRemoteAudioTrack unsafe.Pointer) {
+	defer endCallback(beginCallback(CallbackOnUserAudioTrackSubscribed))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -275,6 +291,7 @@ func goOnUserAudioTrackSubscribed(cLocalUser unsafe.Pointer, uid *C.char, cRemot
 
 //export goOnUserVideoTrackSubscribed
 func goOnUserVideoTrackSubscribed(cLocalUser unsafe.Pointer, uid *C.char, info *C.struct__video_track_info, cRemoteVideoTrack unsafe.Pointer) {
+	defer endCallback(beginCallback(CallbackOnUserVideoTrackSubscribed))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -290,6 +307,7 @@ func goOnUserVideoTrackSubscribed(cLocalUser unsafe.Pointer, uid *C.char, info *
 
 //export goOnUserAudioTrackStateChanged
 func goOnUserAudioTrackStateChanged(cLocalUser unsafe.Pointer, uid *C.char, cRemoteAudioTrack unsafe.Pointer, state C.int, reason C.int, elapsed C.int) {
+	defer endCallback(beginCallback(CallbackOnUserAudioTrackStateChanged))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -305,6 +323,7 @@ func goOnUserAudioTrackStateChanged(cLocalUser unsafe.Pointer, uid *C.char, cRem
 
 //export goOnUserVideoTrackStateChanged
 func goOnUserVideoTrackStateChanged(cLocalUser unsafe.Pointer, uid *C.char, cRemoteVideoTrack unsafe.Pointer, state C.int, reason C.int, elapsed C.int) {
+	defer endCallback(beginCallback(CallbackOnUserVideoTrackStateChanged))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -320,6 +339,7 @@ func goOnUserVideoTrackStateChanged(cLocalUser unsafe.Pointer, uid *C.char, cRem
 
 //export goOnAudioVolumeIndication
 func goOnAudioVolumeIndication(cLocalUser unsafe.Pointer, Volumes *C.struct__audio_volume_info, speakerNumber C.uint, totalVolume C.int) {
+	defer endCallback(beginCallback(CallbackOnAudioVolumeIndication))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -349,6 +369,7 @@ func goOnAudioVolumeIndication(cLocalUser unsafe.Pointer, Volumes *C.struct__aud
 
 //export goOnAudioPublishStateChanged
 func goOnAudioPublishStateChanged(cLocalUser unsafe.Pointer, channel *C.char, oldState C.int, newState C.int, elapseSinceLastState C.int) {
+	defer endCallback(beginCallback(CallbackOnAudioPublishStateChanged))
 	//fmt.Printf("goOnAudioPublishStateChanged: %d, %d, %d\n", oldState, newState, elapseSinceLastState)
 	//validity check
 	if cLocalUser == nil {
@@ -365,6 +386,7 @@ func goOnAudioPublishStateChanged(cLocalUser unsafe.Pointer, channel *C.char, ol
 
 //export goOnAudioMetadataReceived
 func goOnAudioMetadataReceived(cLocalUser unsafe.Pointer, uid *C.char, metaData *C.char, length C.size_t) {
+	defer endCallback(beginCallback(CallbackOnAudioMetadataReceived))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -380,6 +402,7 @@ func goOnAudioMetadataReceived(cLocalUser unsafe.Pointer, uid *C.char, metaData
 
 //export goOnLocalAudioTrackStatistics
 func goOnLocalAudioTrackStatistics(cLocalUser unsafe.Pointer, stats *C.struct__local_audio_stats) {
+	defer endCallback(beginCallback(CallbackOnLocalAudioTrackStatistics))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -394,6 +417,7 @@ func goOnLocalAudioTrackStatistics(cLocalUser unsafe.Pointer, stats *C.struct__l
 
 //export goOnRemoteAudioTrackStatistics
 func goOnRemoteAudioTrackStatistics(cLocalUser unsafe.Pointer, uid *C.char, stats *C.struct__remote_audio_stats) {
+	defer endCallback(beginCallback(CallbackOnRemoteAudioTrackStatistics))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -408,6 +432,7 @@ func goOnRemoteAudioTrackStatistics(cLocalUser unsafe.Pointer, uid *C.char, stat
 
 //export goOnLocalVideoTrackStatistics
 func goOnLocalVideoTrackStatistics(cLocalUser unsafe.Pointer, stats *C.struct__local_video_track_stats) {
+	defer endCallback(beginCallback(CallbackOnLocalVideoTrackStatistics))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -422,6 +447,7 @@ func goOnLocalVideoTrackStatistics(cLocalUser unsafe.Pointer, stats *C.struct__l
 
 //export goOnRemoteVideoTrackStatistics
 func goOnRemoteVideoTrackStatistics(cLocalUser unsafe.Pointer, uid *C.char, stats *C.struct__remote_video_track_stats) {
+	defer endCallback(beginCallback(CallbackOnRemoteVideoTrackStatistics))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -436,6 +462,7 @@ func goOnRemoteVideoTrackStatistics(cLocalUser unsafe.Pointer, uid *C.char, stat
 
 //export goOnEncryptionError
 func goOnEncryptionError(cCon unsafe.Pointer, errorType C.int) {
+	defer endCallback(beginCallback(CallbackOnEncryptionError))
 	//validity check
 	if cCon == nil {
 		return
@@ -450,6 +477,7 @@ func goOnEncryptionError(cCon unsafe.Pointer, errorType C.int) {
 
 //export goOnAudioTrackPublishSuccess
 func goOnAudioTrackPublishSuccess(cLocalUser unsafe.Pointer, cLocalAudioTrack unsafe.Pointer) {
+	defer endCallback(beginCallback(CallbackOnAudioTrackPublishSuccess))
 	//validity check
 	fmt.Printf("goOnAudioTrackPublishSuccess: %v\n", cLocalUser)
 	if cLocalUser == nil {
@@ -465,6 +493,7 @@ func goOnAudioTrackPublishSuccess(cLocalUser unsafe.Pointer, cLocalAudioTrack un
 
 //export goOnAudioTrackUnpublished
 func goOnAudioTrackUnpublished(cLocalUser unsafe.Pointer, cLocalAudioTrack unsafe.Pointer) {
+	defer endCallback(beginCallback(CallbackOnAudioTrackUnpublished))
 	fmt.Printf("goOnAudioTrackPublishSuccess: %v\n", cLocalUser)
 	//validity check
 	if cLocalUser == nil {
@@ -480,6 +509,7 @@ func goOnAudioTrackUnpublished(cLocalUser unsafe.Pointer, cLocalAudioTrack unsaf
 
 //export goOnCapabilitiesChanged
 func goOnCapabilitiesChanged(cCapObserverHandle unsafe.Pointer, caps *C.struct__capabilities, size C.int) {
+	defer endCallback(beginCallback(CallbackOnCapabilitiesChanged))
 	//validity check
 	//fmt.Printf("goOnCapabilitiesChanged, size: %d, cCapObserverHandle: %v\n", size, cCapObserverHandle)
 	if cCapObserverHandle == nil {
@@ -512,6 +542,7 @@ func goOnCapabilitiesChanged(cCapObserverHandle unsafe.Pointer, caps *C.struct__
 
 //export goOnIntraRequestReceived
 func goOnIntraRequestReceived(cLocalUser unsafe.Pointer) {
+	defer endCallback(beginCallback(CallbackOnIntraRequestReceived))
 	//validity check
 	if cLocalUser == nil {
 		return
@@ -301,11 +301,17 @@ type AudioFrameObserver struct {
 
 type VideoFrameObserver struct {
 	OnFrame func(channelId string, userId string, frame *VideoFrame) bool
+	// if true, the planes of the frame passed to OnFrame are views of the sdk memory and the frame is
+	// recycled after OnFrame returns; use frame.Clone or frame.CopyTo to keep it. default is false, i.e copy
+	BorrowFrame bool
 }
 
 type VideoEncodedFrameObserver struct {
 	OnEncodedVideoFrame func(uid string, imageBuffer []byte,
 		frameInfo *EncodedVideoFrameInfo) bool
+	// if true, imageBuffer is a view of the sdk memory and frameInfo is recycled, both are only valid
+	// until OnEncodedVideoFrame returns; copy what has to be kept. default is false, i.e copy
+	BorrowFrame bool
 }
 
 type AudioEncoderConfiguration struct {
@@ -408,6 +414,7 @@ type RtcConnection struct {
 	cVideoObserver        unsafe.Pointer
 	encodedVideoObserver  *VideoEncodedFrameObserver
 	cEncodedVideoObserver unsafe.Pointer
+	videoFrameFilter      *VideoFrameFilter // enforced in video_observer_cgo.c, ref to video_frame_filter.go
 
 	// remoteVideoRWMutex          *sync.RWMutex
 	// remoteEncodedVideoReceivers map[*VideoEncodedImageReceiver]*videoEncodedImageReceiverInner
@@ -437,6 +444,9 @@ type RtcConnection struct {
 	// pcm consumption stats for raw pcm data only
 	pcmConsumeStats *PcmConsumeStats
 
+	// frames received and sent, see GetMetrics
+	metrics connectionMetrics
+
 	// stream id for data stream： no need to call createDataStream manually, it is created by the sdk automatically
 	// and just use it for sendStreamMessage
 	dataStreamId int
@@ -502,6 +512,7 @@ func NewRtcConnection(cfg *RtcConnectionConfig, publishConfig *RtcConnectionPubl
 		dataStreamId:                -1,
 		sendExternalAudioParameters: nil,
 	}
+	ret.metrics.id = nextConnectionMetricsId.Add(1)
 
 	if isSupportExternalAudio(publishConfig) {
 		ret.sendExternalAudioParameters = &SendExternalAudioParameters{
@@ -766,6 +777,7 @@ func (conn *RtcConnection) Connect(token string, channel string, uid string) int
 	conn.connInfo.LocalUserId = uid
 	uidInt, _ := strconv.Atoi(uid)
 	conn.connInfo.InternalUid = uint(uidInt)
+	conn.metrics.labels.Store(&connectionLabels{channelId: channel, userId: uid})
 	cChannel := C.CString(channel)
 	cToken := C.CString(token)
 	cUid := C.CString(uid)
@@ -963,6 +975,7 @@ func (conn *RtcConnection) RegisterVideoFrameObserver(observer *VideoFrameObserv
 	conn.videoObserver = observer
 	if conn.cVideoObserver == nil {
 		conn.cVideoObserver = CVideoFrameObserver()
+		conn.applyVideoFrameFilter(conn.cVideoObserver)
 		// store to sync map
 		agoraService.setConFromHandle(conn.cVideoObserver, conn, ConTypeCVideoObserver)
 		C.agora_local_user_register_video_frame_observer(conn.localUser.cLocalUser, conn.cVideoObserver)
@@ -1001,6 +1014,7 @@ func (conn *RtcConnection) RegisterVideoEncodedFrameObserver(observer *VideoEnco
 	conn.encodedVideoObserver = observer
 	if conn.cEncodedVideoObserver == nil {
 		conn.cEncodedVideoObserver = CVideoEncodedFrameObserver()
+		conn.applyVideoFrameFilter(conn.cEncodedVideoObserver)
 		// store to sync map
 		agoraService.setConFromHandle(conn.cEncodedVideoObserver, conn, ConTypeCEncodedVideoObserver)
 		C.agora_local_user_register_video_encoded_frame_observer(conn.localUser.cLocalUser, conn.cEncodedVideoObserver)
@@ -1213,6 +1227,23 @@ func (conn *RtcConnection) UnpublishVideo() int {
 	ret := conn.localUser.unpublishVideo(conn.videoTrack)
 	return int(ret)
 }
+
+// PublishVideoTrack publishes a video track owned by the caller, e.g. NewMixedVideoTrack, besides the
+// track created from PublishConfig. the track must be unpublished before it is released.
+func (conn *RtcConnection) PublishVideoTrack(track *LocalVideoTrack) int {
+	if conn == nil || conn.cConnection == nil || track == nil || track.cTrack == nil {
+		return -2000
+	}
+	track.SetEnabled(true)
+	return conn.localUser.publishVideo(track)
+}
+
+func (conn *RtcConnection) UnpublishVideoTrack(track *LocalVideoTrack) int {
+	if conn == nil || conn.cConnection == nil || track == nil || track.cTrack == nil {
+		return -2000
+	}
+	return conn.localUser.unpublishVideo(track)
+}
 func (conn *RtcConnection) InterruptAudio() int {
 	if conn == nil || conn.cConnection == nil || conn.audioTrack == nil {
 		return -2000
@@ -1286,6 +1317,7 @@ func (conn *RtcConnection) PushAudioPcmData(data []byte, sampleRate int, channel
 	ret := conn.audioSender.SendAudioPcmData(frame)
 	if ret == 0 {
 		conn.pcmConsumeStats.addPcmData(readLen, sampleRate, channels)
+		conn.metrics.audioFramesSent.Add(uint64(packnumInMs / 10))
 	}
 	return ret
 }
@@ -1293,19 +1325,31 @@ func (conn *RtcConnection) PushAudioEncodedData(data []byte, frameInfo *EncodedA
 	if conn == nil || conn.cConnection == nil || conn.encodedAudioSender == nil {
 		return -2000
 	}
-	return conn.encodedAudioSender.SendEncodedAudioFrame(data, frameInfo)
+	ret := conn.encodedAudioSender.SendEncodedAudioFrame(data, frameInfo)
+	if ret == 0 {
+		conn.metrics.audioFramesSent.Inc()
+	}
+	return ret
 }
 func (conn *RtcConnection) PushVideoFrame(frame *ExternalVideoFrame) int {
 	if conn == nil || conn.cConnection == nil || conn.videoSender == nil {
 		return -2000
 	}
-	return conn.videoSender.SendVideoFrame(frame)
+	ret := conn.videoSender.SendVideoFrame(frame)
+	if ret == 0 {
+		conn.metrics.videoFramesSent.Inc()
+	}
+	return ret
 }
 func (conn *RtcConnection) PushVideoEncodedData(data []byte, frameInfo *EncodedVideoFrameInfo) int {
 	if conn == nil || conn.cConnection == nil || conn.encodedVideoSender == nil {
 		return -2000
 	}
-	return conn.encodedVideoSender.SendEncodedVideoImage(data, frameInfo)
+	ret := conn.encodedVideoSender.SendEncodedVideoImage(data, frameInfo)
+	if ret == 0 {
+		conn.metrics.videoFramesSent.Inc()
+	}
+	return ret
 }
 
 func (conn *RtcConnection) unregisterAudioEncodedFrameObserver() int {
@@ -17,6 +17,7 @@ package agoraservice
 import "C"
 import (
 	"runtime"
+	"sync/atomic"
 	"unsafe"
 )
 
@@ -230,6 +231,7 @@ func CVideoFrameObserver() unsafe.Pointer {
 }
 
 func FreeCVideoFrameObserver(observer unsafe.Pointer) {
+	C.cgo_video_filter_attach(observer, nil)
 	C.agora_video_frame_observer2_destroy(observer)
 }
 
@@ -242,6 +244,7 @@ func CVideoEncodedFrameObserver() unsafe.Pointer {
 }
 
 func FreeCEncodedVideoFrameObserver(observer unsafe.Pointer) {
+	C.cgo_video_filter_attach(observer, nil)
 	C.agora_video_encoded_frame_observer_destroy(observer)
 }
 
@@ -250,6 +253,15 @@ func Uint8PtrToUintptr(p *C.uint8_t) uintptr {
 }
 
 func GoVideoFrame(frame *C.struct__video_frame) *VideoFrame {
+	ret := copyVideoFrame(frame, defaultVideoBufferPool)
+	atomic.AddUint64(&videoFrameCopyStats.CopiedFrames, 1)
+	atomic.AddUint64(&videoFrameCopyStats.CopiedBytes, uint64(len(ret.YBuffer)+len(ret.UBuffer)+len(ret.VBuffer)+
+		len(ret.MetadataBuffer)+len(ret.AlphaBuffer)))
+	return ret
+}
+
+// copyVideoFrame copies frame into a buffer of pool, without counting it in GetVideoFrameCopyStats.
+func copyVideoFrame(frame *C.struct__video_frame, pool *VideoBufferPool) *VideoFrame {
 	// var buf []byte = nil
 	// bufLen := frame.y_stride*frame.height + frame.u_stride*frame.height/2 + frame.v_stride*frame.height/2
 	// uStart := frame.y_stride * frame.height
@@ -263,9 +275,20 @@ func GoVideoFrame(frame *C.struct__video_frame) *VideoFrame {
 	// 	copy(buf[uStart:], unsafe.Slice((*byte)(unsafe.Pointer(frame.u_buffer)), frame.u_stride*frame.height/2))
 	// 	copy(buf[vStart:], unsafe.Slice((*byte)(unsafe.Pointer(frame.v_buffer)), frame.v_stride*frame.height/2))
 	// }
-	yLen := frame.y_stride * frame.height
-	uLen := frame.u_stride * frame.height / 2
-	vLen := frame.v_stride * frame.height / 2
+	yLen := int(frame.y_stride * frame.height)
+	uLen := int(frame.u_stride * frame.height / 2)
+	vLen := int(frame.v_stride * frame.height / 2)
+	// the 3 planes are copied into one pooled heap buffer, which is recycled by VideoFrame.Release
+	pooled := pool.get(VideoBufferKey{
+		Format: VideoPixelI420,
+		Width:  int(frame.width),
+		Height: int(frame.height),
+		Stride: int(frame.y_stride),
+	}, yLen+uLen+vLen, false)
+	planes := pooled.Data
+	copy(planes[:yLen], borrowCBytes(unsafe.Pointer(frame.y_buffer), yLen))
+	copy(planes[yLen:yLen+uLen], borrowCBytes(unsafe.Pointer(frame.u_buffer), uLen))
+	copy(planes[yLen+uLen:], borrowCBytes(unsafe.Pointer(frame.v_buffer), vLen))
 	ret := &VideoFrame{
 		Type:           VideoBufferType(frame._type),
 		Width:          int(frame.width),
@@ -273,9 +296,9 @@ func GoVideoFrame(frame *C.struct__video_frame) *VideoFrame {
 		YStride:        int(frame.y_stride),
 		UStride:        int(frame.u_stride),
 		VStride:        int(frame.v_stride),
-		YBuffer:        C.GoBytes(unsafe.Pointer(frame.y_buffer), yLen),
-		UBuffer:        C.GoBytes(unsafe.Pointer(frame.u_buffer), uLen),
-		VBuffer:        C.GoBytes(unsafe.Pointer(frame.v_buffer), vLen),
+		YBuffer:        planes[:yLen:yLen],
+		UBuffer:        planes[yLen : yLen+uLen : yLen+uLen],
+		VBuffer:        planes[yLen+uLen:],
 		Rotation:       VideoOrientation(frame.rotation),
 		RenderTimeMs:   int64(frame.render_time_ms),
 		AVSyncType:     int(frame.avsync_type),
@@ -284,16 +307,73 @@ func GoVideoFrame(frame *C.struct__video_frame) *VideoFrame {
 		TextureID:      int(frame.texture_id),
 		Matrix:         [16]float32{},
 		AlphaBuffer:    nil,
+		pooled:         pooled,
 	}
 	for i := 0; i < 16; i++ {
 		ret.Matrix[i] = float32(frame.matrix[i])
 	}
 	if frame.alpha_buffer != nil {
-		ret.AlphaBuffer = C.GoBytes(unsafe.Pointer(frame.alpha_buffer), frame.y_stride*frame.height)
+		ret.AlphaBuffer = C.GoBytes(unsafe.Pointer(frame.alpha_buffer), C.int(yLen))
 	}
 	return ret
 }
 
+// goBorrowVideoFrame fills dst with views of the planes of frame, nothing is copied except the matrix.
+// the views are only valid until the callback which received frame returns.
+func goBorrowVideoFrame(frame *C.struct__video_frame, dst *VideoFrame) {
+	borrowVideoFrame(frame, dst)
+	atomic.AddUint64(&videoFrameCopyStats.BorrowedFrames, 1)
+}
+
+// borrowVideoFrame is goBorrowVideoFrame without counting it in GetVideoFrameCopyStats.
+func borrowVideoFrame(frame *C.struct__video_frame, dst *VideoFrame) {
+	yLen := int(frame.y_stride * frame.height)
+	uLen := int(frame.u_stride * frame.height / 2)
+	vLen := int(frame.v_stride * frame.height / 2)
+	dst.Type = VideoBufferType(frame._type)
+	dst.Width = int(frame.width)
+	dst.Height = int(frame.height)
+	dst.YStride = int(frame.y_stride)
+	dst.UStride = int(frame.u_stride)
+	dst.VStride = int(frame.v_stride)
+	dst.YBuffer = borrowCBytes(unsafe.Pointer(frame.y_buffer), yLen)
+	dst.UBuffer = borrowCBytes(unsafe.Pointer(frame.u_buffer), uLen)
+	dst.VBuffer = borrowCBytes(unsafe.Pointer(frame.v_buffer), vLen)
+	dst.Rotation = VideoOrientation(frame.rotation)
+	dst.RenderTimeMs = int64(frame.render_time_ms)
+	dst.AVSyncType = int(frame.avsync_type)
+	dst.MetadataBuffer = borrowCBytes(unsafe.Pointer(frame.metadata_buffer), int(frame.metadata_size))
+	dst.SharedContext = frame.shared_context
+	dst.TextureID = int(frame.texture_id)
+	for i := 0; i < 16; i++ {
+		dst.Matrix[i] = float32(frame.matrix[i])
+	}
+	dst.AlphaBuffer = borrowCBytes(unsafe.Pointer(frame.alpha_buffer), yLen)
+}
+
+func borrowCBytes(ptr unsafe.Pointer, length int) []byte {
+	if ptr == nil || length <= 0 {
+		return nil
+	}
+	return unsafe.Slice((*byte)(ptr), length)
+}
+
+// goEncodedVideoFrameInfo fills dst from info, dst may be a recycled struct.
+func goEncodedVideoFrameInfo(info *C.struct__encoded_video_frame_info, dst *EncodedVideoFrameInfo) {
+	dst.CodecType = VideoCodecType(info.codec_type)
+	dst.Width = int(info.width)
+	dst.Height = int(info.height)
+	dst.FramesPerSecond = int(info.frames_per_second)
+	dst.FrameType = VideoFrameType(info.frame_type)
+	dst.Rotation = VideoOrientation(info.rotation)
+	dst.TrackId = int(info.track_id)
+	dst.CaptureTimeMs = int64(info.capture_time_ms)
+	dst.DecodeTimeMs = int64(info.decode_time_ms)
+	dst.Uid = uint32(info.uid)
+	dst.StreamType = int(info.stream_type)
+	dst.PresentTimeMs = int64(info.presentation_ms)
+}
+
 func GoVideoTrackInfo(cInfo *C.struct__video_track_info) *VideoTrackInfo {
 	ret := &VideoTrackInfo{
 		IsLocal:             (int(cInfo.is_local) != 0),
@@ -0,0 +1,698 @@
+package agoraservice
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"sort"
+)
+
+/*
+* dump.vdc is the compact format of VadDump(VadDumpFormatCompact): audio is stored
+* as lossless FLAC-style packets and the labels as small columns, so a dump can be
+* left on for hours. The index at the end allows to load a single vad segment.
+* layout:
+* header | block 0 | block 1 | ... | index | trailer
+* header:  "AVDC", u8 version, u32 sample rate, u8 channels, u16 reserved
+* block:   "BLK1", u32 payload size, u32 first frame, u16 frame count, payload
+*          payload: label columns, then one audio packet per frame
+*          label columns: state[n] int8, far[n] int8, then vop[n], rms[n], pitch[n], mup[n] as zigzag delta uvarints
+*          audio packet: uvarint samples per channel, then per channel:
+*          u8 predictor order(0-3), u8 rice parameter, order warm-up int16 samples, rice coded residuals(byte aligned)
+* index:   uvarint block count, {uvarint first frame, uvarint frame count, uvarint offset}...,
+*          uvarint segment count, {uvarint start frame, uvarint stop frame}...
+* trailer: u64 index offset, "AVDX"
+* a file without trailer(e.g. the process was killed) is still readable: the index is rebuilt by scanning the blocks.
+* usage:
+* c, err := OpenVadDumpContainer("./dump/20251103120000/dump.vdc")
+* frames, err := c.ReadSegment(3, 50) // the 4th vad segment with 500ms before the start decision
+ */
+
+const (
+	vadDumpContainerName    = "dump.vdc"
+	vadDumpContainerVersion = 1
+	vadDumpHeaderSize       = 12
+	vadDumpBlockHeaderSize  = 14
+	vadDumpTrailerSize      = 12
+	vadDumpBlockFrames      = 100 // 1s per block
+	vadDumpRiceEscape       = 32
+)
+
+var (
+	vadDumpHeaderMagic  = []byte("AVDC")
+	vadDumpBlockMagic   = []byte("BLK1")
+	vadDumpTrailerMagic = []byte("AVDX")
+)
+
+// VadDumpSegment is a vad section of a dump, in frame index.
+// StartFrame is the frame of VadStateStartSpeeking and StopFrame the frame of
+// VadStateStopSpeeking(or the last frame if the dump ended while speaking).
+type VadDumpSegment struct {
+	StartFrame int
+	StopFrame  int
+}
+
+type vadDumpBlockIndex struct {
+	firstFrame int
+	frameCount int
+	offset     int64
+}
+
+// vadDumpContainerWriter is only used by the flush goroutine of vadDumpWriter.
+type vadDumpContainerWriter struct {
+	file       *os.File
+	offset     int64
+	sampleRate int
+	channels   int
+	frames     int
+
+	labels   []VadDumpLabel // labels of the current block
+	packets  []byte         // audio packets of the current block
+	block    []byte
+	blocks   []vadDumpBlockIndex
+	segments []VadDumpSegment
+	segStart int
+	samples  []int32
+	bits     vadBitWriter
+}
+
+func newVadDumpContainerWriter(file *os.File) *vadDumpContainerWriter {
+	return &vadDumpContainerWriter{
+		file:     file,
+		labels:   make([]VadDumpLabel, 0, vadDumpBlockFrames),
+		packets:  make([]byte, 0, 64*1024),
+		block:    make([]byte, 0, 64*1024),
+		segStart: -1,
+	}
+}
+
+// writeFrame returns false if the frame does not match the format of the first frame.
+func (c *vadDumpContainerWriter) writeFrame(label *VadDumpLabel, pcm []byte, sampleRate int, channels int) bool {
+	if c.sampleRate == 0 {
+		if channels <= 0 || channels > 255 {
+			return false
+		}
+		c.sampleRate = sampleRate
+		c.channels = channels
+		var header [vadDumpHeaderSize]byte
+		copy(header[0:4], vadDumpHeaderMagic)
+		header[4] = vadDumpContainerVersion
+		binary.LittleEndian.PutUint32(header[5:9], uint32(sampleRate))
+		header[9] = byte(channels)
+		c.write(header[:])
+	}
+	if sampleRate != c.sampleRate || channels != c.channels || len(pcm)%(2*channels) != 0 {
+		return false
+	}
+
+	switch label.State {
+	case VadStateStartSpeeking:
+		c.segStart = c.frames
+	case VadStateStopSpeeking:
+		if c.segStart >= 0 {
+			c.segments = append(c.segments, VadDumpSegment{StartFrame: c.segStart, StopFrame: c.frames})
+			c.segStart = -1
+		}
+	}
+
+	c.labels = append(c.labels, *label)
+	c.packets = c.encodePacket(c.packets, pcm)
+	c.frames++
+	if len(c.labels) >= vadDumpBlockFrames {
+		c.flushBlock()
+	}
+	return true
+}
+
+func (c *vadDumpContainerWriter) write(b []byte) {
+	if c.file == nil {
+		return
+	}
+	if _, err := c.file.Write(b); err != nil {
+		fmt.Println("Failed to write dump file: ", err)
+	}
+	c.offset += int64(len(b))
+}
+
+func (c *vadDumpContainerWriter) flushBlock() {
+	n := len(c.labels)
+	if n == 0 {
+		return
+	}
+	firstFrame := c.frames - n
+
+	block := append(c.block[:0], vadDumpBlockMagic...)
+	block = binary.LittleEndian.AppendUint32(block, 0) // payload size, filled below
+	block = binary.LittleEndian.AppendUint32(block, uint32(firstFrame))
+	block = binary.LittleEndian.AppendUint16(block, uint16(n))
+	for i := range c.labels {
+		block = append(block, byte(int8(c.labels[i].State)))
+	}
+	for i := range c.labels {
+		block = append(block, byte(int8(c.labels[i].FarFieldFlag)))
+	}
+	block = appendVadDumpColumn(block, c.labels, func(l *VadDumpLabel) int { return l.VoiceProb })
+	block = appendVadDumpColumn(block, c.labels, func(l *VadDumpLabel) int { return l.Rms })
+	block = appendVadDumpColumn(block, c.labels, func(l *VadDumpLabel) int { return l.Pitch })
+	block = appendVadDumpColumn(block, c.labels, func(l *VadDumpLabel) int { return l.MusicProb })
+	block = append(block, c.packets...)
+	binary.LittleEndian.PutUint32(block[4:8], uint32(len(block)-vadDumpBlockHeaderSize))
+
+	c.blocks = append(c.blocks, vadDumpBlockIndex{firstFrame: firstFrame, frameCount: n, offset: c.offset})
+	c.write(block)
+	c.block = block
+	c.labels = c.labels[:0]
+	c.packets = c.packets[:0]
+}
+
+// close writes the pending block, the index and the trailer, then closes the file.
+func (c *vadDumpContainerWriter) close() {
+	c.flushBlock()
+	if c.segStart >= 0 && c.frames > 0 {
+		c.segments = append(c.segments, VadDumpSegment{StartFrame: c.segStart, StopFrame: c.frames - 1})
+		c.segStart = -1
+	}
+	if c.sampleRate != 0 {
+		indexOffset := c.offset
+		index := make([]byte, 0, 16*(len(c.blocks)+len(c.segments))+vadDumpTrailerSize)
+		index = binary.AppendUvarint(index, uint64(len(c.blocks)))
+		for _, b := range c.blocks {
+			index = binary.AppendUvarint(index, uint64(b.firstFrame))
+			index = binary.AppendUvarint(index, uint64(b.frameCount))
+			index = binary.AppendUvarint(index, uint64(b.offset))
+		}
+		index = binary.AppendUvarint(index, uint64(len(c.segments)))
+		for _, s := range c.segments {
+			index = binary.AppendUvarint(index, uint64(s.StartFrame))
+			index = binary.AppendUvarint(index, uint64(s.StopFrame))
+		}
+		index = binary.LittleEndian.AppendUint64(index, uint64(indexOffset))
+		index = append(index, vadDumpTrailerMagic...)
+		c.write(index)
+	}
+	if c.file != nil {
+		c.file.Close()
+		c.file = nil
+	}
+}
+
+func appendVadDumpColumn(dst []byte, labels []VadDumpLabel, value func(l *VadDumpLabel) int) []byte {
+	prev := 0
+	for i := range labels {
+		v := value(&labels[i])
+		dst = binary.AppendUvarint(dst, zigzagEncode(int64(v-prev)))
+		prev = v
+	}
+	return dst
+}
+
+// encodePacket encodes one frame of interleaved int16 pcm, each channel with the
+// best fixed linear predictor(as FLAC's fixed subframe) and rice coded residuals.
+func (c *vadDumpContainerWriter) encodePacket(dst []byte, pcm []byte) []byte {
+	n := len(pcm) / 2 / c.channels
+	dst = binary.AppendUvarint(dst, uint64(n))
+	if cap(c.samples) < n {
+		c.samples = make([]int32, n)
+	}
+	samples := c.samples[:n]
+	for ch := 0; ch < c.channels; ch++ {
+		for i := 0; i < n; i++ {
+			off := (i*c.channels + ch) * 2
+			samples[i] = int32(int16(binary.LittleEndian.Uint16(pcm[off:])))
+		}
+
+		order, sum := 0, uint64(0)
+		for o := 0; o <= 3 && o <= n; o++ {
+			s := uint64(0)
+			for i := o; i < n; i++ {
+				r := samples[i] - vadDumpPredict(samples, i, o)
+				if r < 0 {
+					r = -r
+				}
+				s += uint64(r)
+			}
+			if o == 0 || s < sum {
+				order, sum = o, s
+			}
+		}
+		k := 0
+		if residuals := n - order; residuals > 0 {
+			mean := sum / uint64(residuals)
+			for k < 24 && (uint64(1)<<(k+1)) <= mean {
+				k++
+			}
+		}
+
+		dst = append(dst, byte(order), byte(k))
+		for i := 0; i < order; i++ {
+			dst = binary.LittleEndian.AppendUint16(dst, uint16(int16(samples[i])))
+		}
+		c.bits.reset(dst)
+		for i := order; i < n; i++ {
+			u := zigzagEncode(int64(samples[i] - vadDumpPredict(samples, i, order)))
+			q := u >> uint(k)
+			if q < vadDumpRiceEscape {
+				c.bits.writeOnes(int(q))
+				c.bits.writeBits(0, 1)
+				c.bits.writeBits(u, uint(k))
+			} else {
+				c.bits.writeOnes(vadDumpRiceEscape)
+				c.bits.writeBits(u, 32)
+			}
+		}
+		dst = c.bits.flush()
+	}
+	return dst
+}
+
+// vadDumpPredict returns the fixed predictor of the given order for samples[i].
+func vadDumpPredict(s []int32, i int, order int) int32 {
+	switch order {
+	case 1:
+		return s[i-1]
+	case 2:
+		return 2*s[i-1] - s[i-2]
+	case 3:
+		return 3*s[i-1] - 3*s[i-2] + s[i-3]
+	}
+	return 0
+}
+
+func zigzagEncode(v int64) uint64 {
+	return uint64((v << 1) ^ (v >> 63))
+}
+
+func zigzagDecode(u uint64) int64 {
+	return int64(u>>1) ^ -int64(u&1)
+}
+
+type vadBitWriter struct {
+	buf []byte
+	acc uint64
+	n   uint
+}
+
+func (w *vadBitWriter) reset(buf []byte) {
+	w.buf = buf
+	w.acc = 0
+	w.n = 0
+}
+
+// writeBits writes the low bits(<= 32) of v, msb first.
+func (w *vadBitWriter) writeBits(v uint64, bits uint) {
+	if bits == 0 {
+		return
+	}
+	w.acc = w.acc<<bits | (v & (uint64(1)<<bits - 1))
+	w.n += bits
+	for w.n >= 8 {
+		w.n -= 8
+		w.buf = append(w.buf, byte(w.acc>>w.n))
+	}
+}
+
+func (w *vadBitWriter) writeOnes(count int) {
+	for count > 0 {
+		bits := min(count, 32)
+		w.writeBits(uint64(1)<<uint(bits)-1, uint(bits))
+		count -= bits
+	}
+}
+
+// flush pads the last byte with zero bits and returns the buffer.
+func (w *vadBitWriter) flush() []byte {
+	if w.n > 0 {
+		w.buf = append(w.buf, byte(w.acc<<(8-w.n)))
+	}
+	w.n = 0
+	w.acc = 0
+	return w.buf
+}
+
+type vadBitReader struct {
+	buf []byte
+	pos int
+	acc uint64
+	n   uint
+}
+
+var errVadDumpCorrupted = errors.New("corrupted vad dump block")
+
+func (r *vadBitReader) readBits(bits uint) (uint64, error) {
+	for r.n < bits {
+		if r.pos >= len(r.buf) {
+			return 0, errVadDumpCorrupted
+		}
+		r.acc = r.acc<<8 | uint64(r.buf[r.pos])
+		r.pos++
+		r.n += 8
+	}
+	r.n -= bits
+	return (r.acc >> r.n) & (uint64(1)<<bits - 1), nil
+}
+
+// VadDumpContainer reads a dump.vdc file; only the blocks that are asked for are read.
+type VadDumpContainer struct {
+	file       *os.File
+	SampleRate int
+	Channels   int
+	blocks     []vadDumpBlockIndex
+	segments   []VadDumpSegment
+}
+
+// OpenVadDumpContainer opens a dump.vdc file written by VadDump with VadDumpFormatCompact.
+func OpenVadDumpContainer(path string) (*VadDumpContainer, error) {
+	file, err := os.Open(path)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open vad dump container, %w", err)
+	}
+	c := &VadDumpContainer{file: file}
+	if err := c.load(); err != nil {
+		file.Close()
+		return nil, err
+	}
+	return c, nil
+}
+
+func (c *VadDumpContainer) load() error {
+	var header [vadDumpHeaderSize]byte
+	if _, err := c.file.ReadAt(header[:], 0); err != nil {
+		return fmt.Errorf("failed to read vad dump header, %w", err)
+	}
+	if string(header[0:4]) != string(vadDumpHeaderMagic) || header[4] != vadDumpContainerVersion {
+		return fmt.Errorf("not a vad dump container")
+	}
+	c.SampleRate = int(binary.LittleEndian.Uint32(header[5:9]))
+	c.Channels = int(header[9])
+	if c.SampleRate <= 0 || c.Channels <= 0 {
+		return fmt.Errorf("invalid vad dump header, sampleRate: %d, channels: %d", c.SampleRate, c.Channels)
+	}
+
+	info, err := c.file.Stat()
+	if err != nil {
+		return err
+	}
+	if c.loadIndex(info.Size()) == nil {
+		return nil
+	}
+	return c.scan(info.Size())
+}
+
+func (c *VadDumpContainer) loadIndex(size int64) error {
+	if size < vadDumpHeaderSize+vadDumpTrailerSize {
+		return errVadDumpCorrupted
+	}
+	var trailer [vadDumpTrailerSize]byte
+	if _, err := c.file.ReadAt(trailer[:], size-vadDumpTrailerSize); err != nil {
+		return err
+	}
+	indexOffset := int64(binary.LittleEndian.Uint64(trailer[0:8]))
+	if string(trailer[8:12]) != string(vadDumpTrailerMagic) || indexOffset < vadDumpHeaderSize || indexOffset > size-vadDumpTrailerSize {
+		return errVadDumpCorrupted
+	}
+	index := make([]byte, size-vadDumpTrailerSize-indexOffset)
+	if _, err := c.file.ReadAt(index, indexOffset); err != nil {
+		return err
+	}
+
+	pos := 0
+	next := func() (int, error) {
+		v, n := binary.Uvarint(index[pos:])
+		if n <= 0 {
+			return 0, errVadDumpCorrupted
+		}
+		pos += n
+		return int(v), nil
+	}
+	count, err := next()
+	if err != nil {
+		return err
+	}
+	blocks := make([]vadDumpBlockIndex, 0, count)
+	for i := 0; i < count; i++ {
+		var b vadDumpBlockIndex
+		var offset int
+		if b.firstFrame, err = next(); err != nil {
+			return err
+		}
+		if b.frameCount, err = next(); err != nil {
+			return err
+		}
+		if offset, err = next(); err != nil {
+			return err
+		}
+		b.offset = int64(offset)
+		blocks = append(blocks, b)
+	}
+	if count, err = next(); err != nil {
+		return err
+	}
+	segments := make([]VadDumpSegment, 0, count)
+	for i := 0; i < count; i++ {
+		var s VadDumpSegment
+		if s.StartFrame, err = next(); err != nil {
+			return err
+		}
+		if s.StopFrame, err = next(); err != nil {
+			return err
+		}
+		segments = append(segments, s)
+	}
+	c.blocks = blocks
+	c.segments = segments
+	return nil
+}
+
+// scan rebuilds the index from the block headers and state columns of a file without trailer.
+func (c *VadDumpContainer) scan(size int64) error {
+	c.blocks = c.blocks[:0]
+	c.segments = c.segments[:0]
+	segStart := -1
+	offset := int64(vadDumpHeaderSize)
+	var header [vadDumpBlockHeaderSize]byte
+	for offset+vadDumpBlockHeaderSize <= size {
+		if _, err := c.file.ReadAt(header[:], offset); err != nil {
+			break
+		}
+		payloadSize := int64(binary.LittleEndian.Uint32(header[4:8]))
+		n := int(binary.LittleEndian.Uint16(header[12:14]))
+		if string(header[0:4]) != string(vadDumpBlockMagic) || offset+vadDumpBlockHeaderSize+payloadSize > size || int64(n) > payloadSize {
+			break
+		}
+		b := vadDumpBlockIndex{
+			firstFrame: int(binary.LittleEndian.Uint32(header[8:12])),
+			frameCount: n,
+			offset:     offset,
+		}
+		states := make([]byte, n)
+		if _, err := c.file.ReadAt(states, offset+vadDumpBlockHeaderSize); err != nil {
+			break
+		}
+		for i, s := range states {
+			switch VadState(int8(s)) {
+			case VadStateStartSpeeking:
+				segStart = b.firstFrame + i
+			case VadStateStopSpeeking:
+				if segStart >= 0 {
+					c.segments = append(c.segments, VadDumpSegment{StartFrame: segStart, StopFrame: b.firstFrame + i})
+					segStart = -1
+				}
+			}
+		}
+		c.blocks = append(c.blocks, b)
+		offset += vadDumpBlockHeaderSize + payloadSize
+	}
+	if segStart >= 0 {
+		c.segments = append(c.segments, VadDumpSegment{StartFrame: segStart, StopFrame: c.Frames() - 1})
+	}
+	return nil
+}
+
+// Frames returns the number of 10ms frames in the container.
+func (c *VadDumpContainer) Frames() int {
+	if len(c.blocks) == 0 {
+		return 0
+	}
+	last := c.blocks[len(c.blocks)-1]
+	return last.firstFrame + last.frameCount
+}
+
+// Segments returns the vad segments recorded in the container.
+func (c *VadDumpContainer) Segments() []VadDumpSegment {
+	return c.segments
+}
+
+// ReadSegment reads the i-th vad segment plus preFrames frames before its start, which
+// covers the audio AudioVadV2 buffers before it decides to start.
+func (c *VadDumpContainer) ReadSegment(i int, preFrames int) ([]*VadReplayFrame, error) {
+	if i < 0 || i >= len(c.segments) {
+		return nil, fmt.Errorf("segment %d out of range [0, %d)", i, len(c.segments))
+	}
+	s := c.segments[i]
+	start := s.StartFrame - preFrames
+	if start < 0 {
+		start = 0
+	}
+	return c.ReadFrames(start, s.StopFrame-start+1)
+}
+
+// ReadFrames reads count frames from frame index start.
+func (c *VadDumpContainer) ReadFrames(start int, count int) ([]*VadReplayFrame, error) {
+	total := c.Frames()
+	if start < 0 || count < 0 || start+count > total {
+		return nil, fmt.Errorf("frames [%d, %d) out of range [0, %d)", start, start+count, total)
+	}
+	frames := make([]*VadReplayFrame, 0, count)
+	bi := sort.Search(len(c.blocks), func(i int) bool {
+		return c.blocks[i].firstFrame+c.blocks[i].frameCount > start
+	})
+	for ; bi < len(c.blocks) && len(frames) < count; bi++ {
+		blockFrames, err := c.readBlock(c.blocks[bi])
+		if err != nil {
+			return nil, err
+		}
+		for j, f := range blockFrames {
+			if c.blocks[bi].firstFrame+j >= start && len(frames) < count {
+				frames = append(frames, f)
+			}
+		}
+	}
+	return frames, nil
+}
+
+func (c *VadDumpContainer) readBlock(b vadDumpBlockIndex) ([]*VadReplayFrame, error) {
+	var header [vadDumpBlockHeaderSize]byte
+	if _, err := c.file.ReadAt(header[:], b.offset); err != nil {
+		return nil, fmt.Errorf("failed to read vad dump block, %w", err)
+	}
+	if string(header[0:4]) != string(vadDumpBlockMagic) {
+		return nil, errVadDumpCorrupted
+	}
+	payload := make([]byte, binary.LittleEndian.Uint32(header[4:8]))
+	if _, err := c.file.ReadAt(payload, b.offset+vadDumpBlockHeaderSize); err != nil && err != io.EOF {
+		return nil, fmt.Errorf("failed to read vad dump block, %w", err)
+	}
+	return decodeVadDumpBlock(payload, b.firstFrame, b.frameCount, c.SampleRate, c.Channels)
+}
+
+func decodeVadDumpBlock(payload []byte, firstFrame int, n int, sampleRate int, channels int) ([]*VadReplayFrame, error) {
+	if len(payload) < 2*n {
+		return nil, errVadDumpCorrupted
+	}
+	frames := make([]*VadReplayFrame, n)
+	for i := 0; i < n; i++ {
+		frames[i] = &VadReplayFrame{
+			Frame: &AudioFrame{
+				Type:           AudioFrameTypePCM16,
+				BytesPerSample: 2,
+				Channels:       channels,
+				SamplesPerSec:  sampleRate,
+				RenderTimeMs:   int64((firstFrame + i) * 10),
+				FarFieldFlag:   int(int8(payload[n+i])),
+			},
+			RefState: VadState(int8(payload[i])),
+		}
+	}
+	pos := 2 * n
+	for col := 0; col < 4; col++ {
+		prev := int64(0)
+		for i := 0; i < n; i++ {
+			u, m := binary.Uvarint(payload[pos:])
+			if m <= 0 {
+				return nil, errVadDumpCorrupted
+			}
+			pos += m
+			prev += zigzagDecode(u)
+			f := frames[i].Frame
+			switch col {
+			case 0:
+				f.VoiceProb = int(prev)
+			case 1:
+				f.Rms = int(prev)
+			case 2:
+				f.Pitch = int(prev)
+			case 3:
+				f.MusicProb = int(prev)
+			}
+		}
+	}
+
+	samples := make([]int32, 0, sampleRate/100)
+	for i := 0; i < n; i++ {
+		spc, m := binary.Uvarint(payload[pos:])
+		if m <= 0 || spc > uint64(len(payload)) {
+			return nil, errVadDumpCorrupted
+		}
+		pos += m
+		samplesPerChannel := int(spc)
+		pcm := make([]byte, samplesPerChannel*channels*2)
+		for ch := 0; ch < channels; ch++ {
+			var err error
+			samples, pos, err = decodeVadDumpChannel(payload, pos, samples[:0], samplesPerChannel)
+			if err != nil {
+				return nil, err
+			}
+			for j, s := range samples {
+				binary.LittleEndian.PutUint16(pcm[(j*channels+ch)*2:], uint16(int16(s)))
+			}
+		}
+		frames[i].Frame.SamplesPerChannel = samplesPerChannel
+		frames[i].Frame.Buffer = pcm
+	}
+	return frames, nil
+}
+
+func decodeVadDumpChannel(payload []byte, pos int, samples []int32, n int) ([]int32, int, error) {
+	if pos+2 > len(payload) {
+		return nil, pos, errVadDumpCorrupted
+	}
+	order, k := int(payload[pos]), uint(payload[pos+1])
+	pos += 2
+	if order > 3 || order > n || pos+2*order > len(payload) {
+		return nil, pos, errVadDumpCorrupted
+	}
+	for i := 0; i < order; i++ {
+		samples = append(samples, int32(int16(binary.LittleEndian.Uint16(payload[pos:]))))
+		pos += 2
+	}
+	r := vadBitReader{buf: payload, pos: pos}
+	for i := order; i < n; i++ {
+		q := 0
+		for q < vadDumpRiceEscape {
+			bit, err := r.readBits(1)
+			if err != nil {
+				return nil, pos, err
+			}
+			if bit == 0 {
+				break
+			}
+			q++
+		}
+		var u uint64
+		var err error
+		if q == vadDumpRiceEscape {
+			u, err = r.readBits(32)
+		} else {
+			var low uint64
+			low, err = r.readBits(k)
+			u = uint64(q)<<k | low
+		}
+		if err != nil {
+			return nil, pos, err
+		}
+		samples = append(samples, int32(zigzagDecode(u))+vadDumpPredict(samples, i, order))
+	}
+	return samples, r.pos, nil
+}
+
+// Close closes the container file.
+func (c *VadDumpContainer) Close() error {
+	if c.file == nil {
+		return nil
+	}
+	err := c.file.Close()
+	c.file = nil
+	return err
+}
@@ -0,0 +1,369 @@
+package agoraservice
+
+import (
+	"encoding/binary"
+	"fmt"
+	"os"
+	"sync/atomic"
+	"time"
+)
+
+/*
+* vadDumpWriter is the asynchronous backend of VadDump.
+* VadDump.Write runs on the audio callback, so it only copies the frame into a
+* per-dump ring and returns; a background goroutine drains the ring every
+* vadDumpFlushInterval (or earlier when the ring is half full) and writes each
+* file with one large write. When the ring is full the frame is dropped and
+* counted, the callback is never blocked by the disk.
+* with VadDumpFormatCompact the frames are encoded into dump.vdc by the same
+* goroutine instead, ref to vad_dump_container.go.
+ */
+
+// VadDumpLabelRecordSize is the size of one record in label.bin.
+// layout, little endian:
+// offset 0:  uint32 frame count
+// offset 4:  uint16 vad section count
+// offset 6:  int8   vad state
+// offset 7:  int8   far field flag
+// offset 8:  int16  voice prob
+// offset 10: int16  rms
+// offset 12: int16  pitch
+// offset 14: int16  music prob
+const VadDumpLabelRecordSize = 16
+
+const (
+	vadDumpRingRecords   = 1024    // ~10s of 10ms frames
+	vadDumpRingBytes     = 2 << 20 // ~30s of 16k mono source + vad pcm
+	vadDumpFlushInterval = 100 * time.Millisecond
+	vadDumpBatchSize     = 64 * 1024
+)
+
+// VadDumpLabel is one per-frame label record of label.bin.
+type VadDumpLabel struct {
+	FrameCount   uint32
+	SectionCount uint16
+	State        VadState
+	FarFieldFlag int
+	VoiceProb    int
+	Rms          int
+	Pitch        int
+	MusicProb    int
+}
+
+func (l *VadDumpLabel) encode(b []byte) {
+	binary.LittleEndian.PutUint32(b[0:4], l.FrameCount)
+	binary.LittleEndian.PutUint16(b[4:6], l.SectionCount)
+	b[6] = byte(int8(l.State))
+	b[7] = byte(int8(l.FarFieldFlag))
+	binary.LittleEndian.PutUint16(b[8:10], uint16(int16(l.VoiceProb)))
+	binary.LittleEndian.PutUint16(b[10:12], uint16(int16(l.Rms)))
+	binary.LittleEndian.PutUint16(b[12:14], uint16(int16(l.Pitch)))
+	binary.LittleEndian.PutUint16(b[14:16], uint16(int16(l.MusicProb)))
+}
+
+// DecodeVadDumpLabel decodes one VadDumpLabelRecordSize bytes record of label.bin.
+func DecodeVadDumpLabel(b []byte) VadDumpLabel {
+	return VadDumpLabel{
+		FrameCount:   binary.LittleEndian.Uint32(b[0:4]),
+		SectionCount: binary.LittleEndian.Uint16(b[4:6]),
+		State:        VadState(int8(b[6])),
+		FarFieldFlag: int(int8(b[7])),
+		VoiceProb:    int(int16(binary.LittleEndian.Uint16(b[8:10]))),
+		Rms:          int(int16(binary.LittleEndian.Uint16(b[10:12]))),
+		Pitch:        int(int16(binary.LittleEndian.Uint16(b[12:14]))),
+		MusicProb:    int(int16(binary.LittleEndian.Uint16(b[14:16]))),
+	}
+}
+
+// one frame in the ring; the pcm of source and vad is stored back to back in ring.data
+type vadDumpRecord struct {
+	label      VadDumpLabel
+	dataPos    uint64
+	srcLen     int
+	vadLen     int
+	vadState   VadState // VadStateInvalid if the frame has no vad output
+	sampleRate int
+	channels   int
+}
+
+// vadDumpRing is a single-producer single-consumer ring, like LockFreeRingBuffer,
+// but carries variable-length pcm next to a fixed number of records.
+type vadDumpRing struct {
+	records  []vadDumpRecord
+	recMask  uint64
+	data     []byte
+	dataMask uint64
+
+	_pad0        [8]uint64
+	writePos     uint64 // only written by producer
+	dataWritePos uint64
+	_pad1        [8]uint64
+	readPos      uint64 // only written by consumer
+	dataReadPos  uint64
+	_pad2        [8]uint64
+}
+
+func newVadDumpRing(records int, dataBytes int) *vadDumpRing {
+	return &vadDumpRing{
+		records:  make([]vadDumpRecord, records),
+		recMask:  uint64(records - 1),
+		data:     make([]byte, dataBytes),
+		dataMask: uint64(dataBytes - 1),
+	}
+}
+
+// push copies src and vad into the ring, returns false if there is no room.
+func (r *vadDumpRing) push(label *VadDumpLabel, frame *AudioFrame, vad []byte, vadState VadState) bool {
+	src := frame.Buffer
+	w := r.writePos
+	if w-atomic.LoadUint64(&r.readPos) >= uint64(len(r.records)) {
+		return false
+	}
+	need := uint64(len(src) + len(vad))
+	dw := r.dataWritePos
+	if dw+need-atomic.LoadUint64(&r.dataReadPos) > uint64(len(r.data)) {
+		return false
+	}
+	r.copyIn(dw, src)
+	r.copyIn(dw+uint64(len(src)), vad)
+
+	rec := &r.records[w&r.recMask]
+	rec.label = *label
+	rec.dataPos = dw
+	rec.srcLen = len(src)
+	rec.vadLen = len(vad)
+	rec.vadState = vadState
+	rec.sampleRate = frame.SamplesPerSec
+	rec.channels = frame.Channels
+
+	r.dataWritePos = dw + need
+	atomic.StoreUint64(&r.writePos, w+1)
+	return true
+}
+
+func (r *vadDumpRing) copyIn(pos uint64, b []byte) {
+	n := copy(r.data[pos&r.dataMask:], b)
+	if n < len(b) {
+		copy(r.data, b[n:])
+	}
+}
+
+func (r *vadDumpRing) appendData(dst []byte, pos uint64, length int) []byte {
+	off := pos & r.dataMask
+	end := off + uint64(length)
+	if end <= uint64(len(r.data)) {
+		return append(dst, r.data[off:end]...)
+	}
+	dst = append(dst, r.data[off:]...)
+	return append(dst, r.data[:end-uint64(len(r.data))]...)
+}
+
+func (r *vadDumpRing) size() int {
+	return int(atomic.LoadUint64(&r.writePos) - atomic.LoadUint64(&r.readPos))
+}
+
+type vadDumpWriter struct {
+	path   string
+	ring   *vadDumpRing
+	notify chan struct{}
+	stop   chan struct{}
+	done   chan struct{}
+
+	droppedFrames uint64
+	droppedBytes  uint64
+
+	// owned by the flush goroutine
+	container      *vadDumpContainerWriter
+	sourceFile     *os.File
+	labelFile      *os.File
+	voiceProbFile  *os.File
+	rmsFile        *os.File
+	pitchFile      *os.File
+	vadFile        *os.File
+	vadCount       int
+	sourceBatch    []byte
+	labelBatch     []byte
+	voiceProbBatch []byte
+	rmsBatch       []byte
+	pitchBatch     []byte
+	vadBatch       []byte
+}
+
+func openVadDumpFile(path string, name string) *os.File {
+	file, err := os.OpenFile(fmt.Sprintf("%s/%s", path, name), os.O_CREATE|os.O_TRUNC|os.O_WRONLY, 0644)
+	if err != nil {
+		fmt.Printf("Failed to create dump file %s: %v\n", name, err)
+		return nil
+	}
+	return file
+}
+
+func newVadDumpWriter(path string, format VadDumpFormat) *vadDumpWriter {
+	w := &vadDumpWriter{
+		path:   path,
+		ring:   newVadDumpRing(vadDumpRingRecords, vadDumpRingBytes),
+		notify: make(chan struct{}, 1),
+		stop:   make(chan struct{}),
+		done:   make(chan struct{}),
+	}
+	if format == VadDumpFormatCompact {
+		w.container = newVadDumpContainerWriter(openVadDumpFile(path, vadDumpContainerName))
+	} else {
+		w.sourceFile = openVadDumpFile(path, "source.pcm")
+		w.labelFile = openVadDumpFile(path, "label.bin")
+		w.voiceProbFile = openVadDumpFile(path, "voice_prob.txt")
+		w.rmsFile = openVadDumpFile(path, "rms.txt")
+		w.pitchFile = openVadDumpFile(path, "pitch.txt")
+		w.sourceBatch = make([]byte, 0, vadDumpBatchSize)
+		w.labelBatch = make([]byte, 0, vadDumpRingRecords*VadDumpLabelRecordSize)
+		w.voiceProbBatch = make([]byte, 0, vadDumpBatchSize)
+		w.rmsBatch = make([]byte, 0, vadDumpBatchSize)
+		w.pitchBatch = make([]byte, 0, vadDumpBatchSize)
+		w.vadBatch = make([]byte, 0, vadDumpBatchSize)
+	}
+	go w.run()
+	return w
+}
+
+// push is called from the audio callback, it never blocks.
+func (w *vadDumpWriter) push(label *VadDumpLabel, frame *AudioFrame, vad []byte, vadState VadState) bool {
+	if !w.ring.push(label, frame, vad, vadState) {
+		atomic.AddUint64(&w.droppedFrames, 1)
+		atomic.AddUint64(&w.droppedBytes, uint64(len(frame.Buffer)+len(vad)))
+		w.wakeup()
+		return false
+	}
+	if w.ring.size() >= vadDumpRingRecords/2 {
+		w.wakeup()
+	}
+	return true
+}
+
+func (w *vadDumpWriter) wakeup() {
+	select {
+	case w.notify <- struct{}{}:
+	default:
+	}
+}
+
+func (w *vadDumpWriter) run() {
+	defer close(w.done)
+	ticker := time.NewTicker(vadDumpFlushInterval)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-ticker.C:
+		case <-w.notify:
+		case <-w.stop:
+			w.flush()
+			w.closeFiles()
+			return
+		}
+		w.flush()
+	}
+}
+
+// close stops the flush goroutine after everything in the ring is written.
+func (w *vadDumpWriter) close() {
+	close(w.stop)
+	<-w.done
+}
+
+func (w *vadDumpWriter) flush() {
+	r := w.ring
+	readPos := atomic.LoadUint64(&r.readPos)
+	writePos := atomic.LoadUint64(&r.writePos)
+	for ; readPos < writePos; readPos++ {
+		rec := &r.records[readPos&r.recMask]
+		if w.container != nil {
+			w.sourceBatch = r.appendData(w.sourceBatch[:0], rec.dataPos, rec.srcLen)
+			if !w.container.writeFrame(&rec.label, w.sourceBatch, rec.sampleRate, rec.channels) {
+				atomic.AddUint64(&w.droppedFrames, 1)
+				atomic.AddUint64(&w.droppedBytes, uint64(rec.srcLen))
+			}
+			atomic.StoreUint64(&r.dataReadPos, rec.dataPos+uint64(rec.srcLen+rec.vadLen))
+			atomic.StoreUint64(&r.readPos, readPos+1)
+			continue
+		}
+
+		w.sourceBatch = r.appendData(w.sourceBatch, rec.dataPos, rec.srcLen)
+		var label [VadDumpLabelRecordSize]byte
+		rec.label.encode(label[:])
+		w.labelBatch = append(w.labelBatch, label[:]...)
+		// voice prob, rms and pitch are dumped as waveforms aligned with source.pcm
+		w.voiceProbBatch = appendItemData(w.voiceProbBatch, int16(rec.label.VoiceProb*127*127), rec.srcLen)
+		w.rmsBatch = appendItemData(w.rmsBatch, int16(rec.label.Rms*127), rec.srcLen)
+		w.pitchBatch = appendItemData(w.pitchBatch, int16(rec.label.Pitch), rec.srcLen)
+
+		switch rec.vadState {
+		case VadStateStartSpeeking:
+			w.closeVadFile()
+			w.vadFile = openVadDumpFile(w.path, fmt.Sprintf("vad_%d.pcm", w.vadCount))
+			w.vadCount++
+			w.vadBatch = r.appendData(w.vadBatch, rec.dataPos+uint64(rec.srcLen), rec.vadLen)
+		case VadStateSpeeking:
+			w.vadBatch = r.appendData(w.vadBatch, rec.dataPos+uint64(rec.srcLen), rec.vadLen)
+		case VadStateStopSpeeking:
+			w.closeVadFile()
+		}
+
+		atomic.StoreUint64(&r.dataReadPos, rec.dataPos+uint64(rec.srcLen+rec.vadLen))
+		atomic.StoreUint64(&r.readPos, readPos+1)
+	}
+
+	if w.container != nil {
+		return
+	}
+	writeVadDumpBatch(w.sourceFile, &w.sourceBatch)
+	writeVadDumpBatch(w.labelFile, &w.labelBatch)
+	writeVadDumpBatch(w.voiceProbFile, &w.voiceProbBatch)
+	writeVadDumpBatch(w.rmsFile, &w.rmsBatch)
+	writeVadDumpBatch(w.pitchFile, &w.pitchBatch)
+	writeVadDumpBatch(w.vadFile, &w.vadBatch)
+}
+
+func (w *vadDumpWriter) closeVadFile() {
+	writeVadDumpBatch(w.vadFile, &w.vadBatch)
+	if w.vadFile != nil {
+		w.vadFile.Close()
+		w.vadFile = nil
+	}
+}
+
+func (w *vadDumpWriter) closeFiles() {
+	if w.container != nil {
+		w.container.close()
+		w.container = nil
+	}
+	w.closeVadFile()
+	for _, file := range []*os.File{w.sourceFile, w.labelFile, w.voiceProbFile, w.rmsFile, w.pitchFile} {
+		if file != nil {
+			file.Close()
+		}
+	}
+	w.sourceFile = nil
+	w.labelFile = nil
+	w.voiceProbFile = nil
+	w.rmsFile = nil
+	w.pitchFile = nil
+}
+
+// writeVadDumpBatch writes the batch with one write and resets it; the batch is
+// dropped if file is nil(e.g. the file failed to open).
+func writeVadDumpBatch(file *os.File, batch *[]byte) {
+	if file != nil && len(*batch) > 0 {
+		if _, err := file.Write(*batch); err != nil {
+			fmt.Println("Failed to write dump file: ", err)
+		}
+	}
+	*batch = (*batch)[:0]
+}
+
+// appendItemData appends value repeated over lenInBytes bytes of int16 samples.
+func appendItemData(dst []byte, value int16, lenInBytes int) []byte {
+	count := lenInBytes / 2
+	for i := 0; i < count; i++ {
+		dst = append(dst, byte(value), byte(uint16(value)>>8))
+	}
+	return dst
+}
@@ -0,0 +1,41 @@
+#include <stdint.h>
+#include <string.h>
+#include "video_analysis_cgo.h"
+
+// the row sums are contiguous byte reductions, which the compiler turns into simd at -O3.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("O3")
+#endif
+
+static inline uint32_t sum_bytes(const uint8_t* p, int n) {
+  uint32_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += p[i];
+  }
+  return sum;
+}
+
+void cgo_luma_signature(const uint8_t* y, int y_stride, int width, int height, int grid_width, int grid_height,
+                        int row_step, uint32_t* block_sums, uint32_t* block_counts, uint32_t* hist) {
+  memset(block_sums, 0, sizeof(uint32_t) * grid_width * grid_height);
+  memset(block_counts, 0, sizeof(uint32_t) * grid_width * grid_height);
+  memset(hist, 0, sizeof(uint32_t) * CGO_LUMA_HIST_BINS);
+  if (row_step < 1) {
+    row_step = 1;
+  }
+  for (int row = row_step / 2; row < height; row += row_step) {
+    const uint8_t* line = y + (int64_t)row * y_stride;
+    const int by = row * grid_height / height;
+    uint32_t* sums = block_sums + by * grid_width;
+    uint32_t* counts = block_counts + by * grid_width;
+    for (int bx = 0; bx < grid_width; bx++) {
+      const int x0 = bx * width / grid_width;
+      const int x1 = (bx + 1) * width / grid_width;
+      sums[bx] += sum_bytes(line + x0, x1 - x0);
+      counts[bx] += x1 - x0;
+    }
+    for (int x = 0; x < width; x += 4) {
+      hist[line[x] >> 2]++;
+    }
+  }
+}
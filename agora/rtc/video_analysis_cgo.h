@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// luma signature of a frame for change detection, see video_change_detector.go.
+#define CGO_LUMA_HIST_BINS 64
+
+// sums the y plane into grid_width x grid_height block sums, reading one row out of row_step, and counts a
+// CGO_LUMA_HIST_BINS bins histogram of every 4th pixel of those rows.
+// block_sums has grid_width * grid_height entries and block_counts the number of pixels summed per block.
+extern void cgo_luma_signature(const uint8_t* y, int y_stride, int width, int height, int grid_width,
+                               int grid_height, int row_step, uint32_t* block_sums, uint32_t* block_counts,
+                               uint32_t* hist);
@@ -0,0 +1,50 @@
+//go:build linux
+
+package agoraservice
+
+import (
+	"os"
+	"syscall"
+)
+
+const hugePageSize = 2 << 20
+
+// allocHugePageBuffer maps anonymous memory rounded up to 2MB and asks for transparent huge pages.
+// returns nil if the mapping failed, the caller falls back to the go heap.
+func allocHugePageBuffer(size int) []byte {
+	length := (size + hugePageSize - 1) &^ (hugePageSize - 1)
+	mapping, err := syscall.Mmap(-1, 0, length, syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_ANON|syscall.MAP_PRIVATE)
+	if err != nil {
+		return nil
+	}
+	// best effort, thp may be disabled on the host
+	syscall.Madvise(mapping, syscall.MADV_HUGEPAGE)
+	return mapping
+}
+
+func freeHugePageBuffer(mapping []byte) {
+	syscall.Munmap(mapping)
+}
+
+// mapFileReadOnly maps the whole file read only, the mapping is shared by all the readers of the file.
+func mapFileReadOnly(path string) ([]byte, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	info, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+	if info.Size() == 0 {
+		return []byte{}, nil
+	}
+	return syscall.Mmap(int(f.Fd()), 0, int(info.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+}
+
+func unmapFile(data []byte) {
+	if len(data) > 0 {
+		syscall.Munmap(data)
+	}
+}
@@ -0,0 +1,21 @@
+//go:build !linux
+
+package agoraservice
+
+import "os"
+
+// huge pages are only supported on linux, buffers come from the go heap.
+func allocHugePageBuffer(size int) []byte {
+	return nil
+}
+
+func freeHugePageBuffer(mapping []byte) {
+}
+
+// mapFileReadOnly reads the whole file into the go heap where mmap is not used.
+func mapFileReadOnly(path string) ([]byte, error) {
+	return os.ReadFile(path)
+}
+
+func unmapFile(data []byte) {
+}
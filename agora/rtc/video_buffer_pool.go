@@ -0,0 +1,256 @@
+package agoraservice
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+/*
+* VideoBufferPool recycles video frame buffers, keyed by (format, width, height, stride).
+* the shared pool(GetVideoBufferPool) is used by both paths:
+* receive: GoVideoFrame copies the Y/U/V planes into one pooled buffer; call VideoFrame.Release
+*   when done with the frame to recycle it, a frame which is never released is garbage collected.
+* send: VideoFrameSender.RentVideoFrame returns a frame with a pooled Buffer, fill it and call
+*   SendVideoFrame, the buffer goes back to the pool after agora_video_frame_sender_send returns.
+* with EnableHugePages, the rented send buffers of 1080p and larger are backed by anonymous mmap memory
+* with MADV_HUGEPAGE(linux only, ignored elsewhere), which reduces tlb misses when copying planes. they are
+* kept apart from the heap buffers, the receive path only uses heap memory: a received plane may outlive
+* its frame in user code, only the gc can tell when it's unused. a rented mapping is unmapped only when it
+* leaves the pool, so a rented frame must be sent or released, it's not garbage collected.
+* usage:
+* frame := sender.RentVideoFrame(VideoPixelI420, 1280, 720, 1280)
+* fillI420(frame.Buffer)
+* sender.SendVideoFrame(frame) // frame.Buffer must not be used after this
+ */
+
+// VideoBufferKey identifies buffers of the same layout, Stride is in pixels as ExternalVideoFrame.Stride.
+type VideoBufferKey struct {
+	Format VideoPixelFormat
+	Width  int
+	Height int
+	Stride int
+}
+
+// VideoBuffer is a buffer rented from a VideoBufferPool.
+type VideoBuffer struct {
+	Data    []byte
+	key     VideoBufferKey
+	pool    *VideoBufferPool
+	mapping []byte // the whole mmap region if backed by huge pages, never freed while rented
+	inPool  bool
+}
+
+// Release returns the buffer to its pool; Data must not be used after Release.
+func (b *VideoBuffer) Release() {
+	if b == nil || b.pool == nil {
+		return
+	}
+	b.pool.put(b)
+}
+
+// VideoBufferPoolStats are the counters of a VideoBufferPool.
+type VideoBufferPoolStats struct {
+	Gets            uint64 // buffers rented
+	Hits            uint64 // rented buffers served from the pool
+	Puts            uint64 // buffers returned
+	Drops           uint64 // returned buffers dropped because the pool was full
+	FreeBytes       int64  // bytes held by the free buffers
+	HugePageBuffers int64  // live buffers backed by huge pages
+}
+
+// videoBufferPoolKey keeps the huge page buffers apart, so they are only rented by the send path.
+type videoBufferPoolKey struct {
+	VideoBufferKey
+	mapped bool
+}
+
+type VideoBufferPool struct {
+	mu        sync.Mutex
+	free      map[videoBufferPoolKey][]*VideoBuffer
+	freeBytes int64
+	maxPerKey int
+	maxBytes  int64
+
+	hugePage        bool
+	hugePageMinSize int
+
+	gets            uint64
+	hits            uint64
+	puts            uint64
+	drops           uint64
+	hugePageBuffers int64
+}
+
+const (
+	defaultVideoBufferPerKey = 4
+	defaultVideoBufferBytes  = 256 << 20
+	// 1920x1080 I420
+	videoBufferHugePageMinSize = 1920 * 1080 * 3 / 2
+)
+
+var defaultVideoBufferPool = NewVideoBufferPool(defaultVideoBufferPerKey, defaultVideoBufferBytes)
+
+// GetVideoBufferPool returns the pool shared by the receive and send paths.
+func GetVideoBufferPool() *VideoBufferPool {
+	return defaultVideoBufferPool
+}
+
+// NewVideoBufferPool creates a pool which keeps at most maxPerKey free buffers per key, and maxBytes in total.
+func NewVideoBufferPool(maxPerKey int, maxBytes int64) *VideoBufferPool {
+	if maxPerKey <= 0 {
+		maxPerKey = defaultVideoBufferPerKey
+	}
+	if maxBytes <= 0 {
+		maxBytes = defaultVideoBufferBytes
+	}
+	return &VideoBufferPool{
+		free:            make(map[videoBufferPoolKey][]*VideoBuffer),
+		maxPerKey:       maxPerKey,
+		maxBytes:        maxBytes,
+		hugePageMinSize: videoBufferHugePageMinSize,
+	}
+}
+
+// EnableHugePages backs new rented send buffers of 1080p and larger with huge pages, only on linux.
+func (p *VideoBufferPool) EnableHugePages(enable bool) {
+	p.mu.Lock()
+	p.hugePage = enable
+	p.mu.Unlock()
+}
+
+// VideoBufferSize returns the bytes of a frame with the given layout, or 0 if the format is not supported.
+// chroma planes are assumed to have half of the luma stride, as the sdk does.
+func VideoBufferSize(format VideoPixelFormat, width int, height int, stride int) int {
+	if width <= 0 || height <= 0 || stride < width {
+		return 0
+	}
+	chromaStride := (stride + 1) / 2
+	chromaHeight := (height + 1) / 2
+	switch format {
+	case VideoPixelI420:
+		return stride*height + 2*chromaStride*chromaHeight
+	case VideoPixelI422:
+		return stride*height + 2*chromaStride*height
+	case VideoPixelI010:
+		return 2 * (stride*height + 2*chromaStride*chromaHeight)
+	case VideoPixelNV12, VideoPixelNV21:
+		return stride*height + 2*chromaStride*chromaHeight
+	case VideoPixelBGRA, VideoPixelRGBA:
+		return 4 * stride * height
+	}
+	return 0
+}
+
+// Rent returns a buffer of VideoBufferSize bytes for key, or nil if the format is not supported.
+func (p *VideoBufferPool) Rent(key VideoBufferKey) *VideoBuffer {
+	size := VideoBufferSize(key.Format, key.Width, key.Height, key.Stride)
+	if size <= 0 {
+		return nil
+	}
+	return p.get(key, size, true)
+}
+
+// get returns a buffer for key with len(Data) == size, backed by huge pages if allowed and enabled.
+// the receive path must not allow them, see the comment of the file.
+func (p *VideoBufferPool) get(key VideoBufferKey, size int, allowHugePage bool) *VideoBuffer {
+	atomic.AddUint64(&p.gets, 1)
+	p.mu.Lock()
+	hugePage := allowHugePage && p.hugePage && size >= p.hugePageMinSize
+	poolKey := videoBufferPoolKey{VideoBufferKey: key, mapped: hugePage}
+	list := p.free[poolKey]
+	for i := len(list) - 1; i >= 0; i-- {
+		b := list[i]
+		if cap(b.Data) < size {
+			continue
+		}
+		list[i] = list[len(list)-1]
+		list[len(list)-1] = nil
+		p.free[poolKey] = list[:len(list)-1]
+		p.freeBytes -= int64(cap(b.Data))
+		b.inPool = false
+		p.mu.Unlock()
+		atomic.AddUint64(&p.hits, 1)
+		b.Data = b.Data[:size]
+		return b
+	}
+	p.mu.Unlock()
+
+	b := &VideoBuffer{key: key, pool: p}
+	if hugePage {
+		if mapping := allocHugePageBuffer(size); mapping != nil {
+			b.mapping = mapping
+			b.Data = mapping[:size:size]
+			atomic.AddInt64(&p.hugePageBuffers, 1)
+			return b
+		}
+	}
+	b.Data = make([]byte, size)
+	return b
+}
+
+func (p *VideoBufferPool) put(b *VideoBuffer) {
+	atomic.AddUint64(&p.puts, 1)
+	p.mu.Lock()
+	if b.inPool {
+		p.mu.Unlock()
+		return
+	}
+	poolKey := videoBufferPoolKey{VideoBufferKey: b.key, mapped: b.mapping != nil}
+	list := p.free[poolKey]
+	if len(list) >= p.maxPerKey || p.freeBytes+int64(cap(b.Data)) > p.maxBytes {
+		p.mu.Unlock()
+		atomic.AddUint64(&p.drops, 1)
+		p.drop(b)
+		return
+	}
+	b.inPool = true
+	p.free[poolKey] = append(list, b)
+	p.freeBytes += int64(cap(b.Data))
+	p.mu.Unlock()
+}
+
+func (p *VideoBufferPool) drop(b *VideoBuffer) {
+	// the buffer is back from its user, so its mapping is unused
+	p.freeMapping(b)
+	b.Data = nil
+	b.pool = nil
+}
+
+func (p *VideoBufferPool) freeMapping(b *VideoBuffer) {
+	if b.mapping == nil {
+		return
+	}
+	freeHugePageBuffer(b.mapping)
+	b.mapping = nil
+	atomic.AddInt64(&p.hugePageBuffers, -1)
+}
+
+// Purge drops all free buffers, e.g. after the resolution of all streams changed.
+func (p *VideoBufferPool) Purge() {
+	p.mu.Lock()
+	free := p.free
+	p.free = make(map[videoBufferPoolKey][]*VideoBuffer)
+	p.freeBytes = 0
+	p.mu.Unlock()
+	for _, list := range free {
+		for _, b := range list {
+			b.inPool = false
+			p.drop(b)
+		}
+	}
+}
+
+// Stats returns the counters of the pool.
+func (p *VideoBufferPool) Stats() VideoBufferPoolStats {
+	p.mu.Lock()
+	freeBytes := p.freeBytes
+	p.mu.Unlock()
+	return VideoBufferPoolStats{
+		Gets:            atomic.LoadUint64(&p.gets),
+		Hits:            atomic.LoadUint64(&p.hits),
+		Puts:            atomic.LoadUint64(&p.puts),
+		Drops:           atomic.LoadUint64(&p.drops),
+		FreeBytes:       freeBytes,
+		HugePageBuffers: atomic.LoadInt64(&p.hugePageBuffers),
+	}
+}
@@ -0,0 +1,220 @@
+package agoraservice
+
+// #cgo CFLAGS: -I${SRCDIR}/../headers/include/c/api2 -I${SRCDIR}/../headers/include/c/base
+// #include "video_analysis_cgo.h"
+import "C"
+import (
+	"sync"
+	"unsafe"
+)
+
+/*
+* VideoChangeDetector skips the frames of a remote user which are nearly identical to the last frame that
+* was let through, e.g. before running inference on a talking head stream.
+* a frame is summarized by a luma signature(video_analysis_cgo.c): the mean luma of a grid of blocks and a
+* 64 bins histogram, computed on a subset of the rows of the Y plane, in well under 100us for 1080p.
+* the change score is the larger of the mean absolute block difference(0..1 of full scale) and the
+* histogram distance(0..1), against the last accepted frame, so a slow drift is accepted eventually.
+* usage, inside OnFrame(with BorrowFrame, nothing is copied for the skipped frames):
+* detector := NewVideoChangeDetector(&VideoChangeDetectorConfig{Threshold: 0.03, MaxSkip: 30})
+* OnFrame: func(channelId string, userId string, frame *VideoFrame) bool {
+*     if ok, _ := detector.Accept(userId, frame); !ok {
+*         return true
+*     }
+*     frame.ToTensor(tensor, &opts)
+*     ...
+* }
+ */
+
+type VideoChangeDetectorConfig struct {
+	GridWidth  int     // blocks per row, default 32
+	GridHeight int     // blocks per column, default 18
+	Threshold  float64 // frames scoring below are skipped, default 0.03
+	MaxSkip    int     // accept a frame after this many consecutive skips anyway, 0: never
+}
+
+// VideoChangeStats are the counters of one uid.
+type VideoChangeStats struct {
+	Accepted  uint64
+	Skipped   uint64
+	LastScore float64
+}
+
+type videoChangeSignature struct {
+	blocks []float32 // mean luma per block
+	hist   []float32 // normalized histogram
+}
+
+type videoChangeState struct {
+	mu        sync.Mutex
+	reference videoChangeSignature // last accepted frame
+	current   videoChangeSignature
+	hasRef    bool
+	skips     int
+	stats     VideoChangeStats
+	// scratch of cgo_luma_signature
+	sums   []uint32
+	counts []uint32
+	hist   [C.CGO_LUMA_HIST_BINS]uint32
+}
+
+type VideoChangeDetector struct {
+	config VideoChangeDetectorConfig
+	states sync.Map // uid string -> *videoChangeState
+}
+
+// rows read per frame, the row step is chosen so that about this many rows are summed
+const videoChangeSampleRows = 128
+
+func NewVideoChangeDetector(config *VideoChangeDetectorConfig) *VideoChangeDetector {
+	cfg := VideoChangeDetectorConfig{}
+	if config != nil {
+		cfg = *config
+	}
+	if cfg.GridWidth <= 0 {
+		cfg.GridWidth = 32
+	}
+	if cfg.GridHeight <= 0 {
+		cfg.GridHeight = 18
+	}
+	if cfg.Threshold <= 0 {
+		cfg.Threshold = 0.03
+	}
+	return &VideoChangeDetector{config: cfg}
+}
+
+func (d *VideoChangeDetector) state(uid string) *videoChangeState {
+	if s, ok := d.states.Load(uid); ok {
+		return s.(*videoChangeState)
+	}
+	n := d.config.GridWidth * d.config.GridHeight
+	s := &videoChangeState{
+		reference: videoChangeSignature{blocks: make([]float32, n), hist: make([]float32, C.CGO_LUMA_HIST_BINS)},
+		current:   videoChangeSignature{blocks: make([]float32, n), hist: make([]float32, C.CGO_LUMA_HIST_BINS)},
+		sums:      make([]uint32, n),
+		counts:    make([]uint32, n),
+	}
+	actual, _ := d.states.LoadOrStore(uid, s)
+	return actual.(*videoChangeState)
+}
+
+// Score returns the change of frame against the last accepted frame of uid, in 0..1, without accepting it.
+// returns 1 for the first frame of uid, and -1 if the frame has no Y plane.
+func (d *VideoChangeDetector) Score(uid string, frame *VideoFrame) float64 {
+	s := d.state(uid)
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return d.score(s, frame)
+}
+
+// Accept scores frame and returns true if it should be processed: the first frame of uid, a score at or
+// above Threshold, or MaxSkip frames skipped in a row. an accepted frame becomes the reference of uid.
+// a frame without Y plane is always accepted.
+func (d *VideoChangeDetector) Accept(uid string, frame *VideoFrame) (bool, float64) {
+	s := d.state(uid)
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	score := d.score(s, frame)
+	if score < 0 {
+		return true, score
+	}
+	s.stats.LastScore = score
+	if score < d.config.Threshold && (d.config.MaxSkip <= 0 || s.skips < d.config.MaxSkip) {
+		s.skips++
+		s.stats.Skipped++
+		return false, score
+	}
+	s.reference, s.current = s.current, s.reference
+	s.hasRef = true
+	s.skips = 0
+	s.stats.Accepted++
+	return true, score
+}
+
+// Stats returns the counters of uid.
+func (d *VideoChangeDetector) Stats(uid string) VideoChangeStats {
+	v, ok := d.states.Load(uid)
+	if !ok {
+		return VideoChangeStats{}
+	}
+	s := v.(*videoChangeState)
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return s.stats
+}
+
+// Remove drops the state of uid, e.g. in OnUserLeft.
+func (d *VideoChangeDetector) Remove(uid string) {
+	d.states.Delete(uid)
+}
+
+// score computes the signature of frame into s.current and compares it with s.reference.
+func (d *VideoChangeDetector) score(s *videoChangeState, frame *VideoFrame) float64 {
+	if frame == nil || frame.Width <= 0 || frame.Height <= 0 || frame.YStride < frame.Width ||
+		len(frame.YBuffer) < frame.YStride*(frame.Height-1)+frame.Width {
+		return -1
+	}
+	gridWidth, gridHeight := d.config.GridWidth, d.config.GridHeight
+	if gridWidth > frame.Width {
+		gridWidth = frame.Width
+	}
+	if gridHeight > frame.Height {
+		gridHeight = frame.Height
+	}
+	// at least one row per block row
+	rowStep := frame.Height / videoChangeSampleRows
+	if maxStep := frame.Height / gridHeight; rowStep > maxStep {
+		rowStep = maxStep
+	}
+	if rowStep < 1 {
+		rowStep = 1
+	}
+	C.cgo_luma_signature((*C.uint8_t)(unsafe.Pointer(&frame.YBuffer[0])), C.int(frame.YStride), C.int(frame.Width),
+		C.int(frame.Height), C.int(gridWidth), C.int(gridHeight), C.int(rowStep),
+		(*C.uint32_t)(unsafe.Pointer(&s.sums[0])), (*C.uint32_t)(unsafe.Pointer(&s.counts[0])),
+		(*C.uint32_t)(unsafe.Pointer(&s.hist[0])))
+
+	n := gridWidth * gridHeight
+	cur := &s.current
+	for i := 0; i < n; i++ {
+		cur.blocks[i] = 0
+		if s.counts[i] > 0 {
+			cur.blocks[i] = float32(s.sums[i]) / float32(s.counts[i])
+		}
+	}
+	var total uint32
+	for _, c := range s.hist {
+		total += c
+	}
+	for i, c := range s.hist {
+		cur.hist[i] = float32(c) / float32(total)
+	}
+	if !s.hasRef {
+		return 1
+	}
+
+	ref := &s.reference
+	var sad float32
+	for i := 0; i < n; i++ {
+		diff := cur.blocks[i] - ref.blocks[i]
+		if diff < 0 {
+			diff = -diff
+		}
+		sad += diff
+	}
+	blockScore := float64(sad) / float64(n) / 255
+	var dist float32
+	for i := range cur.hist {
+		diff := cur.hist[i] - ref.hist[i]
+		if diff < 0 {
+			diff = -diff
+		}
+		dist += diff
+	}
+	// total variation distance
+	histScore := float64(dist) / 2
+	if histScore > blockScore {
+		return histScore
+	}
+	return blockScore
+}
@@ -0,0 +1,273 @@
+package agoraservice
+
+// #cgo CFLAGS: -I${SRCDIR}/../headers/include/c/api2 -I${SRCDIR}/../headers/include/c/base
+// #include "video_convert_cgo.h"
+import "C"
+import (
+	"math"
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+/*
+* rgb to yuv conversion of generated frames(avatars, renders) for VideoFrameSender.
+* the conversion runs in c(video_convert_cgo.c), vectorized by the compiler, and writes straight into the
+* send buffer: rent a frame, convert into it, send it, the rgb image is read once.
+* the matrix and the range come from the ColorSpace of the frame: MatrixId 1 is BT.709, 9 is BT.2020,
+* anything else BT.601; RangeId 2 is full range, anything else limited range.
+* usage:
+* frame := sender.RentVideoFrame(VideoPixelI420, 1280, 720, 1280)
+* frame.ColorSpace = ColorSpaceType{MatrixId: 1, RangeId: 1} // BT.709 limited
+* ConvertRgbToYuv(rgba, VideoRgbFormatRGBA, 1280, 720, 1280*4, frame)
+* frame.Timestamp = time.Now().UnixMilli()
+* sender.SendVideoFrame(frame)
+* or in one call: sender.SendRgbVideoFrame(rgba, VideoRgbFormatRGBA, 1280, 720, 1280*4, VideoPixelI420, colorSpace, ts)
+ */
+
+type VideoRgbFormat int
+
+const (
+	VideoRgbFormatRGBA  VideoRgbFormat = 0
+	VideoRgbFormatBGRA  VideoRgbFormat = 1
+	VideoRgbFormatRGB24 VideoRgbFormat = 2
+)
+
+// H.273 matrix coefficients and webm range, as in ColorSpaceType
+const (
+	colorMatrixBt709  = 1
+	colorMatrixBt2020 = 9
+	colorRangeFull    = 2
+)
+
+func (format VideoRgbFormat) bytesPerPixel() int {
+	switch format {
+	case VideoRgbFormatRGBA, VideoRgbFormatBGRA:
+		return 4
+	case VideoRgbFormatRGB24:
+		return 3
+	}
+	return 0
+}
+
+// yuvCoeffs returns the fixed point coefficients of cgo_yuv_coeffs for a color space.
+func yuvCoeffs(colorSpace ColorSpaceType) C.cgo_yuv_coeffs {
+	kr, kb := 0.299, 0.114
+	switch colorSpace.MatrixId {
+	case colorMatrixBt709:
+		kr, kb = 0.2126, 0.0722
+	case colorMatrixBt2020:
+		kr, kb = 0.2627, 0.0593
+	}
+	kg := 1 - kr - kb
+	yScale, cScale, yOffset := 219.0/255.0, 224.0/255.0, 16.0
+	if colorSpace.RangeId == colorRangeFull {
+		yScale, cScale, yOffset = 1, 1, 0
+	}
+	one := float64(int(1) << C.CGO_YUV_SHIFT)
+	fix := func(v float64) C.int32_t {
+		return C.int32_t(math.Round(v * one))
+	}
+	// cb = (b - y) / (2 * (1 - kb)), cr = (r - y) / (2 * (1 - kr))
+	cb, cr := cScale/(2*(1-kb)), cScale/(2*(1-kr))
+	return C.cgo_yuv_coeffs{
+		yr:    fix(kr * yScale),
+		yg:    fix(kg * yScale),
+		yb:    fix(kb * yScale),
+		y_off: fix(yOffset + 0.5),
+		ur:    fix(-kr * cb),
+		ug:    fix(-kg * cb),
+		ub:    fix((1 - kb) * cb),
+		vr:    fix((1 - kr) * cr),
+		vg:    fix(-kg * cr),
+		vb:    fix(-kb * cr),
+		// the chroma sums 4 pixels
+		uv_off: fix((128 + 0.5) * 4),
+	}
+}
+
+// ConvertRgbToYuv converts a width x height rgb image, srcStride bytes per row, into dst.
+// dst is I420 or NV12 with the layout of VideoBufferSize, as returned by VideoFrameSender.RentVideoFrame,
+// its width is dst.Stride - dst.CropRight and its height dst.Height, which must match the image.
+// return 0 on success, -1 for unsupported formats, -2 for bad sizes
+func ConvertRgbToYuv(src []byte, srcFormat VideoRgbFormat, width int, height int, srcStride int, dst *ExternalVideoFrame) int {
+	bpp := srcFormat.bytesPerPixel()
+	if bpp == 0 || dst == nil || (dst.Format != VideoPixelI420 && dst.Format != VideoPixelNV12) {
+		return -1
+	}
+	if width <= 0 || height <= 0 || srcStride < width*bpp || len(src) < srcStride*(height-1)+width*bpp {
+		return -2
+	}
+	if dst.Stride-dst.CropRight != width || dst.Height != height ||
+		len(dst.Buffer) < VideoBufferSize(dst.Format, width, height, dst.Stride) {
+		return -2
+	}
+	// the plane layout of VideoBufferSize
+	chromaStride := (dst.Stride + 1) / 2
+	chromaHeight := (height + 1) / 2
+	yPlane := unsafe.Pointer(&dst.Buffer[0])
+	uPlane := unsafe.Add(yPlane, dst.Stride*height)
+	vPlane := unsafe.Add(uPlane, chromaStride*chromaHeight)
+	uvStride, nv12 := chromaStride, 0
+	if dst.Format == VideoPixelNV12 {
+		uvStride, nv12 = 2*chromaStride, 1
+	}
+	coeffs := yuvCoeffs(dst.ColorSpace)
+	// neither buffer is retained by c, and dst.Buffer may be mmap memory, so nothing is pinned
+	return int(C.cgo_convert_rgb_to_yuv(C.int(srcFormat), (*C.uint8_t)(unsafe.Pointer(&src[0])), C.int(srcStride),
+		C.int(width), C.int(height), (*C.uint8_t)(yPlane), C.int(dst.Stride), (*C.uint8_t)(uPlane), (*C.uint8_t)(vPlane),
+		C.int(uvStride), C.int(nv12), &coeffs))
+}
+
+// SendRgbVideoFrame converts an rgb image into a rented I420 or NV12 frame of colorSpace and sends it.
+// returns the result of SendVideoFrame, or the error of ConvertRgbToYuv
+func (sender *VideoFrameSender) SendRgbVideoFrame(src []byte, srcFormat VideoRgbFormat, width int, height int, srcStride int,
+	dstFormat VideoPixelFormat, colorSpace ColorSpaceType, timestamp int64) int {
+	frame := sender.RentVideoFrame(dstFormat, width, height, width)
+	if frame == nil {
+		return -1
+	}
+	frame.ColorSpace = colorSpace
+	frame.Timestamp = timestamp
+	if ret := ConvertRgbToYuv(src, srcFormat, width, height, srcStride, frame); ret != 0 {
+		frame.pooled.Release()
+		return ret
+	}
+	return sender.SendVideoFrame(frame)
+}
+
+type VideoTensorLayout int
+
+const (
+	VideoTensorLayoutCHW VideoTensorLayout = 0
+	VideoTensorLayoutHWC VideoTensorLayout = 1
+)
+
+// VideoTensorOptions describes the input tensor of a vision model, see VideoFrame.ToTensor.
+// each channel is (v * Scale - Mean) / Std, with v the 0..255 rgb value.
+type VideoTensorOptions struct {
+	Width  int
+	Height int
+	Layout VideoTensorLayout
+	BGR    bool       // channel order, Mean and Std are in this order too
+	Scale  float32    // 0: 1/255
+	Mean   [3]float32 // e.g. {0.485, 0.456, 0.406} for imagenet models
+	Std    [3]float32 // 0: 1
+	// color space of the frame, the zero value is BT.601 limited range as sent by most encoders
+	ColorSpace ColorSpaceType
+}
+
+// TensorSize returns the number of float32 of the tensor.
+func (opts *VideoTensorOptions) TensorSize() int {
+	return 3 * opts.Width * opts.Height
+}
+
+func (opts *VideoTensorOptions) cParams() C.cgo_tensor_params {
+	kr, kb := 0.299, 0.114
+	switch opts.ColorSpace.MatrixId {
+	case colorMatrixBt709:
+		kr, kb = 0.2126, 0.0722
+	case colorMatrixBt2020:
+		kr, kb = 0.2627, 0.0593
+	}
+	kg := 1 - kr - kb
+	yMul, yOff, cMul := 255.0/219.0, -16.0*255.0/219.0, 255.0/224.0
+	if opts.ColorSpace.RangeId == colorRangeFull {
+		yMul, yOff, cMul = 1, 0, 1
+	}
+	rv, bu := 2*(1-kr)*cMul, 2*(1-kb)*cMul
+	params := C.cgo_tensor_params{
+		y_mul: C.float(yMul),
+		y_off: C.float(yOff),
+		rv:    C.float(rv),
+		gu:    C.float(-kb / kg * bu),
+		gv:    C.float(-kr / kg * rv),
+		bu:    C.float(bu),
+		hwc:   CIntFromBool(opts.Layout == VideoTensorLayoutHWC),
+		bgr:   CIntFromBool(opts.BGR),
+	}
+	scale := opts.Scale
+	if scale == 0 {
+		scale = 1.0 / 255
+	}
+	for i := 0; i < 3; i++ {
+		std := opts.Std[i]
+		if std == 0 {
+			std = 1
+		}
+		params.mul[i] = C.float(scale / std)
+		params.add[i] = C.float(-opts.Mean[i] / std)
+	}
+	return params
+}
+
+// tensorMapsKey identifies the resize maps of ToTensor.
+type tensorMapsKey struct {
+	srcWidth, srcHeight int
+	dstWidth, dstHeight int
+}
+
+// tensorMaps are the bilinear source maps of a resize, see cgo_tensor_maps.
+type tensorMaps struct {
+	index  []int32
+	weight []float32
+}
+
+// at most a few sizes per stream are expected, the cache is dropped when a caller cycles through more
+const maxTensorMaps = 64
+
+var (
+	tensorMapsCache sync.Map // tensorMapsKey -> *tensorMaps
+	tensorMapsCount atomic.Int32
+)
+
+// getTensorMaps returns the maps of a resize, built once per size and shared by the callers.
+func getTensorMaps(key tensorMapsKey) *tensorMaps {
+	if m, ok := tensorMapsCache.Load(key); ok {
+		return m.(*tensorMaps)
+	}
+	n := 2*key.dstWidth + 2*key.dstHeight
+	m := &tensorMaps{index: make([]int32, n), weight: make([]float32, n)}
+	C.cgo_tensor_maps(C.int(key.srcWidth), C.int(key.srcHeight), C.int(key.dstWidth), C.int(key.dstHeight),
+		(*C.int32_t)(unsafe.Pointer(&m.index[0])), (*C.float)(unsafe.Pointer(&m.weight[0])))
+	if tensorMapsCount.Add(1) > maxTensorMaps {
+		tensorMapsCache.Range(func(k, _ any) bool {
+			tensorMapsCache.Delete(k)
+			return true
+		})
+		tensorMapsCount.Store(1)
+	}
+	if actual, loaded := tensorMapsCache.LoadOrStore(key, m); loaded {
+		return actual.(*tensorMaps)
+	}
+	return m
+}
+
+// ToTensor resizes the I420 frame to opts.Width x opts.Height(bilinear), converts it to rgb and
+// normalizes it into dst, which must hold opts.TensorSize() floats. it reads the planes in place, so it
+// is meant to run inside OnFrame on a borrowed frame(VideoFrameObserver.BorrowFrame) before anything
+// is copied. the kernel is video_convert_cgo.c, one pass over dst, with resize maps cached per size.
+// return 0 on success, -1 if the frame has no I420 planes, -2 for bad sizes
+func (f *VideoFrame) ToTensor(dst []float32, opts *VideoTensorOptions) int {
+	if f == nil || f.Type != VideoBufferRawData || len(f.YBuffer) == 0 || len(f.UBuffer) == 0 || len(f.VBuffer) == 0 {
+		return -1
+	}
+	if opts == nil || opts.Width <= 0 || opts.Height <= 0 || len(dst) < opts.TensorSize() {
+		return -2
+	}
+	chromaHeight := (f.Height + 1) / 2
+	if f.Width <= 0 || f.Height <= 0 || f.YStride < f.Width || f.UStride < (f.Width+1)/2 || f.VStride < (f.Width+1)/2 ||
+		len(f.YBuffer) < f.YStride*(f.Height-1)+f.Width ||
+		len(f.UBuffer) < f.UStride*(chromaHeight-1)+(f.Width+1)/2 ||
+		len(f.VBuffer) < f.VStride*(chromaHeight-1)+(f.Width+1)/2 {
+		return -2
+	}
+	params := opts.cParams()
+	maps := getTensorMaps(tensorMapsKey{srcWidth: f.Width, srcHeight: f.Height, dstWidth: opts.Width, dstHeight: opts.Height})
+	C.cgo_i420_to_tensor((*C.uint8_t)(unsafe.Pointer(&f.YBuffer[0])), C.int(f.YStride),
+		(*C.uint8_t)(unsafe.Pointer(&f.UBuffer[0])), C.int(f.UStride),
+		(*C.uint8_t)(unsafe.Pointer(&f.VBuffer[0])), C.int(f.VStride),
+		C.int(f.Width), C.int(f.Height), (*C.float)(unsafe.Pointer(&dst[0])), C.int(opts.Width), C.int(opts.Height),
+		(*C.int32_t)(unsafe.Pointer(&maps.index[0])), (*C.float)(unsafe.Pointer(&maps.weight[0])), &params)
+	return 0
+}
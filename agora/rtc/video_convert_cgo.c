@@ -0,0 +1,199 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "video_convert_cgo.h"
+
+// the row loops are written for auto vectorization: the pixel layout is a compile time constant of every
+// instance, and the coefficients are copied to locals. gcc only vectorizes them at -O3 by default.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("O3")
+#endif
+
+#define CGO_ALWAYS_INLINE static inline __attribute__((always_inline))
+
+CGO_ALWAYS_INLINE uint8_t clamp_u8(int32_t v) {
+  return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+CGO_ALWAYS_INLINE void rgb_row_to_y(const uint8_t* src, int width, int bpp, int ri, int gi, int bi, uint8_t* y,
+                                    const cgo_yuv_coeffs* c) {
+  const int32_t yr = c->yr, yg = c->yg, yb = c->yb, y_off = c->y_off;
+  for (int x = 0; x < width; x++) {
+    const uint8_t* p = src + x * bpp;
+    y[x] = (uint8_t)((yr * p[ri] + yg * p[gi] + yb * p[bi] + y_off) >> CGO_YUV_SHIFT);
+  }
+}
+
+// chroma of the 2x2 blocks of rows s0 and s1, the odd last column(if any) is counted twice.
+CGO_ALWAYS_INLINE void rgb_rows_to_uv(const uint8_t* s0, const uint8_t* s1, int width, int bpp, int ri, int gi, int bi,
+                                      uint8_t* u, uint8_t* v, int nv12, const cgo_yuv_coeffs* c) {
+  const int32_t ur = c->ur, ug = c->ug, ub = c->ub, vr = c->vr, vg = c->vg, vb = c->vb, uv_off = c->uv_off;
+  const int half = width / 2;
+  for (int x = 0; x < half; x++) {
+    const uint8_t* a = s0 + 2 * x * bpp;
+    const uint8_t* b = s1 + 2 * x * bpp;
+    // sums of 4 pixels, the shift below divides by 4 as well
+    int32_t r = a[ri] + a[bpp + ri] + b[ri] + b[bpp + ri];
+    int32_t g = a[gi] + a[bpp + gi] + b[gi] + b[bpp + gi];
+    int32_t bl = a[bi] + a[bpp + bi] + b[bi] + b[bpp + bi];
+    uint8_t cu = clamp_u8((ur * r + ug * g + ub * bl + uv_off) >> (CGO_YUV_SHIFT + 2));
+    uint8_t cv = clamp_u8((vr * r + vg * g + vb * bl + uv_off) >> (CGO_YUV_SHIFT + 2));
+    if (nv12) {
+      u[2 * x] = cu;
+      u[2 * x + 1] = cv;
+    } else {
+      u[x] = cu;
+      v[x] = cv;
+    }
+  }
+  if (width & 1) {
+    const uint8_t* a = s0 + (width - 1) * bpp;
+    const uint8_t* b = s1 + (width - 1) * bpp;
+    int32_t r = 2 * (a[ri] + b[ri]), g = 2 * (a[gi] + b[gi]), bl = 2 * (a[bi] + b[bi]);
+    uint8_t cu = clamp_u8((ur * r + ug * g + ub * bl + uv_off) >> (CGO_YUV_SHIFT + 2));
+    uint8_t cv = clamp_u8((vr * r + vg * g + vb * bl + uv_off) >> (CGO_YUV_SHIFT + 2));
+    if (nv12) {
+      u[2 * half] = cu;
+      u[2 * half + 1] = cv;
+    } else {
+      u[half] = cu;
+      v[half] = cv;
+    }
+  }
+}
+
+// one pass over src: each pair of rows is read for luma and then again, still in cache, for chroma.
+CGO_ALWAYS_INLINE void rgb_to_yuv(const uint8_t* src, int src_stride, int width, int height, int bpp, int ri, int gi,
+                                  int bi, uint8_t* y, int y_stride, uint8_t* u, uint8_t* v, int uv_stride, int nv12,
+                                  const cgo_yuv_coeffs* c) {
+  for (int row = 0; row < height; row += 2) {
+    const uint8_t* s0 = src + (int64_t)row * src_stride;
+    // the odd last row is paired with itself
+    const uint8_t* s1 = row + 1 < height ? s0 + src_stride : s0;
+    uint8_t* y0 = y + (int64_t)row * y_stride;
+    rgb_row_to_y(s0, width, bpp, ri, gi, bi, y0, c);
+    if (row + 1 < height) {
+      rgb_row_to_y(s1, width, bpp, ri, gi, bi, y0 + y_stride, c);
+    }
+    int64_t uv_row = (int64_t)(row / 2) * uv_stride;
+    rgb_rows_to_uv(s0, s1, width, bpp, ri, gi, bi, u + uv_row, nv12 ? 0 : v + uv_row, nv12, c);
+  }
+}
+
+#define CGO_DEFINE_RGB_TO_YUV(name, bpp, ri, gi, bi, nv12)                                                       \
+  static void name(const uint8_t* src, int src_stride, int width, int height, uint8_t* y, int y_stride,        \
+                   uint8_t* u, uint8_t* v, int uv_stride, const cgo_yuv_coeffs* c) {                          \
+    rgb_to_yuv(src, src_stride, width, height, bpp, ri, gi, bi, y, y_stride, u, v, uv_stride, nv12, c);        \
+  }
+
+CGO_DEFINE_RGB_TO_YUV(rgba_to_i420, 4, 0, 1, 2, 0)
+CGO_DEFINE_RGB_TO_YUV(bgra_to_i420, 4, 2, 1, 0, 0)
+CGO_DEFINE_RGB_TO_YUV(rgb24_to_i420, 3, 0, 1, 2, 0)
+CGO_DEFINE_RGB_TO_YUV(rgba_to_nv12, 4, 0, 1, 2, 1)
+CGO_DEFINE_RGB_TO_YUV(bgra_to_nv12, 4, 2, 1, 0, 1)
+CGO_DEFINE_RGB_TO_YUV(rgb24_to_nv12, 3, 0, 1, 2, 1)
+
+int cgo_convert_rgb_to_yuv(int src_format, const uint8_t* src, int src_stride, int width, int height, uint8_t* y,
+                           int y_stride, uint8_t* u, uint8_t* v, int uv_stride, int nv12,
+                           const cgo_yuv_coeffs* coeffs) {
+  switch (src_format) {
+    case CGO_RGB_FORMAT_RGBA:
+      (nv12 ? rgba_to_nv12 : rgba_to_i420)(src, src_stride, width, height, y, y_stride, u, v, uv_stride, coeffs);
+      return 0;
+    case CGO_RGB_FORMAT_BGRA:
+      (nv12 ? bgra_to_nv12 : bgra_to_i420)(src, src_stride, width, height, y, y_stride, u, v, uv_stride, coeffs);
+      return 0;
+    case CGO_RGB_FORMAT_RGB24:
+      (nv12 ? rgb24_to_nv12 : rgb24_to_i420)(src, src_stride, width, height, y, y_stride, u, v, uv_stride, coeffs);
+      return 0;
+  }
+  return -1;
+}
+
+// source position of each output column/row for half pixel centers: index of the left/top sample and the
+// weight of the right/bottom one.
+static void bilinear_map(int src_len, int dst_len, int32_t* index, float* weight) {
+  const float scale = (float)src_len / (float)dst_len;
+  for (int i = 0; i < dst_len; i++) {
+    float pos = ((float)i + 0.5f) * scale - 0.5f;
+    if (pos < 0) {
+      pos = 0;
+    }
+    int i0 = (int)pos;
+    if (i0 >= src_len - 1) {
+      i0 = src_len - 1;
+      pos = (float)i0;
+    }
+    index[i] = i0;
+    weight[i] = pos - (float)i0;
+  }
+}
+
+CGO_ALWAYS_INLINE float bilinear(const uint8_t* r0, const uint8_t* r1, int x0, int x1, float wx, float wy) {
+  float top = (float)r0[x0] + ((float)r0[x1] - (float)r0[x0]) * wx;
+  float bottom = (float)r1[x0] + ((float)r1[x1] - (float)r1[x0]) * wx;
+  return top + (bottom - top) * wy;
+}
+
+CGO_ALWAYS_INLINE float clamp_255(float v) {
+  return v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+}
+
+void cgo_tensor_maps(int src_width, int src_height, int dst_width, int dst_height, int32_t* index, float* weight) {
+  bilinear_map(src_width, dst_width, index, weight);
+  bilinear_map((src_width + 1) / 2, dst_width, index + dst_width, weight + dst_width);
+  bilinear_map(src_height, dst_height, index + 2 * dst_width, weight + 2 * dst_width);
+  bilinear_map((src_height + 1) / 2, dst_height, index + 2 * dst_width + dst_height, weight + 2 * dst_width + dst_height);
+}
+
+void cgo_i420_to_tensor(const uint8_t* y, int y_stride, const uint8_t* u, int u_stride, const uint8_t* v,
+                        int v_stride, int src_width, int src_height, float* dst, int dst_width, int dst_height,
+                        const int32_t* index, const float* weight, const cgo_tensor_params* p) {
+  const int chroma_width = (src_width + 1) / 2;
+  const int chroma_height = (src_height + 1) / 2;
+  const int32_t* lx = index;
+  const int32_t* cx = lx + dst_width;
+  const int32_t* ly = cx + dst_width;
+  const int32_t* cy = ly + dst_height;
+  const float* lwx = weight;
+  const float* cwx = lwx + dst_width;
+  const float* lwy = cwx + dst_width;
+  const float* cwy = lwy + dst_height;
+
+  const float y_mul = p->y_mul, y_off = p->y_off, rv = p->rv, gu = p->gu, gv = p->gv, bu = p->bu;
+  const int ri = p->bgr ? 2 : 0, bi = p->bgr ? 0 : 2;
+  const float r_mul = p->mul[ri], r_add = p->add[ri], g_mul = p->mul[1], g_add = p->add[1];
+  const float b_mul = p->mul[bi], b_add = p->add[bi];
+  const size_t plane = (size_t)dst_width * dst_height;
+
+  for (int oy = 0; oy < dst_height; oy++) {
+    const int ly0 = ly[oy], ly1 = ly0 + 1 < src_height ? ly0 + 1 : ly0;
+    const int cy0 = cy[oy], cy1 = cy0 + 1 < chroma_height ? cy0 + 1 : cy0;
+    const uint8_t* y0 = y + (int64_t)ly0 * y_stride;
+    const uint8_t* y1 = y + (int64_t)ly1 * y_stride;
+    const uint8_t* u0 = u + (int64_t)cy0 * u_stride;
+    const uint8_t* u1 = u + (int64_t)cy1 * u_stride;
+    const uint8_t* v0 = v + (int64_t)cy0 * v_stride;
+    const uint8_t* v1 = v + (int64_t)cy1 * v_stride;
+    const float wy = lwy[oy], wcy = cwy[oy];
+    float* out = p->hwc ? dst + (size_t)oy * dst_width * 3 : dst + (size_t)oy * dst_width;
+    for (int ox = 0; ox < dst_width; ox++) {
+      const int lx0 = lx[ox], lx1 = lx0 + 1 < src_width ? lx0 + 1 : lx0;
+      const int cx0 = cx[ox], cx1 = cx0 + 1 < chroma_width ? cx0 + 1 : cx0;
+      const float yy = bilinear(y0, y1, lx0, lx1, lwx[ox], wy) * y_mul + y_off;
+      const float cu = bilinear(u0, u1, cx0, cx1, cwx[ox], wcy) - 128.0f;
+      const float cv = bilinear(v0, v1, cx0, cx1, cwx[ox], wcy) - 128.0f;
+      const float r = clamp_255(yy + rv * cv) * r_mul + r_add;
+      const float g = clamp_255(yy + gu * cu + gv * cv) * g_mul + g_add;
+      const float b = clamp_255(yy + bu * cu) * b_mul + b_add;
+      if (p->hwc) {
+        out[3 * ox + ri] = r;
+        out[3 * ox + 1] = g;
+        out[3 * ox + bi] = b;
+      } else {
+        out[(size_t)ri * plane + ox] = r;
+        out[plane + ox] = g;
+        out[(size_t)bi * plane + ox] = b;
+      }
+    }
+  }
+}
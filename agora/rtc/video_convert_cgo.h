@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+// rgb to yuv conversion for the send path, see video_convert.go.
+// the coefficients are fixed point with CGO_YUV_SHIFT fractional bits, computed in go from the color space.
+#define CGO_YUV_SHIFT 14
+
+// same values as VideoRgbFormat in video_convert.go
+#define CGO_RGB_FORMAT_RGBA 0
+#define CGO_RGB_FORMAT_BGRA 1
+#define CGO_RGB_FORMAT_RGB24 2
+
+typedef struct _cgo_yuv_coeffs {
+  int32_t yr, yg, yb, y_off;
+  int32_t ur, ug, ub;
+  int32_t vr, vg, vb;
+  int32_t uv_off;
+} cgo_yuv_coeffs;
+
+// converts width x height pixels of src into the y plane and the 2x2 subsampled chroma planes.
+// nv12 != 0 writes interleaved chroma to u(v is ignored), otherwise planar u and v as i420.
+// returns 0, or -1 for an unknown src_format.
+extern int cgo_convert_rgb_to_yuv(int src_format, const uint8_t* src, int src_stride, int width, int height,
+                                  uint8_t* y, int y_stride, uint8_t* u, uint8_t* v, int uv_stride, int nv12,
+                                  const cgo_yuv_coeffs* coeffs);
+
+// i420 to float tensor for inference, see VideoFrame.ToTensor in video_convert.go.
+// the yuv to rgb coefficients apply to 0..255 values, then each channel is mapped with mul * v + add.
+typedef struct _cgo_tensor_params {
+  float y_mul, y_off;
+  float rv, gu, gv, bu;
+  float mul[3], add[3];
+  int hwc;  // 0: CHW, 1: HWC
+  int bgr;  // channel order of the output
+} cgo_tensor_params;
+
+// fills the bilinear(half pixel centers) source maps of a resize from src_width x src_height to dst_width x
+// dst_height: the luma x, chroma x, luma y and chroma y maps, one after the other. index and weight hold
+// 2 * dst_width + 2 * dst_height entries, index is the left/top sample and weight the one of the right/bottom.
+extern void cgo_tensor_maps(int src_width, int src_height, int dst_width, int dst_height, int32_t* index, float* weight);
+
+// resizes the i420 planes to dst_width x dst_height with the maps of cgo_tensor_maps, converts to rgb and
+// normalizes into dst(3 * dst_width * dst_height floats), in one pass over dst.
+extern void cgo_i420_to_tensor(const uint8_t* y, int y_stride, const uint8_t* u, int u_stride, const uint8_t* v,
+                               int v_stride, int src_width, int src_height, float* dst, int dst_width, int dst_height,
+                               const int32_t* index, const float* weight, const cgo_tensor_params* params);
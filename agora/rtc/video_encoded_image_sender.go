@@ -80,8 +80,12 @@ func (sender *VideoEncodedImageSender) Release() {
 }
 
 func (sender *VideoEncodedImageSender) SendEncodedVideoImage(payload []byte, frameInfo *EncodedVideoFrameInfo) int {
-	cData, pinner := unsafeCBytes(payload)
-	defer pinner.Unpin()
+	if len(payload) == 0 {
+		return -1
+	}
+	// not pinned: payload may be a view of a mapped file(EncodedVideoFileSource), which runtime.Pinner
+	// rejects, and the sdk copies it before returning, as the cgo pointer rules require
+	cData := unsafe.Pointer(&payload[0])
 	cFrameInfo := &C.struct__encoded_video_frame_info{
 		codec_type:        C.int(frameInfo.CodecType),
 		width:             C.int(frameInfo.Width),
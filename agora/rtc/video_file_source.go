@@ -0,0 +1,315 @@
+package agoraservice
+
+import (
+	"errors"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+/*
+* EncodedVideoFile and EncodedVideoFileSource push a pre-encoded H.264/H.265 Annex-B elementary stream
+* (e.g. ffmpeg -i in.mp4 -c:v copy -bsf:v h264_mp4toannexb -f h264 out.h264) to a connection, in real
+* time and without decoding. the file is memory mapped and split into access units once, one
+* EncodedVideoFile can be shared by the sources of any number of connections.
+* the stream should start with a key frame(with its parameter sets) to be loopable, and use no b frames:
+* access units are sent in file order.
+* usage:
+* file, err := OpenEncodedVideoFile("idle.h264", VideoCodecTypeH264)
+* defer file.Close() // after all the sources are stopped
+* source := NewEncodedVideoFileSource(file, &EncodedVideoFileSourceConfig{Fps: 15, Width: 640, Height: 360, Loop: true})
+* source.Start(conn.PushVideoEncodedData)
+* ...
+* source.Stop()
+ */
+
+// EncodedVideoAccessUnit is one frame of an EncodedVideoFile, Offset/Size include the start codes.
+type EncodedVideoAccessUnit struct {
+	Offset    int
+	Size      int
+	FrameType VideoFrameType
+}
+
+type EncodedVideoFile struct {
+	codec       VideoCodecType
+	data        []byte
+	accessUnits []EncodedVideoAccessUnit
+}
+
+// OpenEncodedVideoFile maps an Annex-B elementary stream and indexes its access units.
+// codec is VideoCodecTypeH264 or VideoCodecTypeH265.
+func OpenEncodedVideoFile(path string, codec VideoCodecType) (*EncodedVideoFile, error) {
+	if codec != VideoCodecTypeH264 && codec != VideoCodecTypeH265 {
+		return nil, errors.New("only h264 and h265 are supported")
+	}
+	data, err := mapFileReadOnly(path)
+	if err != nil {
+		return nil, err
+	}
+	file := &EncodedVideoFile{codec: codec, data: data}
+	file.accessUnits = splitAnnexBAccessUnits(codec, data)
+	if len(file.accessUnits) == 0 {
+		unmapFile(data)
+		return nil, errors.New("no access unit found")
+	}
+	return file, nil
+}
+
+// Close unmaps the file, no source of the file may be running.
+func (f *EncodedVideoFile) Close() {
+	unmapFile(f.data)
+	f.data = nil
+	f.accessUnits = nil
+}
+
+func (f *EncodedVideoFile) Codec() VideoCodecType {
+	return f.codec
+}
+
+// AccessUnits returns the index of the file, it must not be modified.
+func (f *EncodedVideoFile) AccessUnits() []EncodedVideoAccessUnit {
+	return f.accessUnits
+}
+
+// AccessUnitData returns the bytes of the i-th access unit, a view of the mapping.
+func (f *EncodedVideoFile) AccessUnitData(i int) []byte {
+	au := f.accessUnits[i]
+	return f.data[au.Offset : au.Offset+au.Size : au.Offset+au.Size]
+}
+
+func isVclNalUnit(codec VideoCodecType, nalType int) bool {
+	if isH265Codec(codec) {
+		return nalType >= 0 && nalType <= 31
+	}
+	return nalType >= H264NalTypeSlice && nalType <= H264NalTypeIdr
+}
+
+// startsAccessUnit reports whether nal can only be the first NAL unit of an access unit once the current
+// access unit has a slice: an AUD, a parameter set or SEI, or the first slice of a picture.
+func startsAccessUnit(codec VideoCodecType, nal []byte, nalType int) bool {
+	if isH265Codec(codec) {
+		switch {
+		case nalType >= H265NalTypeVps && nalType <= H265NalTypeAud, nalType == H265NalTypeSei:
+			return true
+		case nalType <= 31:
+			// first_slice_segment_in_pic_flag
+			return len(nal) > 2 && nal[2]&0x80 != 0
+		}
+		return false
+	}
+	switch nalType {
+	case H264NalTypeSei, H264NalTypeSps, H264NalTypePps, H264NalTypeAud:
+		return true
+	case H264NalTypeSlice, H264NalTypeIdr:
+		// first_mb_in_slice == 0, i.e ue(v) coded as a single 1 bit
+		return len(nal) > 1 && nal[1]&0x80 != 0
+	}
+	return false
+}
+
+// startCodeOffset returns the position of the start code in front of the NAL unit at offset.
+func startCodeOffset(data []byte, offset int) int {
+	pos := offset - 3
+	if pos > 0 && data[pos-1] == 0 {
+		pos--
+	}
+	return pos
+}
+
+func splitAnnexBAccessUnits(codec VideoCodecType, data []byte) []EncodedVideoAccessUnit {
+	nals := ParseAnnexBNalUnits(codec, data, nil)
+	var units []EncodedVideoAccessUnit
+	start, hasVcl, key := -1, false, false
+	for i := range nals {
+		nal := nals[i].Payload(data)
+		if hasVcl && startsAccessUnit(codec, nal, nals[i].Type) {
+			offset := startCodeOffset(data, nals[i].Offset)
+			units = append(units, newEncodedVideoAccessUnit(start, offset, key))
+			start, hasVcl, key = -1, false, false
+		}
+		if start < 0 {
+			start = startCodeOffset(data, nals[i].Offset)
+		}
+		if isVclNalUnit(codec, nals[i].Type) {
+			hasVcl = true
+			key = key || IsVideoKeyNalUnit(codec, nals[i].Type)
+		}
+	}
+	if hasVcl {
+		last := nals[len(nals)-1]
+		units = append(units, newEncodedVideoAccessUnit(start, last.Offset+last.Size, key))
+	}
+	return units
+}
+
+func newEncodedVideoAccessUnit(start int, end int, key bool) EncodedVideoAccessUnit {
+	frameType := VideoFrameTypeDeltaFrame
+	if key {
+		frameType = VideoFrameTypeKeyFrame
+	}
+	return EncodedVideoAccessUnit{Offset: start, Size: end - start, FrameType: frameType}
+}
+
+type EncodedVideoFileSourceConfig struct {
+	Fps    int // frames per second of the file, default 15
+	Width  int // reported in EncodedVideoFrameInfo, optional
+	Height int
+	Loop   bool // restart from the first access unit at the end of the file
+}
+
+// EncodedVideoFileSourceStats are the counters of a source, Late counts the frames sent more than one
+// frame interval after their due time.
+type EncodedVideoFileSourceStats struct {
+	Frames     uint64
+	Bytes      uint64
+	Loops      uint64
+	Late       uint64
+	SendErrors uint64
+}
+
+type EncodedVideoFileSource struct {
+	file   *EncodedVideoFile
+	config EncodedVideoFileSourceConfig
+
+	mu      sync.Mutex
+	stopCh  chan struct{}
+	doneCh  chan struct{}
+	running bool
+
+	frames     uint64
+	bytes      uint64
+	loops      uint64
+	late       uint64
+	sendErrors uint64
+}
+
+// resync the timeline instead of bursting when the source falls this far behind, e.g. after a stall
+const encodedVideoFileSourceMaxLag = time.Second
+
+func NewEncodedVideoFileSource(file *EncodedVideoFile, config *EncodedVideoFileSourceConfig) *EncodedVideoFileSource {
+	cfg := EncodedVideoFileSourceConfig{}
+	if config != nil {
+		cfg = *config
+	}
+	if cfg.Fps <= 0 {
+		cfg.Fps = 15
+	}
+	return &EncodedVideoFileSource{file: file, config: cfg}
+}
+
+// Start sends the access units with send, e.g. conn.PushVideoEncodedData or
+// sender.SendEncodedVideoImage, from a goroutine of the source. data is a view of the mapped file and
+// frameInfo is reused, neither may be kept by send. returns -1 if the source is already running.
+func (s *EncodedVideoFileSource) Start(send func(data []byte, frameInfo *EncodedVideoFrameInfo) int) int {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.running || send == nil {
+		return -1
+	}
+	s.running = true
+	s.stopCh = make(chan struct{})
+	s.doneCh = make(chan struct{})
+	go s.run(send, s.stopCh, s.doneCh)
+	return 0
+}
+
+// Stop stops the source and waits for the running send to return.
+func (s *EncodedVideoFileSource) Stop() {
+	s.mu.Lock()
+	if !s.running {
+		s.mu.Unlock()
+		return
+	}
+	s.running = false
+	close(s.stopCh)
+	doneCh := s.doneCh
+	s.mu.Unlock()
+	<-doneCh
+}
+
+// Done returns a channel closed when the source stops, either by Stop or at the end of a file without Loop.
+func (s *EncodedVideoFileSource) Done() <-chan struct{} {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return s.doneCh
+}
+
+func (s *EncodedVideoFileSource) Stats() EncodedVideoFileSourceStats {
+	return EncodedVideoFileSourceStats{
+		Frames:     atomic.LoadUint64(&s.frames),
+		Bytes:      atomic.LoadUint64(&s.bytes),
+		Loops:      atomic.LoadUint64(&s.loops),
+		Late:       atomic.LoadUint64(&s.late),
+		SendErrors: atomic.LoadUint64(&s.sendErrors),
+	}
+}
+
+func (s *EncodedVideoFileSource) run(send func([]byte, *EncodedVideoFrameInfo) int, stopCh chan struct{}, doneCh chan struct{}) {
+	defer func() {
+		s.mu.Lock()
+		// a Stop followed by a Start may already have replaced this run
+		if s.doneCh == doneCh {
+			s.running = false
+		}
+		s.mu.Unlock()
+		close(doneCh)
+	}()
+	units := s.file.accessUnits
+	interval := time.Second / time.Duration(s.config.Fps)
+	info := &EncodedVideoFrameInfo{
+		CodecType:       s.file.codec,
+		Width:           s.config.Width,
+		Height:          s.config.Height,
+		FramesPerSecond: s.config.Fps,
+	}
+	timer := time.NewTimer(0)
+	defer timer.Stop()
+	<-timer.C
+
+	start := time.Now()
+	var sent int64  // frames since start, the due time of the next frame is start + sent*interval
+	var total int64 // frames sent, the stream time keeps growing over the loops and resyncs
+	for i := 0; ; {
+		due := start.Add(time.Duration(sent) * interval)
+		if wait := time.Until(due); wait > 0 {
+			timer.Reset(wait)
+			select {
+			case <-timer.C:
+			case <-stopCh:
+				return
+			}
+		} else {
+			select {
+			case <-stopCh:
+				return
+			default:
+			}
+			if -wait > interval {
+				atomic.AddUint64(&s.late, 1)
+			}
+			if -wait > encodedVideoFileSourceMaxLag {
+				start, sent = time.Now(), 0
+			}
+		}
+
+		au := units[i]
+		info.FrameType = au.FrameType
+		info.CaptureTimeMs = time.Now().UnixMilli()
+		info.PresentTimeMs = int64(time.Duration(total) * interval / time.Millisecond)
+		if ret := send(s.file.data[au.Offset:au.Offset+au.Size:au.Offset+au.Size], info); ret != 0 {
+			atomic.AddUint64(&s.sendErrors, 1)
+		}
+		atomic.AddUint64(&s.frames, 1)
+		atomic.AddUint64(&s.bytes, uint64(au.Size))
+		sent++
+		total++
+
+		if i++; i == len(units) {
+			if !s.config.Loop {
+				return
+			}
+			i = 0
+			atomic.AddUint64(&s.loops, 1)
+		}
+	}
+}
@@ -0,0 +1,122 @@
+package agoraservice
+
+import (
+	"strconv"
+	"sync"
+	"sync/atomic"
+)
+
+/*
+* borrowed video frames: with VideoFrameObserver.BorrowFrame set, OnFrame receives
+* a VideoFrame whose YBuffer/UBuffer/VBuffer/MetadataBuffer/AlphaBuffer point
+* into SDK memory instead of Go copies. The frame and its planes are only valid
+* until OnFrame returns, the VideoFrame struct itself is recycled.
+* to keep a frame, or a plane, after OnFrame returns:
+* kept := frame.Clone()      // allocates
+* frame.CopyTo(reusedFrame)  // reuses the buffers of reusedFrame when they are big enough
+* VideoEncodedFrameObserver.BorrowFrame works the same way for encoded images: imageBuffer is a
+* view and frameInfo is recycled, e.g. append(kept[:0], imageBuffer...) to keep the image.
+ */
+
+// VideoFrameCopyStats counts the received video frames by how they were handed to OnFrame.
+type VideoFrameCopyStats struct {
+	CopiedFrames   uint64 // frames converted by GoVideoFrame
+	CopiedBytes    uint64 // plane bytes copied by GoVideoFrame
+	BorrowedFrames uint64 // frames passed as borrowed views
+}
+
+var videoFrameCopyStats VideoFrameCopyStats
+
+// GetVideoFrameCopyStats returns the process wide counters of received video frames.
+func GetVideoFrameCopyStats() VideoFrameCopyStats {
+	return VideoFrameCopyStats{
+		CopiedFrames:   atomic.LoadUint64(&videoFrameCopyStats.CopiedFrames),
+		CopiedBytes:    atomic.LoadUint64(&videoFrameCopyStats.CopiedBytes),
+		BorrowedFrames: atomic.LoadUint64(&videoFrameCopyStats.BorrowedFrames),
+	}
+}
+
+var borrowedVideoFramePool = sync.Pool{
+	New: func() any {
+		return &VideoFrame{}
+	},
+}
+
+func getBorrowedVideoFrame() *VideoFrame {
+	return borrowedVideoFramePool.Get().(*VideoFrame)
+}
+
+func putBorrowedVideoFrame(frame *VideoFrame) {
+	// drop the views so that the pool does not keep pointers into sdk memory
+	*frame = VideoFrame{}
+	borrowedVideoFramePool.Put(frame)
+}
+
+// Clone returns a deep copy of the frame that owns all of its buffers.
+func (f *VideoFrame) Clone() *VideoFrame {
+	dst := &VideoFrame{}
+	f.CopyTo(dst)
+	return dst
+}
+
+// CopyTo deep copies the frame into dst, the buffers of dst are reused when their capacity is enough.
+func (f *VideoFrame) CopyTo(dst *VideoFrame) {
+	if dst == nil || dst == f {
+		return
+	}
+	y, u, v, metadata, alpha := dst.YBuffer, dst.UBuffer, dst.VBuffer, dst.MetadataBuffer, dst.AlphaBuffer
+	pooled := dst.pooled
+	*dst = *f
+	// dst keeps its own pooled buffer(if any), the planes of f are never shared
+	dst.pooled = pooled
+	dst.YBuffer = copyPlane(y, f.YBuffer)
+	dst.UBuffer = copyPlane(u, f.UBuffer)
+	dst.VBuffer = copyPlane(v, f.VBuffer)
+	dst.MetadataBuffer = copyPlane(metadata, f.MetadataBuffer)
+	dst.AlphaBuffer = copyPlane(alpha, f.AlphaBuffer)
+}
+
+func copyPlane(dst []byte, src []byte) []byte {
+	if src == nil {
+		return nil
+	}
+	return append(dst[:0], src...)
+}
+
+var borrowedEncodedVideoFrameInfoPool = sync.Pool{
+	New: func() any {
+		return &EncodedVideoFrameInfo{}
+	},
+}
+
+func getBorrowedEncodedVideoFrameInfo() *EncodedVideoFrameInfo {
+	return borrowedEncodedVideoFrameInfoPool.Get().(*EncodedVideoFrameInfo)
+}
+
+func putBorrowedEncodedVideoFrameInfo(info *EncodedVideoFrameInfo) {
+	borrowedEncodedVideoFrameInfoPool.Put(info)
+}
+
+// the encoded video callback gets uid as uint32, the strings are cached as a channel has a few uids only.
+// the cache stops growing at maxUidStringCacheSize, later uids are formatted on every call.
+const maxUidStringCacheSize = 4096
+
+var (
+	uidStringCache     sync.Map // uint32 -> string
+	uidStringCacheSize int32
+)
+
+func uidString(uid uint32) string {
+	if s, ok := uidStringCache.Load(uid); ok {
+		return s.(string)
+	}
+	s := strconv.FormatUint(uint64(uid), 10)
+	if atomic.LoadInt32(&uidStringCacheSize) >= maxUidStringCacheSize {
+		return s
+	}
+	if cached, loaded := uidStringCache.LoadOrStore(uid, s); loaded {
+		return cached.(string)
+	}
+	atomic.AddInt32(&uidStringCacheSize, 1)
+	return s
+}
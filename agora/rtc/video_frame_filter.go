@@ -0,0 +1,131 @@
+package agoraservice
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/../headers/include/c/api2 -I${SRCDIR}/../headers/include/c/base
+
+#include <stdlib.h>
+#include "video_observer_cgo.h"
+*/
+import "C"
+import (
+	"fmt"
+	"unsafe"
+)
+
+/*
+* VideoFrameFilter decides, per remote uid, which video frames reach VideoFrameObserver.OnFrame and
+* VideoEncodedFrameObserver.OnEncodedVideoFrame. it is enforced in video_observer_cgo.c before the
+* cgo crossing, so the dropped frames are never copied into go. the filters are found by observer
+* without a global lock, so the connections don't contend with each other.
+* usage: 2fps from two speakers, nothing from the others
+* conn.SetVideoFrameFilter(&VideoFrameFilter{
+*     AllowListOnly: true,
+*     Rules: []VideoFrameFilterRule{{Uid: "1001", MaxFps: 2}, {Uid: "1002", MaxFps: 2}},
+* })
+ */
+
+// max number of rules of a filter, same as CGO_VIDEO_FILTER_MAX_RULES
+const VideoFrameFilterMaxRules = 128
+
+// max number of observers of the process with a filter, same as CGO_VIDEO_FILTER_SLOTS
+const VideoFrameFilterMaxObservers = 4096
+
+type VideoFrameFilterRule struct {
+	Uid string
+	// 0: no limit. encoded video is dropped by whole gops to stay decodable: a gop is delivered if its key
+	// frame is within MaxFps, so it limits the key frames.
+	MaxFps       int
+	KeyFrameOnly bool // only for encoded video
+}
+
+type VideoFrameFilter struct {
+	AllowListOnly       bool // if true, only the uids in Rules are delivered
+	DefaultMaxFps       int  // for the uids without rule, 0: no limit
+	DefaultKeyFrameOnly bool // for the uids without rule, only for encoded video
+	Rules               []VideoFrameFilterRule
+}
+
+// SetVideoFrameFilter applies filter to the raw and encoded video observers of the connection, including
+// the observers registered later. nil removes the filter.
+// return -1 if the connection is released, -2 if there are more than VideoFrameFilterMaxRules rules or a uid is too long,
+// -3 if more than VideoFrameFilterMaxObservers observers have a filter
+func (conn *RtcConnection) SetVideoFrameFilter(filter *VideoFrameFilter) int {
+	if conn.cConnection == nil {
+		return -1
+	}
+	if filter != nil {
+		if len(filter.Rules) > VideoFrameFilterMaxRules {
+			return -2
+		}
+		copied := *filter
+		copied.Rules = append([]VideoFrameFilterRule(nil), filter.Rules...)
+		filter = &copied
+	}
+	// build both before attaching, so that a bad rule changes nothing
+	var cVideoFilter, cEncodedFilter unsafe.Pointer
+	if conn.cVideoObserver != nil && filter != nil {
+		if cVideoFilter = newCVideoFrameFilter(filter); cVideoFilter == nil {
+			return -2
+		}
+	}
+	if conn.cEncodedVideoObserver != nil && filter != nil {
+		if cEncodedFilter = newCVideoFrameFilter(filter); cEncodedFilter == nil {
+			C.cgo_video_filter_destroy(cVideoFilter)
+			return -2
+		}
+	}
+	conn.videoFrameFilter = filter
+	ret := 0
+	if conn.cVideoObserver != nil && C.cgo_video_filter_attach(conn.cVideoObserver, cVideoFilter) != 0 {
+		ret = -3
+	}
+	if conn.cEncodedVideoObserver != nil && C.cgo_video_filter_attach(conn.cEncodedVideoObserver, cEncodedFilter) != 0 {
+		ret = -3
+	}
+	return ret
+}
+
+// GetVideoFrameFilterStats returns the frames delivered and dropped by the filter of the raw and the encoded video observer.
+func (conn *RtcConnection) GetVideoFrameFilterStats() (delivered uint64, dropped uint64) {
+	var d, x C.uint64_t
+	if conn.cVideoObserver != nil {
+		C.cgo_video_filter_stats(conn.cVideoObserver, &d, &x)
+		delivered += uint64(d)
+		dropped += uint64(x)
+	}
+	if conn.cEncodedVideoObserver != nil {
+		C.cgo_video_filter_stats(conn.cEncodedVideoObserver, &d, &x)
+		delivered += uint64(d)
+		dropped += uint64(x)
+	}
+	return delivered, dropped
+}
+
+// applyVideoFrameFilter attaches the filter of the connection to a newly created observer
+func (conn *RtcConnection) applyVideoFrameFilter(cObserver unsafe.Pointer) {
+	if conn.videoFrameFilter == nil || cObserver == nil {
+		return
+	}
+	cFilter := newCVideoFrameFilter(conn.videoFrameFilter)
+	if cFilter != nil && C.cgo_video_filter_attach(cObserver, cFilter) != 0 {
+		fmt.Printf("failed to attach the video frame filter, more than %d observers have one\n", VideoFrameFilterMaxObservers)
+	}
+}
+
+func newCVideoFrameFilter(filter *VideoFrameFilter) unsafe.Pointer {
+	cFilter := C.cgo_video_filter_create(CIntFromBool(filter.AllowListOnly), C.int(filter.DefaultMaxFps),
+		CIntFromBool(filter.DefaultKeyFrameOnly))
+	if cFilter == nil {
+		return nil
+	}
+	for _, rule := range filter.Rules {
+		cUid := C.CString(rule.Uid)
+		ret := C.cgo_video_filter_add_rule(cFilter, cUid, C.int(rule.MaxFps), CIntFromBool(rule.KeyFrameOnly))
+		C.free(unsafe.Pointer(cUid))
+		if ret != 0 {
+			C.cgo_video_filter_destroy(cFilter)
+			return nil
+		}
+	}
+	return cFilter
+}
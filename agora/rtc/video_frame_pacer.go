@@ -0,0 +1,294 @@
+package agoraservice
+
+import (
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+/*
+* VideoFramePacer sits in front of VideoFrameSender/RtcConnection.PushVideoFrame and never lets frames
+* pile up in the sdk:
+* - a token bucket enforces the target fps, a frame without token is dropped, not queued
+* - a frame whose Timestamp(unix ms) is older than MaxFrameAge is dropped
+* - when LocalVideoTrackStats show the encoder running behind its input, the encoder steps down:
+*   fps first, then resolution, through SetVideoEncoderConfiguration; it steps back up after the
+*   encoder has kept up for a while.
+* rented frames(RentVideoFrame) which are dropped are released.
+* usage:
+* pacer := conn.NewVideoFramePacer(&VideoFramePacerConfig{Encoder: *encoderCfg, OnDrop: func(f *ExternalVideoFrame, r VideoFrameDropReason) {...}})
+* localUserObserver.OnLocalVideoTrackStatistics = func(localUser *LocalUser, stats *LocalVideoTrackStats) {
+*     pacer.OnLocalVideoTrackStatistics(stats)
+* }
+* pacer.SendVideoFrame(frame) // instead of conn.PushVideoFrame(frame)
+ */
+
+type VideoFrameDropReason int
+
+const (
+	VideoFrameDropRateLimited VideoFrameDropReason = 1 // above the current fps
+	VideoFrameDropStale       VideoFrameDropReason = 2 // older than MaxFrameAge
+)
+
+type VideoFramePacerConfig struct {
+	// the configuration at full quality, Framerate is the target fps. it is applied by NewVideoFramePacer, so
+	// Width and Height are required unless the pacer only paces. the other zero fields get the defaults of
+	// NewVideoEncoderConfiguration, Bitrate 0 is the standard bitrate.
+	Encoder VideoEncoderConfiguration
+	// frames older than this are dropped, by their Timestamp in unix ms, 0: 200ms, <0: never
+	MaxFrameAge time.Duration
+	// frames which can be sent back to back after a pause, default 2
+	Burst int
+	// the encoder lags when EncodeFrameRate < LagRatio * InputFrameRate, default 0.8
+	LagRatio float64
+	// consecutive lagging stats reports before a step down, default 2(the sdk reports every 2s)
+	StepDownReports int
+	// consecutive healthy stats reports before a step up, default 5
+	StepUpReports int
+	// called for every dropped frame, before a rented frame is released
+	OnDrop func(frame *ExternalVideoFrame, reason VideoFrameDropReason)
+}
+
+// VideoFramePacerStats are the counters of a pacer, Level is the current step, 0 is full quality.
+type VideoFramePacerStats struct {
+	Sent         uint64
+	DroppedRate  uint64
+	DroppedStale uint64
+	SendErrors   uint64
+	StepDowns    uint64
+	StepUps      uint64
+	Level        int
+	Width        int
+	Height       int
+	Framerate    int
+}
+
+type videoPacerLevel struct {
+	width, height, fps int
+}
+
+type VideoFramePacer struct {
+	config     VideoFramePacerConfig
+	send       func(frame *ExternalVideoFrame) int
+	setEncoder func(cfg *VideoEncoderConfiguration) int
+	levels     []videoPacerLevel
+
+	mu         sync.Mutex
+	level      int
+	tokens     float64
+	lastRefill time.Time
+	lagReports int
+	okReports  int
+
+	// serializes setEncoder, which is called without mu so that SendVideoFrame doesn't wait for the sdk
+	encoderMu    sync.Mutex
+	appliedLevel int
+
+	sent         uint64
+	droppedRate  uint64
+	droppedStale uint64
+	sendErrors   uint64
+	stepDowns    uint64
+	stepUps      uint64
+}
+
+// NewVideoFramePacer creates a pacer of the video track of the connection, which must publish yuv frames,
+// config.Encoder must have the Width and Height.
+func (conn *RtcConnection) NewVideoFramePacer(config *VideoFramePacerConfig) *VideoFramePacer {
+	if conn == nil || conn.videoSender == nil {
+		return nil
+	}
+	return NewVideoFramePacer(conn.PushVideoFrame, conn.SetVideoEncoderConfiguration, config)
+}
+
+// NewVideoFramePacer creates a pacer sending with send and stepping the encoder with setEncoder, which may be nil
+// to only pace, e.g. sender.SendVideoFrame and track.SetVideoEncoderConfiguration. with setEncoder, config.Encoder
+// must have the Width and Height, otherwise nil is returned.
+func NewVideoFramePacer(send func(frame *ExternalVideoFrame) int, setEncoder func(cfg *VideoEncoderConfiguration) int,
+	config *VideoFramePacerConfig) *VideoFramePacer {
+	if send == nil {
+		return nil
+	}
+	cfg := VideoFramePacerConfig{}
+	if config != nil {
+		cfg = *config
+	}
+	// the zero fields of the encoder configuration get the defaults of NewVideoEncoderConfiguration,
+	// except the size which the steps are computed from
+	defaults := NewVideoEncoderConfiguration()
+	if cfg.Encoder.CodecType == VideoCodecTypeNone {
+		cfg.Encoder.CodecType = defaults.CodecType
+	}
+	if cfg.Encoder.Framerate <= 0 {
+		cfg.Encoder.Framerate = defaults.Framerate
+	}
+	if cfg.Encoder.MinBitrate == 0 {
+		cfg.Encoder.MinBitrate = defaults.MinBitrate
+	}
+	if setEncoder != nil && (cfg.Encoder.Width <= 0 || cfg.Encoder.Height <= 0) {
+		return nil
+	}
+	if cfg.MaxFrameAge == 0 {
+		cfg.MaxFrameAge = 200 * time.Millisecond
+	}
+	if cfg.Burst <= 0 {
+		cfg.Burst = 2
+	}
+	if cfg.LagRatio <= 0 {
+		cfg.LagRatio = 0.8
+	}
+	if cfg.StepDownReports <= 0 {
+		cfg.StepDownReports = 2
+	}
+	if cfg.StepUpReports <= 0 {
+		cfg.StepUpReports = 5
+	}
+	p := &VideoFramePacer{
+		config:     cfg,
+		send:       send,
+		setEncoder: setEncoder,
+		levels:     videoPacerLevels(cfg.Encoder.Width, cfg.Encoder.Height, cfg.Encoder.Framerate),
+		tokens:     float64(cfg.Burst),
+		lastRefill: time.Now(),
+	}
+	p.appliedLevel = -1
+	p.applyLevel()
+	return p
+}
+
+// videoPacerLevels is the step down ladder: 2/3 fps, then 3/4 and 1/2 resolution, then 1/2 fps.
+// the resolution steps are skipped when the configuration leaves it to the sdk(0x0).
+func videoPacerLevels(width int, height int, fps int) []videoPacerLevel {
+	reduced := (fps*2 + 2) / 3
+	levels := []videoPacerLevel{{width, height, fps}}
+	if reduced < fps {
+		levels = append(levels, videoPacerLevel{width, height, reduced})
+	}
+	if width > 0 && height > 0 {
+		levels = append(levels,
+			videoPacerLevel{(width * 3 / 4) &^ 1, (height * 3 / 4) &^ 1, reduced},
+			videoPacerLevel{(width / 2) &^ 1, (height / 2) &^ 1, reduced})
+	} else {
+		width, height = 0, 0
+	}
+	half := (fps + 1) / 2
+	if half < reduced {
+		levels = append(levels, videoPacerLevel{(width / 2) &^ 1, (height / 2) &^ 1, half})
+	}
+	return levels
+}
+
+// SendVideoFrame sends frame now or drops it, it never blocks nor queues.
+// returns the result of the send, or 1 if the frame was dropped.
+func (p *VideoFramePacer) SendVideoFrame(frame *ExternalVideoFrame) int {
+	now := time.Now()
+	if p.config.MaxFrameAge > 0 && frame.Timestamp > 0 &&
+		now.UnixMilli()-frame.Timestamp > p.config.MaxFrameAge.Milliseconds() {
+		atomic.AddUint64(&p.droppedStale, 1)
+		p.drop(frame, VideoFrameDropStale)
+		return 1
+	}
+	p.mu.Lock()
+	fps := float64(p.levels[p.level].fps)
+	p.tokens += now.Sub(p.lastRefill).Seconds() * fps
+	if burst := float64(p.config.Burst); p.tokens > burst {
+		p.tokens = burst
+	}
+	p.lastRefill = now
+	if p.tokens < 1 {
+		p.mu.Unlock()
+		atomic.AddUint64(&p.droppedRate, 1)
+		p.drop(frame, VideoFrameDropRateLimited)
+		return 1
+	}
+	p.tokens--
+	p.mu.Unlock()
+
+	ret := p.send(frame)
+	if ret != 0 {
+		atomic.AddUint64(&p.sendErrors, 1)
+	} else {
+		atomic.AddUint64(&p.sent, 1)
+	}
+	return ret
+}
+
+func (p *VideoFramePacer) drop(frame *ExternalVideoFrame, reason VideoFrameDropReason) {
+	if p.config.OnDrop != nil {
+		p.config.OnDrop(frame, reason)
+	}
+	frame.Release()
+}
+
+// OnLocalVideoTrackStatistics feeds the encoder stats of the track, call it from
+// LocalUserObserver.OnLocalVideoTrackStatistics.
+func (p *VideoFramePacer) OnLocalVideoTrackStatistics(stats *LocalVideoTrackStats) {
+	if stats == nil || stats.InputFrameRate <= 0 {
+		return
+	}
+	lagging := float64(stats.EncodeFrameRate) < p.config.LagRatio*float64(stats.InputFrameRate)
+	changed := false
+	p.mu.Lock()
+	if lagging {
+		p.okReports = 0
+		p.lagReports++
+		if p.lagReports >= p.config.StepDownReports && p.level < len(p.levels)-1 {
+			p.level++
+			p.lagReports = 0
+			atomic.AddUint64(&p.stepDowns, 1)
+			changed = true
+		}
+	} else {
+		p.lagReports = 0
+		p.okReports++
+		if p.okReports >= p.config.StepUpReports && p.level > 0 {
+			p.level--
+			p.okReports = 0
+			atomic.AddUint64(&p.stepUps, 1)
+			changed = true
+		}
+	}
+	p.mu.Unlock()
+	if changed {
+		p.applyLevel()
+	}
+}
+
+// applyLevel configures the encoder for the current level, it must be called without p.mu.
+// the level is read again under encoderMu, so concurrent calls leave the encoder at the latest level.
+func (p *VideoFramePacer) applyLevel() {
+	if p.setEncoder == nil {
+		return
+	}
+	p.encoderMu.Lock()
+	defer p.encoderMu.Unlock()
+	p.mu.Lock()
+	index := p.level
+	p.mu.Unlock()
+	if index == p.appliedLevel {
+		return
+	}
+	level := p.levels[index]
+	cfg := p.config.Encoder
+	cfg.Width, cfg.Height, cfg.Framerate = level.width, level.height, level.fps
+	p.setEncoder(&cfg)
+	p.appliedLevel = index
+}
+
+func (p *VideoFramePacer) Stats() VideoFramePacerStats {
+	p.mu.Lock()
+	level := p.level
+	p.mu.Unlock()
+	return VideoFramePacerStats{
+		Sent:         atomic.LoadUint64(&p.sent),
+		DroppedRate:  atomic.LoadUint64(&p.droppedRate),
+		DroppedStale: atomic.LoadUint64(&p.droppedStale),
+		SendErrors:   atomic.LoadUint64(&p.sendErrors),
+		StepDowns:    atomic.LoadUint64(&p.stepDowns),
+		StepUps:      atomic.LoadUint64(&p.stepUps),
+		Level:        level,
+		Width:        p.levels[level].width,
+		Height:       p.levels[level].height,
+		Framerate:    p.levels[level].fps,
+	}
+}
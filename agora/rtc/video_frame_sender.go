@@ -5,7 +5,10 @@ package agoraservice
 // #include <stdint.h>
 // #include "agora_media_node_factory.h"
 import "C"
-import "unsafe"
+import (
+	"runtime"
+	"unsafe"
+)
 
 type ColorSpaceType struct {
 	// The indices are equal to the values specified in T-REC H.273 Table 2.
@@ -74,6 +77,9 @@ type ExternalVideoFrame struct {
 	 *  The color_space_type
 	 */
 	ColorSpace ColorSpaceType
+
+	// set by VideoFrameSender.RentVideoFrame, Buffer is returned to the pool after SendVideoFrame
+	pooled *VideoBuffer
 }
 
 // VideoFrame represents a video frame.
@@ -103,6 +109,35 @@ type VideoFrame struct {
 	// 4: Alphabuffer is on the right of frame;
 	// The default value is 0.
 	AlphaMode int
+
+	// the pooled buffer of YBuffer/UBuffer/VBuffer, set by GoVideoFrame
+	pooled *VideoBuffer
+}
+
+// Release returns the planes of a received frame to the video buffer pool, the frame must not be used after.
+// it's optional: a frame which is not released is garbage collected as before.
+func (f *VideoFrame) Release() {
+	if f.pooled == nil {
+		return
+	}
+	pooled := f.pooled
+	f.pooled = nil
+	f.YBuffer = nil
+	f.UBuffer = nil
+	f.VBuffer = nil
+	pooled.Release()
+}
+
+// Release returns the buffer of a rented frame which is not going to be sent, e.g. a dropped frame.
+// SendVideoFrame releases it otherwise.
+func (f *ExternalVideoFrame) Release() {
+	if f.pooled == nil {
+		return
+	}
+	pooled := f.pooled
+	f.pooled = nil
+	f.Buffer = nil
+	pooled.Release()
 }
 
 type VideoFrameSender struct {
@@ -127,9 +162,44 @@ func (sender *VideoFrameSender) Release() {
 	sender.cSender = nil
 }
 
+// RentVideoFrame returns a raw data frame whose Buffer is rented from the video buffer pool, with
+// VideoBufferSize(format, width, height, stride) bytes. fill Buffer and pass the frame to SendVideoFrame,
+// which returns the buffer to the pool, or Release it: with huge pages enabled, a buffer which is neither
+// is never unmapped. return nil if the format is not supported
+func (sender *VideoFrameSender) RentVideoFrame(format VideoPixelFormat, width int, height int, stride int) *ExternalVideoFrame {
+	buf := defaultVideoBufferPool.Rent(VideoBufferKey{Format: format, Width: width, Height: height, Stride: stride})
+	if buf == nil {
+		return nil
+	}
+	return &ExternalVideoFrame{
+		Type:      VideoBufferRawData,
+		Format:    format,
+		Buffer:    buf.Data,
+		Stride:    stride,
+		Height:    height,
+		CropRight: stride - width,
+		pooled:    buf,
+	}
+}
+
 func (sender *VideoFrameSender) SendVideoFrame(frame *ExternalVideoFrame) int {
-	cData, pinner := unsafeCBytes(frame.Buffer)
-	defer pinner.Unpin()
+	if frame.pooled != nil {
+		// the sdk copies the frame in agora_video_frame_sender_send, so the buffer can be reused after
+		defer func() {
+			frame.pooled.Release()
+			frame.pooled = nil
+			frame.Buffer = nil
+		}()
+	}
+	var cData unsafe.Pointer
+	if frame.pooled != nil && frame.pooled.mapping != nil {
+		// huge page buffers are not go memory, no need to pin
+		cData = unsafe.Pointer(&frame.Buffer[0])
+	} else {
+		var pinner runtime.Pinner
+		cData, pinner = unsafeCBytes(frame.Buffer)
+		defer pinner.Unpin()
+	}
 	cFrame := C.struct__external_video_frame{}
 	C.memset(unsafe.Pointer(&cFrame), 0, C.sizeof_struct__external_video_frame)
 	cFrame._type = C.int(frame.Type)
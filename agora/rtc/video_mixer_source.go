@@ -0,0 +1,272 @@
+package agoraservice
+
+// #cgo CFLAGS: -I${SRCDIR}/../headers/include/c/api2 -I${SRCDIR}/../headers/include/c/base
+// #include <stdlib.h>
+// #include <string.h>
+// #include "agora_service.h"
+// #include "agora_media_node_factory.h"
+// #include "agora_video_mixer_source.h"
+import "C"
+import "unsafe"
+
+/*
+* VideoMixerSource composes video tracks, images and a background into one video stream inside the
+* sdk media engine, no frame crosses into go. the mixed stream is published with a track from
+* NewMixedVideoTrack.
+* usage: a 2x1 grid of two subscribed remote users, published by conn
+* mixer := NewVideoMixerSource()
+* mixer.SetBackgroundColor(1280, 360, 15, 0xff000000)
+* // in OnUserVideoTrackSubscribed:
+* mixer.AddRemoteVideoTrack(uid, remoteVideoTrack)
+* mixer.SetStreamLayout(uid, &VideoMixerLayout{Left: 0, Width: 640, Height: 360, Alpha: 1})
+* mixer.Refresh()
+* track := NewMixedVideoTrack(mixer)
+* track.SetVideoEncoderConfiguration(&VideoEncoderConfiguration{CodecType: VideoCodecTypeH264, Width: 1280, Height: 360, Framerate: 15})
+* conn.PublishVideoTrack(track)
+* ...
+* conn.UnpublishVideoTrack(track)
+* track.Release()
+* mixer.Release()
+ */
+
+type VideoMixerImageType int
+
+const (
+	VideoMixerImageTypeUnknown VideoMixerImageType = 0
+	VideoMixerImageTypePng     VideoMixerImageType = 1
+	VideoMixerImageTypeJpeg    VideoMixerImageType = 2
+	VideoMixerImageTypeGif     VideoMixerImageType = 3
+)
+
+// VideoMixerLayout is the position of a stream or an image on the mixer canvas, in pixels.
+type VideoMixerLayout struct {
+	Top    uint32
+	Left   uint32
+	Width  uint32
+	Height uint32
+	ZOrder int32
+	// 0.0: transparent, 1.0: opaque
+	Alpha  float32
+	Mirror bool
+	// only for images, the local path of the image file
+	ImagePath string
+}
+
+type VideoMixerSource struct {
+	cMixer unsafe.Pointer
+}
+
+func (mediaNodeFactory *MediaNodeFactory) NewVideoMixerSource() *VideoMixerSource {
+	mixer := C.agora_media_node_factory_create_video_mixer(mediaNodeFactory.cFactory)
+	if mixer == nil {
+		return nil
+	}
+	return &VideoMixerSource{
+		cMixer: mixer,
+	}
+}
+
+// NewVideoMixerSource creates a mixer with the media node factory of the service.
+func NewVideoMixerSource() *VideoMixerSource {
+	if agoraService == nil || agoraService.mediaFactory == nil {
+		return nil
+	}
+	return agoraService.mediaFactory.NewVideoMixerSource()
+}
+
+// Release destroys the mixer, the mixed track must be released before.
+func (mixer *VideoMixerSource) Release() {
+	if mixer == nil || mixer.cMixer == nil {
+		return
+	}
+	C.agora_video_mixer_destroy(mixer.cMixer)
+	mixer.cMixer = nil
+}
+
+// AddVideoTrack mixes a local video track as stream id.
+func (mixer *VideoMixerSource) AddVideoTrack(id string, track *LocalVideoTrack) int {
+	if track == nil {
+		return -2
+	}
+	return mixer.addVideoTrack(id, track.cTrack)
+}
+
+func (mixer *VideoMixerSource) RemoveVideoTrack(id string, track *LocalVideoTrack) int {
+	if track == nil {
+		return -2
+	}
+	return mixer.removeVideoTrack(id, track.cTrack)
+}
+
+// AddRemoteVideoTrack mixes a subscribed remote video track as stream id, the track must be removed
+// before the user is unsubscribed or leaves.
+func (mixer *VideoMixerSource) AddRemoteVideoTrack(id string, track *RemoteVideoTrack) int {
+	if track == nil {
+		return -2
+	}
+	return mixer.addVideoTrack(id, track.cRemoteVideoTrack)
+}
+
+func (mixer *VideoMixerSource) RemoveRemoteVideoTrack(id string, track *RemoteVideoTrack) int {
+	if track == nil {
+		return -2
+	}
+	return mixer.removeVideoTrack(id, track.cRemoteVideoTrack)
+}
+
+func (mixer *VideoMixerSource) addVideoTrack(id string, cTrack unsafe.Pointer) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	if cTrack == nil {
+		return -2
+	}
+	cId := C.CString(id)
+	defer C.free(unsafe.Pointer(cId))
+	C.agora_video_mixer_add_video_track(mixer.cMixer, cId, cTrack)
+	return 0
+}
+
+func (mixer *VideoMixerSource) removeVideoTrack(id string, cTrack unsafe.Pointer) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	if cTrack == nil {
+		return -2
+	}
+	cId := C.CString(id)
+	defer C.free(unsafe.Pointer(cId))
+	C.agora_video_mixer_remove_video_track(mixer.cMixer, cId, cTrack)
+	return 0
+}
+
+// SetStreamLayout places stream id on the canvas, call Refresh to apply a batch of layout changes.
+func (mixer *VideoMixerSource) SetStreamLayout(id string, layout *VideoMixerLayout) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	if layout == nil {
+		return -2
+	}
+	cId := C.CString(id)
+	defer C.free(unsafe.Pointer(cId))
+	cLayout, cImagePath := cVideoMixerLayout(layout)
+	defer C.free(unsafe.Pointer(cImagePath))
+	C.agora_video_mixer_set_stream_layout(mixer.cMixer, cId, cLayout)
+	return 0
+}
+
+func (mixer *VideoMixerSource) DelStreamLayout(id string) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	cId := C.CString(id)
+	defer C.free(unsafe.Pointer(cId))
+	C.agora_video_mixer_del_stream_layout(mixer.cMixer, cId)
+	return 0
+}
+
+// AddImageSource places the image layout.ImagePath on the canvas as id.
+func (mixer *VideoMixerSource) AddImageSource(id string, layout *VideoMixerLayout, imageType VideoMixerImageType) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	if layout == nil || layout.ImagePath == "" {
+		return -2
+	}
+	cId := C.CString(id)
+	defer C.free(unsafe.Pointer(cId))
+	cLayout, cImagePath := cVideoMixerLayout(layout)
+	defer C.free(unsafe.Pointer(cImagePath))
+	C.agora_video_mixer_add_image_source(mixer.cMixer, cId, cLayout, C.int(imageType))
+	return 0
+}
+
+func (mixer *VideoMixerSource) DelImageSource(id string) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	cId := C.CString(id)
+	defer C.free(unsafe.Pointer(cId))
+	C.agora_video_mixer_del_image_source(mixer.cMixer, cId)
+	return 0
+}
+
+// ClearLayout removes all the stream and image layouts.
+func (mixer *VideoMixerSource) ClearLayout() int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	C.clearLayout(mixer.cMixer)
+	return 0
+}
+
+// Refresh applies the layout changes.
+func (mixer *VideoMixerSource) Refresh() int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	C.agora_video_mixer_refresh(mixer.cMixer)
+	return 0
+}
+
+// SetBackgroundColor sets the canvas size, the output fps and the background color in argb.
+func (mixer *VideoMixerSource) SetBackgroundColor(width uint32, height uint32, fps int, colorArgb uint32) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	C.agora_video_mixer_set_background_color(mixer.cMixer, C.uint32_t(width), C.uint32_t(height), C.int(fps), C.uint32_t(colorArgb))
+	return 0
+}
+
+// SetBackgroundUrl sets the canvas size, the output fps and a background image.
+func (mixer *VideoMixerSource) SetBackgroundUrl(width uint32, height uint32, fps int, url string) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	cUrl := C.CString(url)
+	defer C.free(unsafe.Pointer(cUrl))
+	C.agora_video_mixer_set_background_url(mixer.cMixer, C.uint32_t(width), C.uint32_t(height), C.int(fps), cUrl)
+	return 0
+}
+
+// SetRotation rotates the mixed stream, 0: none, 1: 90, 2: 180, 3: 270 degrees.
+func (mixer *VideoMixerSource) SetRotation(rotation uint8) int {
+	if mixer == nil || mixer.cMixer == nil {
+		return -1
+	}
+	C.agora_video_mixer_set_rotation(mixer.cMixer, C.uint8_t(rotation))
+	return 0
+}
+
+// cVideoMixerLayout converts layout, the caller frees the returned image path(nil if none).
+func cVideoMixerLayout(layout *VideoMixerLayout) (*C.mixer_layout_config, *C.char) {
+	cLayout := &C.mixer_layout_config{}
+	cLayout.top = C.uint32_t(layout.Top)
+	cLayout.left = C.uint32_t(layout.Left)
+	cLayout.width = C.uint32_t(layout.Width)
+	cLayout.height = C.uint32_t(layout.Height)
+	cLayout.z_order = C.int32_t(layout.ZOrder)
+	cLayout.alpha = C.float(layout.Alpha)
+	cLayout.mirror = C.uint8_t(CIntFromBool(layout.Mirror))
+	var cImagePath *C.char
+	if layout.ImagePath != "" {
+		cImagePath = C.CString(layout.ImagePath)
+		cLayout.image_path = cImagePath
+	}
+	return cLayout, cImagePath
+}
+
+// NewMixedVideoTrack creates a local video track of the output of mixer.
+func NewMixedVideoTrack(mixer *VideoMixerSource) *LocalVideoTrack {
+	if mixer == nil || mixer.cMixer == nil {
+		return nil
+	}
+	cTrack := C.agora_service_create_mixed_video_track(agoraService.service, mixer.cMixer)
+	if cTrack == nil {
+		return nil
+	}
+	return &LocalVideoTrack{
+		cTrack: cTrack,
+	}
+}
@@ -0,0 +1,191 @@
+package agoraservice
+
+import (
+	"bytes"
+	"encoding/binary"
+)
+
+/*
+* NAL unit parsing of H.264/H.265 access units, in Annex-B(start codes) or AVCC(length prefixed) form.
+* the parser only records offsets into the buffer, nothing is copied, so it can be used on the
+* borrowed imageBuffer of VideoEncodedFrameObserver.
+* usage:
+* var nals []VideoNalUnit
+* nals = ParseAnnexBNalUnits(info.CodecType, imageBuffer, nals[:0])
+* if IsVideoKeyFrame(info.CodecType, nals) {
+*     var ps VideoParameterSets
+*     ps.Extract(info.CodecType, imageBuffer, nals)
+*     ... ps.SPS[0] is a view into imageBuffer
+* }
+ */
+
+// VideoNalUnit is a NAL unit of an access unit, Offset is the position of the NAL header in the buffer,
+// Size excludes the start code or the length prefix.
+type VideoNalUnit struct {
+	Offset int
+	Size   int
+	Type   int
+}
+
+// Payload returns the NAL unit, header included, as a view of data.
+func (u VideoNalUnit) Payload(data []byte) []byte {
+	return data[u.Offset : u.Offset+u.Size : u.Offset+u.Size]
+}
+
+const (
+	H264NalTypeSlice = 1
+	H264NalTypeIdr   = 5
+	H264NalTypeSei   = 6
+	H264NalTypeSps   = 7
+	H264NalTypePps   = 8
+	H264NalTypeAud   = 9
+
+	H265NalTypeBlaWLp   = 16
+	H265NalTypeIdrWRadl = 19
+	H265NalTypeIdrNLp   = 20
+	H265NalTypeCra      = 21
+	H265NalTypeVps      = 32
+	H265NalTypeSps      = 33
+	H265NalTypePps      = 34
+	H265NalTypeAud      = 35
+	H265NalTypeSei      = 39
+)
+
+var annexBStartCode = []byte{0, 0, 1}
+
+func isH265Codec(codec VideoCodecType) bool {
+	return codec == VideoCodecTypeH265
+}
+
+// nalUnitType returns the type from the first byte(s) of a NAL unit, -1 if it is empty.
+func nalUnitType(codec VideoCodecType, nal []byte) int {
+	if len(nal) == 0 {
+		return -1
+	}
+	if isH265Codec(codec) {
+		return int(nal[0]>>1) & 0x3f
+	}
+	return int(nal[0]) & 0x1f
+}
+
+// ParseAnnexBNalUnits appends the NAL units of an Annex-B access unit to dst and returns it.
+// both 3 and 4 bytes start codes are accepted, bytes before the first start code are ignored.
+// codec is VideoCodecTypeH264(or GenericH264) or VideoCodecTypeH265.
+func ParseAnnexBNalUnits(codec VideoCodecType, data []byte, dst []VideoNalUnit) []VideoNalUnit {
+	pos := bytes.Index(data, annexBStartCode)
+	if pos < 0 {
+		return dst
+	}
+	start := pos + 3
+	for start < len(data) {
+		next := bytes.Index(data[start:], annexBStartCode)
+		end := len(data)
+		if next >= 0 {
+			end = start + next
+		}
+		// the zero of a 4 bytes start code and trailing_zero_8bits belong to the next start code
+		size := end - start
+		if next >= 0 {
+			for size > 0 && data[start+size-1] == 0 {
+				size--
+			}
+		}
+		if size > 0 {
+			dst = append(dst, VideoNalUnit{Offset: start, Size: size, Type: nalUnitType(codec, data[start:])})
+		}
+		if next < 0 {
+			break
+		}
+		start = end + 3
+	}
+	return dst
+}
+
+// ParseAvccNalUnits appends the NAL units of an AVCC(length prefixed) access unit to dst and returns it,
+// lengthSize is the NALUnitLength size of the avcC/hvcC record: 1, 2, 3 or 4.
+// ok is false if a length runs past the end of data, dst then holds the units parsed so far.
+func ParseAvccNalUnits(codec VideoCodecType, data []byte, lengthSize int, dst []VideoNalUnit) ([]VideoNalUnit, bool) {
+	if lengthSize < 1 || lengthSize > 4 {
+		return dst, false
+	}
+	pos := 0
+	for pos < len(data) {
+		if len(data)-pos < lengthSize {
+			return dst, false
+		}
+		var size int
+		switch lengthSize {
+		case 1:
+			size = int(data[pos])
+		case 2:
+			size = int(binary.BigEndian.Uint16(data[pos:]))
+		case 3:
+			size = int(data[pos])<<16 | int(data[pos+1])<<8 | int(data[pos+2])
+		case 4:
+			size = int(binary.BigEndian.Uint32(data[pos:]))
+		}
+		pos += lengthSize
+		if size > len(data)-pos {
+			return dst, false
+		}
+		if size > 0 {
+			dst = append(dst, VideoNalUnit{Offset: pos, Size: size, Type: nalUnitType(codec, data[pos:])})
+		}
+		pos += size
+	}
+	return dst, true
+}
+
+// IsVideoKeyNalUnit reports whether a NAL unit of type nalType starts a random access point:
+// IDR for H.264, IRAP(BLA/IDR/CRA) for H.265.
+func IsVideoKeyNalUnit(codec VideoCodecType, nalType int) bool {
+	if isH265Codec(codec) {
+		return nalType >= H265NalTypeBlaWLp && nalType <= H265NalTypeCra
+	}
+	return nalType == H264NalTypeIdr
+}
+
+// IsVideoKeyFrame reports whether the access unit contains a random access NAL unit.
+func IsVideoKeyFrame(codec VideoCodecType, nals []VideoNalUnit) bool {
+	for i := range nals {
+		if IsVideoKeyNalUnit(codec, nals[i].Type) {
+			return true
+		}
+	}
+	return false
+}
+
+// VideoParameterSets holds views of the parameter sets of an access unit, VPS is for H.265 only.
+type VideoParameterSets struct {
+	VPS [][]byte
+	SPS [][]byte
+	PPS [][]byte
+}
+
+// Reset empties the sets and keeps their capacity.
+func (ps *VideoParameterSets) Reset() {
+	ps.VPS = ps.VPS[:0]
+	ps.SPS = ps.SPS[:0]
+	ps.PPS = ps.PPS[:0]
+}
+
+// Extract resets ps and fills it with the parameter sets in nals, the slices are views of data.
+// it returns the number of parameter sets found.
+func (ps *VideoParameterSets) Extract(codec VideoCodecType, data []byte, nals []VideoNalUnit) int {
+	ps.Reset()
+	vps, sps, pps := -1, H264NalTypeSps, H264NalTypePps
+	if isH265Codec(codec) {
+		vps, sps, pps = H265NalTypeVps, H265NalTypeSps, H265NalTypePps
+	}
+	for i := range nals {
+		switch nals[i].Type {
+		case vps:
+			ps.VPS = append(ps.VPS, nals[i].Payload(data))
+		case sps:
+			ps.SPS = append(ps.SPS, nals[i].Payload(data))
+		case pps:
+			ps.PPS = append(ps.PPS, nals[i].Payload(data))
+		}
+	}
+	return len(ps.VPS) + len(ps.SPS) + len(ps.PPS)
+}
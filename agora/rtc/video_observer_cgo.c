@@ -1,9 +1,338 @@
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
 #include "video_observer_cgo.h"
 
+#define CGO_VIDEO_FILTER_MAX_RULES 128
+#define CGO_VIDEO_FILTER_MAX_RATES 256
+#define CGO_VIDEO_FILTER_UID_LEN 64
+// power of 2, the observers with a filter
+#define CGO_VIDEO_FILTER_SLOT_BITS 12
+#define CGO_VIDEO_FILTER_SLOTS (1 << CGO_VIDEO_FILTER_SLOT_BITS)
+// same as VideoFrameTypeKey in video_consts.go
+#define CGO_VIDEO_FRAME_TYPE_KEY 3
+
+// a uid is matched on the hash and the string of its uid for raw video, on its number for encoded video
+typedef struct _cgo_video_filter_uid {
+  uint32_t hash;
+  uint32_t uid_num;
+  char uid[CGO_VIDEO_FILTER_UID_LEN];
+} cgo_video_filter_uid;
+
+typedef struct _cgo_video_filter_rule {
+  cgo_video_filter_uid uid;
+  int max_fps;  // 0: no limit
+  int key_frame_only;
+} cgo_video_filter_rule;
+
+// the fps state of a uid, the least recently seen one is evicted when the table is full, so the uids
+// which left the channel don't take the place of the new ones
+typedef struct _cgo_video_filter_rate {
+  cgo_video_filter_uid uid;
+  int64_t next_due_us;
+  int64_t last_seen_us;
+  int gop_accepted;  // encoded video: the decision of the last key frame, which the delta frames follow
+} cgo_video_filter_rate;
+
+typedef struct _cgo_video_filter {
+  int allow_list_only;  // 1: only the uids with a rule are delivered
+  int default_max_fps;
+  int default_key_frame_only;
+  int rule_count;
+  cgo_video_filter_rule rules[CGO_VIDEO_FILTER_MAX_RULES];
+  // the rates are only used by the callbacks of the observer of the filter
+  pthread_mutex_t rate_lock;
+  int rate_count;
+  cgo_video_filter_rate rates[CGO_VIDEO_FILTER_MAX_RATES];
+  uint64_t delivered;
+  uint64_t dropped;
+} cgo_video_filter;
+
+// the filters are found by the observer handle in an open addressing table, without lock. a callback
+// counts itself in the readers of the slot of its observer, which are waited for before the filter of the
+// slot is freed. the slots of the detached observers keep their key, so the probe chains stay intact,
+// and are reused by the next attach. every slot has its own cache line, the callbacks of different
+// connections don't share anything but the read-only filter count.
+typedef struct _cgo_video_filter_slot {
+  AGORA_HANDLE observer;
+  cgo_video_filter* filter;
+  int readers;
+} __attribute__((aligned(64))) cgo_video_filter_slot;
+
+// serializes attach and stats
+static pthread_mutex_t g_video_filter_lock = PTHREAD_MUTEX_INITIALIZER;
+static cgo_video_filter_slot g_video_filter_slots[CGO_VIDEO_FILTER_SLOTS];
+static int g_video_filter_count = 0;
+
+static int64_t cgo_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// fnv-1a
+static uint32_t cgo_uid_hash(const char* uid) {
+  uint32_t hash = 2166136261u;
+  for (; *uid != '\0'; uid++) {
+    hash = (hash ^ (uint8_t)*uid) * 16777619u;
+  }
+  return hash;
+}
+
+static int cgo_uid_equal(const cgo_video_filter_uid* e, const char* uid, uint32_t hash, uint32_t uid_num) {
+  if (uid == NULL) {
+    return e->uid_num == uid_num;
+  }
+  return e->hash == hash && strcmp(e->uid, uid) == 0;
+}
+
+static void cgo_uid_set(cgo_video_filter_uid* e, const char* uid, uint32_t hash, uint32_t uid_num) {
+  if (uid != NULL) {
+    snprintf(e->uid, CGO_VIDEO_FILTER_UID_LEN, "%s", uid);
+    e->hash = hash;
+    e->uid_num = (uint32_t)strtoul(uid, NULL, 10);
+  } else {
+    snprintf(e->uid, CGO_VIDEO_FILTER_UID_LEN, "%u", uid_num);
+    e->hash = cgo_uid_hash(e->uid);
+    e->uid_num = uid_num;
+  }
+}
+
+static uint32_t cgo_video_filter_slot_of(AGORA_HANDLE observer) {
+  return (uint32_t)((((uintptr_t)observer >> 4) * 0x9E3779B97F4A7C15ull) >> (64 - CGO_VIDEO_FILTER_SLOT_BITS));
+}
+
+// returns the slot keyed by observer, or NULL
+static cgo_video_filter_slot* cgo_video_filter_find(AGORA_HANDLE observer) {
+  uint32_t index = cgo_video_filter_slot_of(observer);
+  for (int i = 0; i < CGO_VIDEO_FILTER_SLOTS; i++) {
+    cgo_video_filter_slot* slot = &g_video_filter_slots[(index + i) & (CGO_VIDEO_FILTER_SLOTS - 1)];
+    AGORA_HANDLE key = __atomic_load_n(&slot->observer, __ATOMIC_SEQ_CST);
+    if (key == observer) {
+      return slot;
+    }
+    if (key == NULL) {
+      return NULL;
+    }
+  }
+  return NULL;
+}
+
+static void cgo_video_filter_wait_readers(cgo_video_filter_slot* slot) {
+  while (__atomic_load_n(&slot->readers, __ATOMIC_SEQ_CST) != 0) {
+    sched_yield();
+  }
+}
+
+void* cgo_video_filter_create(int allow_list_only, int default_max_fps, int default_key_frame_only) {
+  cgo_video_filter* filter = (cgo_video_filter*)calloc(1, sizeof(cgo_video_filter));
+  if (filter == NULL) {
+    return NULL;
+  }
+  filter->allow_list_only = allow_list_only;
+  filter->default_max_fps = default_max_fps;
+  filter->default_key_frame_only = default_key_frame_only;
+  pthread_mutex_init(&filter->rate_lock, NULL);
+  return filter;
+}
+
+void cgo_video_filter_destroy(void* handle) {
+  cgo_video_filter* filter = (cgo_video_filter*)handle;
+  if (filter == NULL) {
+    return;
+  }
+  pthread_mutex_destroy(&filter->rate_lock);
+  free(filter);
+}
+
+int cgo_video_filter_add_rule(void* handle, const char* uid, int max_fps, int key_frame_only) {
+  cgo_video_filter* filter = (cgo_video_filter*)handle;
+  if (filter == NULL || uid == NULL || strlen(uid) >= CGO_VIDEO_FILTER_UID_LEN) {
+    return -1;
+  }
+  if (filter->rule_count >= CGO_VIDEO_FILTER_MAX_RULES) {
+    return -2;
+  }
+  cgo_video_filter_rule* rule = &filter->rules[filter->rule_count];
+  cgo_uid_set(&rule->uid, uid, cgo_uid_hash(uid), 0);
+  rule->max_fps = max_fps;
+  rule->key_frame_only = key_frame_only;
+  filter->rule_count++;
+  return 0;
+}
+
+int cgo_video_filter_attach(AGORA_HANDLE observer, void* handle) {
+  cgo_video_filter* filter = (cgo_video_filter*)handle;
+
+  pthread_mutex_lock(&g_video_filter_lock);
+  cgo_video_filter_slot* slot = cgo_video_filter_find(observer);
+  if (slot == NULL && filter != NULL) {
+    // take the first free slot of the probe chain, a detached one or the empty one at its end
+    uint32_t index = cgo_video_filter_slot_of(observer);
+    for (int i = 0; i < CGO_VIDEO_FILTER_SLOTS && slot == NULL; i++) {
+      cgo_video_filter_slot* s = &g_video_filter_slots[(index + i) & (CGO_VIDEO_FILTER_SLOTS - 1)];
+      if (__atomic_load_n(&s->filter, __ATOMIC_SEQ_CST) == NULL) {
+        slot = s;
+      }
+    }
+    if (slot == NULL) {
+      pthread_mutex_unlock(&g_video_filter_lock);
+      cgo_video_filter_destroy(filter);
+      return -1;
+    }
+    // the callbacks recheck the key after counting themselves, so once the readers of the old key are
+    // gone, none can see the new filter under the old key
+    __atomic_store_n(&slot->observer, observer, __ATOMIC_SEQ_CST);
+    cgo_video_filter_wait_readers(slot);
+  }
+
+  cgo_video_filter* old = NULL;
+  if (slot != NULL) {
+    old = __atomic_exchange_n(&slot->filter, filter, __ATOMIC_SEQ_CST);
+    cgo_video_filter_wait_readers(slot);
+    if (old == NULL && filter != NULL) {
+      __atomic_add_fetch(&g_video_filter_count, 1, __ATOMIC_SEQ_CST);
+    } else if (old != NULL && filter == NULL) {
+      __atomic_sub_fetch(&g_video_filter_count, 1, __ATOMIC_SEQ_CST);
+    }
+  }
+  if (old != NULL && filter != NULL) {
+    // keep the counters across rule changes
+    __atomic_add_fetch(&filter->delivered, __atomic_load_n(&old->delivered, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&filter->dropped, __atomic_load_n(&old->dropped, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&g_video_filter_lock);
+
+  cgo_video_filter_destroy(old);
+  return 0;
+}
+
+void cgo_video_filter_stats(AGORA_HANDLE observer, uint64_t* delivered, uint64_t* dropped) {
+  *delivered = 0;
+  *dropped = 0;
+  pthread_mutex_lock(&g_video_filter_lock);
+  cgo_video_filter_slot* slot = cgo_video_filter_find(observer);
+  cgo_video_filter* filter = slot != NULL ? __atomic_load_n(&slot->filter, __ATOMIC_SEQ_CST) : NULL;
+  if (filter != NULL) {
+    *delivered = __atomic_load_n(&filter->delivered, __ATOMIC_RELAXED);
+    *dropped = __atomic_load_n(&filter->dropped, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&g_video_filter_lock);
+}
+
+// returns the fps state of the uid, the caller holds rate_lock
+static cgo_video_filter_rate* cgo_video_filter_rate_of(cgo_video_filter* filter, const char* uid, uint32_t hash,
+                                                       uint32_t uid_num, int64_t now) {
+  cgo_video_filter_rate* oldest = NULL;
+  for (int i = 0; i < filter->rate_count; i++) {
+    cgo_video_filter_rate* rate = &filter->rates[i];
+    if (cgo_uid_equal(&rate->uid, uid, hash, uid_num)) {
+      return rate;
+    }
+    if (oldest == NULL || rate->last_seen_us < oldest->last_seen_us) {
+      oldest = rate;
+    }
+  }
+  cgo_video_filter_rate* rate = filter->rate_count < CGO_VIDEO_FILTER_MAX_RATES ? &filter->rates[filter->rate_count++] : oldest;
+  cgo_uid_set(&rate->uid, uid, hash, uid_num);
+  rate->next_due_us = 0;
+  rate->last_seen_us = now;
+  rate->gop_accepted = 1;
+  return rate;
+}
+
+// returns 1 if the frame is due, and takes its place in the rate
+static int cgo_video_filter_due(cgo_video_filter_rate* rate, int max_fps, int64_t now) {
+  int64_t interval = 1000000 / max_fps;
+  if (now < rate->next_due_us) {
+    return 0;
+  }
+  // keep the average rate when frames arrive a bit late, but do not burst after a pause
+  rate->next_due_us = (now - rate->next_due_us < interval) ? rate->next_due_us + interval : now + interval;
+  return 1;
+}
+
+// key_frame is -1 for raw video
+static int cgo_video_filter_apply(cgo_video_filter* filter, const char* uid, uint32_t uid_num, int key_frame) {
+  uint32_t hash = uid != NULL ? cgo_uid_hash(uid) : 0;
+  const cgo_video_filter_rule* rule = NULL;
+  for (int i = 0; i < filter->rule_count; i++) {
+    if (cgo_uid_equal(&filter->rules[i].uid, uid, hash, uid_num)) {
+      rule = &filter->rules[i];
+      break;
+    }
+  }
+  if (rule == NULL && filter->allow_list_only) {
+    return 0;
+  }
+  int max_fps = rule != NULL ? rule->max_fps : filter->default_max_fps;
+  int key_frame_only = rule != NULL ? rule->key_frame_only : filter->default_key_frame_only;
+  if (key_frame_only && key_frame == 0) {
+    return 0;
+  }
+  if (max_fps <= 0) {
+    return 1;
+  }
+
+  int accept;
+  int64_t now = cgo_now_us();
+  pthread_mutex_lock(&filter->rate_lock);
+  cgo_video_filter_rate* rate = cgo_video_filter_rate_of(filter, uid, hash, uid_num, now);
+  rate->last_seen_us = now;
+  if (key_frame < 0) {
+    accept = cgo_video_filter_due(rate, max_fps, now);
+  } else {
+    // a delta frame can't be decoded without the frames before it, so the encoded video is dropped by
+    // whole gops: the key frame decides for the frames up to the next one
+    if (key_frame) {
+      rate->gop_accepted = cgo_video_filter_due(rate, max_fps, now);
+    }
+    accept = rate->gop_accepted;
+  }
+  pthread_mutex_unlock(&filter->rate_lock);
+  return accept;
+}
+
+// returns 1 if the frame should be delivered to go.
+// uid is the string uid of raw video, or NULL for encoded video which is matched on uid_num.
+// key_frame is -1 for raw video.
+static int cgo_video_filter_accept(AGORA_HANDLE observer, const char* uid, uint32_t uid_num, int key_frame) {
+  if (__atomic_load_n(&g_video_filter_count, __ATOMIC_RELAXED) == 0) {
+    return 1;
+  }
+  cgo_video_filter_slot* slot = cgo_video_filter_find(observer);
+  if (slot == NULL) {
+    return 1;
+  }
+
+  int accept = 1;
+  __atomic_add_fetch(&slot->readers, 1, __ATOMIC_SEQ_CST);
+  cgo_video_filter* filter = NULL;
+  if (__atomic_load_n(&slot->observer, __ATOMIC_SEQ_CST) == observer) {
+    filter = __atomic_load_n(&slot->filter, __ATOMIC_SEQ_CST);
+  }
+  if (filter != NULL) {
+    accept = cgo_video_filter_apply(filter, uid, uid_num, key_frame);
+    __atomic_add_fetch(accept ? &filter->delivered : &filter->dropped, 1, __ATOMIC_RELAXED);
+  }
+  __atomic_sub_fetch(&slot->readers, 1, __ATOMIC_SEQ_CST);
+  return accept;
+}
+
 // this function declaration must be strictly same with the function exported by go
 extern int goOnVideoFrame(void* agora_video_frame_observer2, const char* channelId, const char* uid, const struct _video_frame* frame);
 int cgo_on_video_frame(AGORA_HANDLE agora_video_frame_observer2, const char* channelId, user_id_t uid, const video_frame* frame) {
+  // uid "0" is the local user's callback, which is a bug in current 44.3.1 sdk version, skip it before crossing into go
+  if (uid != NULL && strcmp(uid, "0") == 0) {
+    return 0;
+  }
+  if (!cgo_video_filter_accept(agora_video_frame_observer2, uid != NULL ? uid : "", 0, -1)) {
+    return 0;
+  }
   return goOnVideoFrame(agora_video_frame_observer2, channelId, uid, frame);
 }
 
@@ -11,5 +340,9 @@ extern int goOnEncodedVideoFrame(void* agora_video_encoded_frame_observer, uint3
                                 const struct _encoded_video_frame_info* video_encoded_frame_info);
 int cgo_on_encoded_video_frame(AGORA_HANDLE agora_video_encoded_frame_observer, uint32_t uid, const uint8_t* image_buffer, size_t length,
                                 const encoded_video_frame_info* video_encoded_frame_info) {
+  int key_frame = video_encoded_frame_info != NULL && video_encoded_frame_info->frame_type == CGO_VIDEO_FRAME_TYPE_KEY;
+  if (!cgo_video_filter_accept(agora_video_encoded_frame_observer, NULL, uid, key_frame)) {
+    return 0;
+  }
   return goOnEncodedVideoFrame(agora_video_encoded_frame_observer, uid, image_buffer, length, video_encoded_frame_info);
 }
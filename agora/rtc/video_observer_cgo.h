@@ -13,3 +13,15 @@ extern int cgo_on_video_frame(AGORA_HANDLE agora_video_frame_observer2, const ch
 
 extern int cgo_on_encoded_video_frame(AGORA_HANDLE agora_video_encoded_frame_observer, uid_t uid, const uint8_t* image_buffer, size_t length,
                                 const encoded_video_frame_info* video_encoded_frame_info);
+
+// video frame filter: per observer and per uid rules, applied in the callbacks above before crossing into go,
+// so that the frames which would be discarded are never copied.
+// a filter is built with cgo_video_filter_create/cgo_video_filter_add_rule, then attached to an observer handle,
+// which takes the ownership of it, even if it fails. attaching NULL detaches and frees the current filter.
+// a filter which is not attached is freed with cgo_video_filter_destroy.
+// attach returns -1 if too many observers have a filter.
+extern void* cgo_video_filter_create(int allow_list_only, int default_max_fps, int default_key_frame_only);
+extern void cgo_video_filter_destroy(void* filter);
+extern int cgo_video_filter_add_rule(void* filter, const char* uid, int max_fps, int key_frame_only);
+extern int cgo_video_filter_attach(AGORA_HANDLE observer, void* filter);
+extern void cgo_video_filter_stats(AGORA_HANDLE observer, uint64_t* delivered, uint64_t* dropped);
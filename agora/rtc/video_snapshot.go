@@ -0,0 +1,329 @@
+package agoraservice
+
+import (
+	"bytes"
+	"fmt"
+	"image"
+	"image/jpeg"
+	"os"
+	"path/filepath"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+/*
+* VideoSnapshotService takes periodic jpeg thumbnails of every remote user, for moderation or dashboards.
+* on the sdk thread, a due frame is only downscaled from its planes into a small YCbCr image, nothing
+* else is copied; the jpeg encoding runs on a bounded pool of workers. when all the workers are busy and
+* the queue is full, the snapshot is dropped and retried with the next frame of the user.
+* results go to OnSnapshot, and/or to OutputDir/<channelId>_<uid>.jpg, replaced atomically.
+* usage:
+* snapshots := NewVideoSnapshotService(&VideoSnapshotConfig{Interval: 5 * time.Second, OutputDir: "/tmp/thumbs"})
+* defer snapshots.Close()
+* conn.RegisterVideoFrameObserver(&VideoFrameObserver{OnFrame: snapshots.OnFrame, BorrowFrame: true})
+* or, inside an existing OnFrame: snapshots.Offer(channelId, userId, frame)
+ */
+
+// VideoSnapshot is a jpeg thumbnail of a remote user, Jpeg is owned by the receiver.
+type VideoSnapshot struct {
+	ChannelId    string
+	Uid          string
+	Width        int // of the thumbnail
+	Height       int
+	SourceWidth  int // of the video frame
+	SourceHeight int
+	CapturedAt   time.Time
+	EncodeTime   time.Duration
+	Jpeg         []byte
+}
+
+type VideoSnapshotConfig struct {
+	Interval  time.Duration // per uid, default 5s
+	MaxWidth  int           // the frame is downscaled to fit MaxWidth x MaxHeight, keeping the aspect ratio, default 320x180
+	MaxHeight int
+	Quality   int // jpeg quality, default 75
+	Workers   int // encoding goroutines, default 2
+	QueueSize int // snapshots waiting for a worker, default 4 * Workers
+	// called from a worker goroutine
+	OnSnapshot func(snapshot *VideoSnapshot)
+	// if set, the latest snapshot of each user is written to OutputDir/<channelId>_<uid>.jpg
+	OutputDir string
+}
+
+// VideoSnapshotStats are the counters of a VideoSnapshotService.
+type VideoSnapshotStats struct {
+	Captured      uint64 // frames downscaled and queued
+	Encoded       uint64
+	Dropped       uint64 // due frames not queued because the queue was full
+	Errors        uint64 // encoding or file errors
+	AvgEncodeTime time.Duration
+	MaxEncodeTime time.Duration
+	AvgScaleTime  time.Duration // spent in the frame callback
+}
+
+type videoSnapshotJob struct {
+	snapshot *VideoSnapshot
+	image    *image.YCbCr
+}
+
+type VideoSnapshotService struct {
+	config VideoSnapshotConfig
+	due    sync.Map // channelId/uid -> *int64, unix nano of the next snapshot
+	jobs   chan *videoSnapshotJob
+	wg     sync.WaitGroup
+	closed int32
+	// held for reading while queueing, so that Close never closes jobs under a sender
+	closeMu sync.RWMutex
+
+	images sync.Pool // *image.YCbCr
+
+	captured        uint64
+	encoded         uint64
+	dropped         uint64
+	errors          uint64
+	encodeTimeTotal int64
+	encodeTimeMax   int64
+	scaleTimeTotal  int64
+}
+
+func NewVideoSnapshotService(config *VideoSnapshotConfig) *VideoSnapshotService {
+	cfg := VideoSnapshotConfig{}
+	if config != nil {
+		cfg = *config
+	}
+	if cfg.Interval <= 0 {
+		cfg.Interval = 5 * time.Second
+	}
+	if cfg.MaxWidth <= 0 || cfg.MaxHeight <= 0 {
+		cfg.MaxWidth, cfg.MaxHeight = 320, 180
+	}
+	if cfg.Quality <= 0 || cfg.Quality > 100 {
+		cfg.Quality = 75
+	}
+	if cfg.Workers <= 0 {
+		cfg.Workers = 2
+	}
+	if cfg.QueueSize <= 0 {
+		cfg.QueueSize = 4 * cfg.Workers
+	}
+	s := &VideoSnapshotService{
+		config: cfg,
+		jobs:   make(chan *videoSnapshotJob, cfg.QueueSize),
+	}
+	for i := 0; i < cfg.Workers; i++ {
+		s.wg.Add(1)
+		go s.worker()
+	}
+	return s
+}
+
+// OnFrame has the signature of VideoFrameObserver.OnFrame, it only takes snapshots.
+func (s *VideoSnapshotService) OnFrame(channelId string, userId string, frame *VideoFrame) bool {
+	s.Offer(channelId, userId, frame)
+	return true
+}
+
+// Offer takes a snapshot of frame if the one of the user is due, returns true if one was queued.
+// the frame is only read during the call, so borrowed frames are fine.
+func (s *VideoSnapshotService) Offer(channelId string, userId string, frame *VideoFrame) bool {
+	if atomic.LoadInt32(&s.closed) != 0 || frame == nil || frame.Width <= 0 || frame.Height <= 0 ||
+		len(frame.YBuffer) == 0 || len(frame.UBuffer) == 0 || len(frame.VBuffer) == 0 {
+		return false
+	}
+	key := channelId + "/" + userId
+	v, ok := s.due.Load(key)
+	if !ok {
+		v, _ = s.due.LoadOrStore(key, new(int64))
+	}
+	due := v.(*int64)
+	now := time.Now()
+	next := atomic.LoadInt64(due)
+	if now.UnixNano() < next || !atomic.CompareAndSwapInt64(due, next, now.Add(s.config.Interval).UnixNano()) {
+		return false
+	}
+	// a full queue is checked before the downscale, which is the expensive part here
+	if len(s.jobs) == cap(s.jobs) {
+		atomic.StoreInt64(due, next)
+		atomic.AddUint64(&s.dropped, 1)
+		return false
+	}
+
+	width, height := fitVideoSnapshotSize(frame.Width, frame.Height, s.config.MaxWidth, s.config.MaxHeight)
+	img := s.getImage(width, height)
+	scaleVideoFrameToYCbCr(frame, img)
+	atomic.AddInt64(&s.scaleTimeTotal, int64(time.Since(now)))
+	job := &videoSnapshotJob{
+		snapshot: &VideoSnapshot{
+			ChannelId:    channelId,
+			Uid:          userId,
+			Width:        width,
+			Height:       height,
+			SourceWidth:  frame.Width,
+			SourceHeight: frame.Height,
+			CapturedAt:   now,
+		},
+		image: img,
+	}
+	s.closeMu.RLock()
+	defer s.closeMu.RUnlock()
+	if atomic.LoadInt32(&s.closed) != 0 {
+		return false
+	}
+	select {
+	case s.jobs <- job:
+		atomic.AddUint64(&s.captured, 1)
+		return true
+	default:
+		s.images.Put(img)
+		atomic.StoreInt64(due, next)
+		atomic.AddUint64(&s.dropped, 1)
+		return false
+	}
+}
+
+// Remove forgets the schedule of a user, e.g. in OnUserLeft.
+func (s *VideoSnapshotService) Remove(channelId string, userId string) {
+	s.due.Delete(channelId + "/" + userId)
+}
+
+// Close stops the workers after the queued snapshots are encoded.
+func (s *VideoSnapshotService) Close() {
+	s.closeMu.Lock()
+	if !atomic.CompareAndSwapInt32(&s.closed, 0, 1) {
+		s.closeMu.Unlock()
+		return
+	}
+	close(s.jobs)
+	s.closeMu.Unlock()
+	s.wg.Wait()
+}
+
+func (s *VideoSnapshotService) Stats() VideoSnapshotStats {
+	stats := VideoSnapshotStats{
+		Captured:      atomic.LoadUint64(&s.captured),
+		Encoded:       atomic.LoadUint64(&s.encoded),
+		Dropped:       atomic.LoadUint64(&s.dropped),
+		Errors:        atomic.LoadUint64(&s.errors),
+		MaxEncodeTime: time.Duration(atomic.LoadInt64(&s.encodeTimeMax)),
+	}
+	if stats.Encoded > 0 {
+		stats.AvgEncodeTime = time.Duration(atomic.LoadInt64(&s.encodeTimeTotal) / int64(stats.Encoded))
+	}
+	if stats.Captured > 0 {
+		stats.AvgScaleTime = time.Duration(atomic.LoadInt64(&s.scaleTimeTotal) / int64(stats.Captured))
+	}
+	return stats
+}
+
+func (s *VideoSnapshotService) getImage(width int, height int) *image.YCbCr {
+	if v := s.images.Get(); v != nil {
+		img := v.(*image.YCbCr)
+		if img.Rect.Dx() == width && img.Rect.Dy() == height {
+			return img
+		}
+	}
+	return image.NewYCbCr(image.Rect(0, 0, width, height), image.YCbCrSubsampleRatio420)
+}
+
+func (s *VideoSnapshotService) worker() {
+	defer s.wg.Done()
+	var buf bytes.Buffer
+	for job := range s.jobs {
+		start := time.Now()
+		buf.Reset()
+		err := jpeg.Encode(&buf, job.image, &jpeg.Options{Quality: s.config.Quality})
+		s.images.Put(job.image)
+		if err != nil {
+			atomic.AddUint64(&s.errors, 1)
+			continue
+		}
+		elapsed := time.Since(start)
+		atomic.AddUint64(&s.encoded, 1)
+		atomic.AddInt64(&s.encodeTimeTotal, int64(elapsed))
+		for {
+			prev := atomic.LoadInt64(&s.encodeTimeMax)
+			if int64(elapsed) <= prev || atomic.CompareAndSwapInt64(&s.encodeTimeMax, prev, int64(elapsed)) {
+				break
+			}
+		}
+		snapshot := job.snapshot
+		snapshot.EncodeTime = elapsed
+		snapshot.Jpeg = append([]byte(nil), buf.Bytes()...)
+		if s.config.OutputDir != "" {
+			if err := writeVideoSnapshotFile(s.config.OutputDir, snapshot); err != nil {
+				atomic.AddUint64(&s.errors, 1)
+			}
+		}
+		if s.config.OnSnapshot != nil {
+			s.config.OnSnapshot(snapshot)
+		}
+	}
+}
+
+// writeVideoSnapshotFile replaces the file of the user through a rename, so readers never see a partial jpeg.
+func writeVideoSnapshotFile(dir string, snapshot *VideoSnapshot) error {
+	name := filepath.Join(dir, fmt.Sprintf("%s_%s.jpg", filepath.Base(snapshot.ChannelId), filepath.Base(snapshot.Uid)))
+	tmp := name + ".tmp"
+	if err := os.WriteFile(tmp, snapshot.Jpeg, 0644); err != nil {
+		return err
+	}
+	return os.Rename(tmp, name)
+}
+
+// fitVideoSnapshotSize scales width x height down to fit maxWidth x maxHeight, to even sizes, never up.
+func fitVideoSnapshotSize(width int, height int, maxWidth int, maxHeight int) (int, int) {
+	if width > maxWidth || height > maxHeight {
+		if width*maxHeight > height*maxWidth {
+			height = height * maxWidth / width
+			width = maxWidth
+		} else {
+			width = width * maxHeight / height
+			height = maxHeight
+		}
+	}
+	width, height = width&^1, height&^1
+	if width < 2 {
+		width = 2
+	}
+	if height < 2 {
+		height = 2
+	}
+	return width, height
+}
+
+// scaleVideoFrameToYCbCr downscales the I420 planes of frame into img, averaging 2x2 source pixels around
+// each sample point, which is enough against aliasing for thumbnails.
+func scaleVideoFrameToYCbCr(frame *VideoFrame, img *image.YCbCr) {
+	width, height := img.Rect.Dx(), img.Rect.Dy()
+	scalePlane(frame.YBuffer, frame.YStride, frame.Width, frame.Height, img.Y, img.YStride, width, height)
+	chromaWidth, chromaHeight := (frame.Width+1)/2, (frame.Height+1)/2
+	scalePlane(frame.UBuffer, frame.UStride, chromaWidth, chromaHeight, img.Cb, img.CStride, (width+1)/2, (height+1)/2)
+	scalePlane(frame.VBuffer, frame.VStride, chromaWidth, chromaHeight, img.Cr, img.CStride, (width+1)/2, (height+1)/2)
+}
+
+func scalePlane(src []byte, srcStride int, srcWidth int, srcHeight int, dst []byte, dstStride int, dstWidth int, dstHeight int) {
+	for y := 0; y < dstHeight; y++ {
+		sy := y * srcHeight / dstHeight
+		sy1 := sy + 1
+		if sy1 >= srcHeight {
+			sy1 = sy
+		}
+		row0 := sy * srcStride
+		row1 := sy1 * srcStride
+		if row1+srcWidth > len(src) {
+			// a short plane, e.g. a truncated borrowed buffer
+			return
+		}
+		out := dst[y*dstStride : y*dstStride+dstWidth]
+		for x := range out {
+			sx := x * srcWidth / dstWidth
+			sx1 := sx + 1
+			if sx1 >= srcWidth {
+				sx1 = sx
+			}
+			sum := int(src[row0+sx]) + int(src[row0+sx1]) + int(src[row1+sx]) + int(src[row1+sx1])
+			out[x] = byte((sum + 2) >> 2)
+		}
+	}
+}
@@ -0,0 +1,249 @@
+package agorasdk
+
+import (
+	"context"
+	"fmt"
+	"sync"
+)
+
+// ConnectionState represents the state of an RTC connection, as CONNECTION_STATE_TYPE of the SDK.
+type ConnectionState int32
+
+const (
+	// ConnectionStateDisconnected represents a connection which is not connected to a channel.
+	ConnectionStateDisconnected ConnectionState = 1
+
+	// ConnectionStateConnecting represents a connection which is connecting to a channel.
+	ConnectionStateConnecting ConnectionState = 2
+
+	// ConnectionStateConnected represents a connection which is connected to a channel.
+	ConnectionStateConnected ConnectionState = 3
+
+	// ConnectionStateReconnecting represents a connection which was interrupted and is reconnecting.
+	ConnectionStateReconnecting ConnectionState = 4
+
+	// ConnectionStateFailed represents a connection which failed to connect and gave up.
+	ConnectionStateFailed ConnectionState = 5
+)
+
+// String returns the name of the state.
+func (s ConnectionState) String() string {
+	switch s {
+	case ConnectionStateDisconnected:
+		return "disconnected"
+	case ConnectionStateConnecting:
+		return "connecting"
+	case ConnectionStateConnected:
+		return "connected"
+	case ConnectionStateReconnecting:
+		return "reconnecting"
+	case ConnectionStateFailed:
+		return "failed"
+	}
+	return fmt.Sprintf("unknown(%d)", int32(s))
+}
+
+// RTCConnectionFuture is the result of NewRTCConnectionContext, which is completed when the connection is
+// established, fails to connect or the context is done.
+type RTCConnectionFuture struct {
+	done chan struct{}
+
+	mu        sync.Mutex
+	completed bool
+	// The connection once it's created, it's torn down if the future fails.
+	conn   *RTCConnection
+	result *RTCConnection
+	err    error
+	// Stops the context.AfterFunc which fails the future.
+	stop func() bool
+}
+
+func newRTCConnectionFuture() *RTCConnectionFuture {
+	return &RTCConnectionFuture{done: make(chan struct{})}
+}
+
+// Done returns a channel which is closed when the future is completed.
+func (f *RTCConnectionFuture) Done() <-chan struct{} {
+	return f.done
+}
+
+// Result waits for the future to be completed and returns the connected connection or the error.
+func (f *RTCConnectionFuture) Result() (*RTCConnection, error) {
+	<-f.done
+	return f.result, f.err
+}
+
+// Wait is like Result, but it returns ctx.Err() if ctx is done first. The future is not affected.
+func (f *RTCConnectionFuture) Wait(ctx context.Context) (*RTCConnection, error) {
+	select {
+	case <-f.done:
+		return f.result, f.err
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+// setConn hands the created connection to the future. It returns false if the future already failed,
+// e.g. the context was canceled while the connection was created, and the caller tears it down.
+func (f *RTCConnectionFuture) setConn(conn *RTCConnection, stop func() bool) bool {
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	if f.completed {
+		return false
+	}
+	f.conn = conn
+	f.stop = stop
+	return true
+}
+
+// resolve completes the future with its connection.
+func (f *RTCConnectionFuture) resolve() {
+	f.mu.Lock()
+	if f.completed {
+		f.mu.Unlock()
+		return
+	}
+	f.completed = true
+	f.result = f.conn
+	stop := f.stop
+	f.mu.Unlock()
+
+	if stop != nil {
+		stop()
+	}
+	close(f.done)
+}
+
+// fail completes the future with err and tears down its connection, if any. It may be called on a
+// callback thread of the SDK, where the connection can't be released, so the teardown is asynchronous.
+func (f *RTCConnectionFuture) fail(err error) {
+	f.mu.Lock()
+	if f.completed {
+		f.mu.Unlock()
+		return
+	}
+	f.completed = true
+	f.err = err
+	conn, stop := f.conn, f.stop
+	f.mu.Unlock()
+
+	if stop != nil {
+		stop()
+	}
+	close(f.done)
+	if conn != nil {
+		go conn.teardown()
+	}
+}
+
+// NewRTCConnectionContext creates a connection to the channel of the service like NewRTCConnection, but
+// it returns immediately. The future is completed when the connection is established, when it fails or
+// when ctx is done; a connection which doesn't complete the future is disconnected and released.
+// Once the future is completed, canceling ctx has no effect on the connection.
+func (s *Service) NewRTCConnectionContext(ctx context.Context, opts ...RTCConnectionOption) *RTCConnectionFuture {
+	f := newRTCConnectionFuture()
+	if err := ctx.Err(); err != nil {
+		f.fail(err)
+		return f
+	}
+
+	// The goroutine lives while the connection is created and Connect is called, the wait for the
+	// connection is driven by the connection observer and context.AfterFunc.
+	go func() {
+		conn, err := s.newRTCConnection(opts...)
+		if err != nil {
+			f.fail(err)
+			return
+		}
+
+		conn.pending.Store(f)
+		stop := context.AfterFunc(ctx, func() {
+			f.fail(ctx.Err())
+		})
+		if !f.setConn(conn, stop) {
+			stop()
+			conn.teardown()
+			return
+		}
+
+		token, err := conn.serviceToken()
+		if err != nil {
+			f.fail(err)
+			return
+		}
+		conn.trace(tracePhaseConnect)
+		if ret := conn.rtcConn.Connect(token, s.channelName, s.userID); ret != 0 {
+			f.fail(fmt.Errorf("failed to connect to the channel, return %d", ret))
+		}
+	}()
+
+	return f
+}
+
+// connect connects to the channel and waits for the connection to be established or ctx to be done.
+func (c *RTCConnection) connect(ctx context.Context, token string, channelName string, userID string) error {
+	// The future has no connection to tear down, the caller owns c.
+	f := newRTCConnectionFuture()
+	c.pending.Store(f)
+	defer c.pending.CompareAndSwap(f, nil)
+
+	// Connect to the channel.
+	c.trace(tracePhaseConnect)
+	if ret := c.rtcConn.Connect(token, channelName, userID); ret != 0 {
+		return fmt.Errorf("failed to connect to the channel, return %d", ret)
+	}
+
+	// Wait for the connection to be established.
+	_, err := f.Wait(ctx)
+	return err
+}
+
+// teardown disconnects and releases a connection which was never handed to the caller.
+func (c *RTCConnection) teardown() {
+	c.rtcConn.Disconnect()
+	c.Release()
+}
+
+// State returns the current state of the connection.
+func (c *RTCConnection) State() ConnectionState {
+	return ConnectionState(c.state.Load())
+}
+
+// StateChanges returns a channel which holds the latest state of the connection. The channel has a
+// buffer of one state and a state which isn't read is replaced by the next one, so the callback threads
+// of the SDK never block on a slow reader. The channel is closed once the connection is released.
+func (c *RTCConnection) StateChanges() <-chan ConnectionState {
+	return c.stateCh
+}
+
+// setState records a state reported by the connection observer and completes a pending connect.
+func (c *RTCConnection) setState(state ConnectionState, errCode int) {
+	c.stateMu.Lock()
+	c.state.Store(int32(state))
+	select {
+	case c.stateCh <- state:
+	default:
+		// Replace the state nobody has read yet.
+		select {
+		case <-c.stateCh:
+		default:
+		}
+		c.stateCh <- state
+	}
+	c.stateMu.Unlock()
+
+	f := c.pending.Load()
+	if f == nil {
+		return
+	}
+	switch state {
+	case ConnectionStateConnected:
+		if c.pending.CompareAndSwap(f, nil) {
+			f.resolve()
+		}
+	case ConnectionStateFailed:
+		if c.pending.CompareAndSwap(f, nil) {
+			f.fail(fmt.Errorf("failed to connect to the channel, error code %d", errCode))
+		}
+	}
+}
@@ -0,0 +1,241 @@
+package agorasdk
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+var (
+	// ErrConnectionPoolClosed is the error returned when acquiring from a closed connection pool.
+	ErrConnectionPoolClosed = errors.New("the connection pool is closed")
+)
+
+const (
+	// connectionPoolRetryInterval is the delay before creating connections again after a failure.
+	connectionPoolRetryInterval = time.Second
+)
+
+// ConnectionPool keeps connections which are created, configured and have their observers registered,
+// so that acquiring one only connects it to the target channel. Acquired connections are owned by the
+// caller, who disconnects and releases them as usual, and the pool creates new ones in the background.
+type ConnectionPool struct {
+	svc  *Service
+	opts []RTCConnectionOption
+	size int
+
+	idle      chan *RTCConnection
+	refillCh  chan struct{}
+	done      chan struct{}
+	wg        sync.WaitGroup
+	closeOnce sync.Once
+
+	hits           atomic.Uint64
+	misses         atomic.Uint64
+	created        atomic.Uint64
+	createFailures atomic.Uint64
+
+	warmup              LatencyHistogram
+	acquireToConnected  LatencyHistogram
+	acquireToFirstAudio LatencyHistogram
+}
+
+// ConnectionPoolStats represents the counters and latencies of a connection pool.
+type ConnectionPoolStats struct {
+	// The number of connections ready to be acquired.
+	Idle int
+
+	// Acquisitions served by a pooled connection, and by a connection created on demand.
+	Hits   uint64
+	Misses uint64
+
+	Created        uint64
+	CreateFailures uint64
+
+	// The time to create a connection.
+	Warmup LatencyHistogramSnapshot
+
+	// The time from Acquire to the connection being established.
+	AcquireToConnected LatencyHistogramSnapshot
+
+	// The time from Acquire to the first successful PushAudioPCMData.
+	AcquireToFirstAudio LatencyHistogramSnapshot
+}
+
+// NewConnectionPool creates a pool of size connections configured by opts, as NewRTCConnection would.
+// The connections are created before it returns, and an error is returned if the first one fails.
+func (s *Service) NewConnectionPool(size int, opts ...RTCConnectionOption) (*ConnectionPool, error) {
+	if size <= 0 {
+		return nil, fmt.Errorf("invalid connection pool size, %d", size)
+	}
+
+	p := &ConnectionPool{
+		svc:      s,
+		opts:     opts,
+		size:     size,
+		idle:     make(chan *RTCConnection, size),
+		refillCh: make(chan struct{}, 1),
+		done:     make(chan struct{}),
+	}
+
+	if err := p.fill(); err != nil && len(p.idle) == 0 {
+		return nil, err
+	}
+
+	p.wg.Add(1)
+	go p.refillLoop()
+
+	return p, nil
+}
+
+// Acquire takes a pooled connection, or creates one if the pool is empty, and connects it to the channel
+// as userID. If token is empty, a token is built by the token manager of the service and
+// renewed until the connection is released.
+// The connection is released if it fails to connect or ctx is done first.
+func (p *ConnectionPool) Acquire(ctx context.Context, channelName string, userID string, token string) (*RTCConnection, error) {
+	start := time.Now()
+
+	select {
+	case <-p.done:
+		return nil, ErrConnectionPoolClosed
+	default:
+	}
+
+	if channelName == "" {
+		return nil, ErrEmptyChannelName
+	}
+
+	if userID == "" {
+		return nil, ErrEmptyUserID
+	}
+
+	var conn *RTCConnection
+	select {
+	case conn = <-p.idle:
+		p.hits.Add(1)
+	default:
+		p.misses.Add(1)
+		var err error
+		if conn, err = p.svc.newRTCConnection(p.opts...); err != nil {
+			return nil, err
+		}
+	}
+	p.refill()
+
+	conn.pool = p
+	conn.acquiredAt = start.UnixNano()
+
+	if token == "" {
+		var err error
+		if token, err = p.svc.tokens.track(conn, channelName, userID); err != nil {
+			conn.teardown()
+			return nil, fmt.Errorf("failed to generate token, %w", err)
+		}
+	}
+
+	if err := conn.connect(ctx, token, channelName, userID); err != nil {
+		conn.teardown()
+		return nil, err
+	}
+	p.acquireToConnected.Record(time.Since(start))
+
+	return conn, nil
+}
+
+// Stats returns the counters and latency histograms of the pool.
+func (p *ConnectionPool) Stats() ConnectionPoolStats {
+	return ConnectionPoolStats{
+		Idle:                len(p.idle),
+		Hits:                p.hits.Load(),
+		Misses:              p.misses.Load(),
+		Created:             p.created.Load(),
+		CreateFailures:      p.createFailures.Load(),
+		Warmup:              p.warmup.Snapshot(),
+		AcquireToConnected:  p.acquireToConnected.Snapshot(),
+		AcquireToFirstAudio: p.acquireToFirstAudio.Snapshot(),
+	}
+}
+
+// Close stops creating connections and releases the idle ones. Acquired connections are not affected.
+func (p *ConnectionPool) Close() {
+	p.closeOnce.Do(func() {
+		close(p.done)
+		p.wg.Wait()
+
+		// Release the idle connections in parallel, on the release goroutines of the service.
+		var released []<-chan struct{}
+	drain:
+		for {
+			select {
+			case conn := <-p.idle:
+				released = append(released, conn.ReleaseAsync())
+			default:
+				break drain
+			}
+		}
+		for _, done := range released {
+			<-done
+		}
+	})
+}
+
+// refill wakes up the refill loop.
+func (p *ConnectionPool) refill() {
+	select {
+	case p.refillCh <- struct{}{}:
+	default:
+	}
+}
+
+func (p *ConnectionPool) refillLoop() {
+	defer p.wg.Done()
+
+	var retry <-chan time.Time
+	for {
+		select {
+		case <-p.done:
+			return
+		case <-p.refillCh:
+		case <-retry:
+		}
+
+		retry = nil
+		// The failure is counted in CreateFailures.
+		if err := p.fill(); err != nil {
+			retry = time.After(connectionPoolRetryInterval)
+		}
+	}
+}
+
+// fill creates connections until the pool is full or closed.
+func (p *ConnectionPool) fill() error {
+	for len(p.idle) < p.size {
+		start := time.Now()
+		conn, err := p.svc.newRTCConnection(p.opts...)
+		if err != nil {
+			p.createFailures.Add(1)
+			return err
+		}
+		p.created.Add(1)
+		p.warmup.Record(time.Since(start))
+
+		select {
+		case <-p.done:
+			conn.Release()
+			return nil
+		default:
+		}
+
+		select {
+		case p.idle <- conn:
+		default:
+			// Only the refill loop and NewConnectionPool fill the pool, but keep the bound anyway.
+			conn.Release()
+			return nil
+		}
+	}
+	return nil
+}
@@ -0,0 +1,47 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"log"
+	"os"
+
+	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
+)
+
+const exampleName = "callback_bench"
+
+func main() {
+	var (
+		threads = flag.Int("threads", 8, "Number of C threads calling into Go, like the callback threads of the SDK")
+		calls   = flag.Int("calls", 100000, "Number of calls per thread")
+		users   = flag.Int("users", 40, "Number of remote users, only used to estimate the callback cost")
+		rate    = flag.Int("rate", 100, "Callbacks per second of each remote user, only used to estimate the callback cost")
+	)
+
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: %s [options]\n\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+	}
+
+	flag.Parse()
+
+	results, err := agoraservice.BenchCallbackCost(*threads, *calls)
+	if err != nil {
+		logFatalf("Failed to run the benchmark, %v", err)
+	}
+	callsPerSecond := float64(*users) * float64(*rate)
+	for _, r := range results {
+		cpu := r.CpuNsPerCall * callsPerSecond / 1e9 * 100
+		logf("%s\n  %d users x %d callbacks/s: %.3f%% of one core", r, *users, *rate, cpu)
+	}
+}
+
+func logf(format string, args ...any) {
+	log.Printf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
+
+func logFatalf(format string, args ...any) {
+	log.Fatalf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
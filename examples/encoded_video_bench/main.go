@@ -0,0 +1,139 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"log"
+	"os"
+	"path/filepath"
+	"sync/atomic"
+	"syscall"
+	"time"
+
+	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
+)
+
+const exampleName = "encoded_video_bench"
+
+func main() {
+	var (
+		filePath = flag.String("file", "", "Annex-B elementary stream to play (default: a synthetic stream)")
+		codec    = flag.String("codec", "h264", "Codec of the file: h264 or h265")
+		fps      = flag.Int("fps", 15, "Frame rate of the file")
+		streams  = flag.Int("streams", 1000, "Number of streams playing the file concurrently")
+		duration = flag.Duration("duration", 10*time.Second, "Benchmark duration")
+	)
+
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: %s [options]\n\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+	}
+
+	flag.Parse()
+
+	codecType := agoraservice.VideoCodecTypeH264
+	if *codec == "h265" {
+		codecType = agoraservice.VideoCodecTypeH265
+	}
+	if *filePath == "" {
+		path, err := writeSyntheticStream(*fps)
+		if err != nil {
+			logFatalf("Failed to write the synthetic stream: %v", err)
+		}
+		defer os.Remove(path)
+		*filePath = path
+		codecType = agoraservice.VideoCodecTypeH264
+	}
+
+	file, err := agoraservice.OpenEncodedVideoFile(*filePath, codecType)
+	if err != nil {
+		logFatalf("Failed to open %s: %v", *filePath, err)
+	}
+	defer file.Close()
+	keyFrames := 0
+	for _, au := range file.AccessUnits() {
+		if au.FrameType == agoraservice.VideoFrameTypeKeyFrame {
+			keyFrames++
+		}
+	}
+	logf("%s: %d access units, %d key frames", *filePath, len(file.AccessUnits()), keyFrames)
+
+	// the send only reads the frame, so the numbers are the cost of the source itself, without the sdk
+	var checksum uint64
+	send := func(data []byte, frameInfo *agoraservice.EncodedVideoFrameInfo) int {
+		atomic.AddUint64(&checksum, uint64(data[len(data)-1]))
+		return 0
+	}
+
+	sources := make([]*agoraservice.EncodedVideoFileSource, *streams)
+	for i := range sources {
+		sources[i] = agoraservice.NewEncodedVideoFileSource(file, &agoraservice.EncodedVideoFileSourceConfig{Fps: *fps, Loop: true})
+	}
+	startCPU := cpuTime()
+	start := time.Now()
+	for _, source := range sources {
+		source.Start(send)
+	}
+	time.Sleep(*duration)
+	for _, source := range sources {
+		source.Stop()
+	}
+	elapsed := time.Since(start)
+	cpu := cpuTime() - startCPU
+
+	var total agoraservice.EncodedVideoFileSourceStats
+	for _, source := range sources {
+		stats := source.Stats()
+		total.Frames += stats.Frames
+		total.Bytes += stats.Bytes
+		total.Late += stats.Late
+		total.Loops += stats.Loops
+	}
+	perStream := cpu.Seconds() / elapsed.Seconds() / float64(*streams) * 100
+	logf("%d streams x %d fps for %v: %d frames(%d late, %d loops), %.1f MB/s, cpu %.2f%% of one core in total, %.4f%% per stream, %.0f ns per frame",
+		*streams, *fps, elapsed.Round(time.Millisecond), total.Frames, total.Late, total.Loops,
+		float64(total.Bytes)/elapsed.Seconds()/(1<<20), cpu.Seconds()/elapsed.Seconds()*100, perStream,
+		float64(cpu.Nanoseconds())/float64(total.Frames))
+}
+
+// cpuTime returns the user+system cpu time of the process.
+func cpuTime() time.Duration {
+	var usage syscall.Rusage
+	if err := syscall.Getrusage(syscall.RUSAGE_SELF, &usage); err != nil {
+		return 0
+	}
+	return time.Duration(usage.Utime.Nano() + usage.Stime.Nano())
+}
+
+// writeSyntheticStream writes 10 seconds of a fake H.264 stream, a key frame every 2 seconds and
+// about 500kbps, which is enough to exercise the parser and the pacing.
+func writeSyntheticStream(fps int) (string, error) {
+	sps := []byte{0, 0, 0, 1, 0x67, 0x42, 0xc0, 0x1e}
+	pps := []byte{0, 0, 0, 1, 0x68, 0xce, 0x3c, 0x80}
+	frameBytes := 500000 / 8 / fps
+	var stream []byte
+	for i := 0; i < 10*fps; i++ {
+		nalHeader := byte(0x41)
+		if i%(2*fps) == 0 {
+			stream = append(stream, sps...)
+			stream = append(stream, pps...)
+			nalHeader = 0x65
+		}
+		// first_mb_in_slice = 0, then a payload without start code emulation
+		stream = append(stream, 0, 0, 0, 1, nalHeader, 0x88)
+		for j := 0; j < frameBytes; j++ {
+			stream = append(stream, byte(j%200+1))
+		}
+	}
+	path := filepath.Join(os.TempDir(), fmt.Sprintf("%s_%d.h264", exampleName, os.Getpid()))
+	return path, os.WriteFile(path, stream, 0644)
+}
+
+func logf(format string, args ...any) {
+	log.Printf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
+
+func logFatalf(format string, args ...any) {
+	log.Fatalf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
@@ -0,0 +1,215 @@
+package main
+
+import (
+	"context"
+	"flag"
+	"fmt"
+	"log"
+	"os"
+	"os/signal"
+	"sync"
+	"syscall"
+	"time"
+
+	agorasdk "github.com/zyy17/agora-server-sdk"
+	"github.com/zyy17/agora-server-sdk/shard"
+)
+
+const (
+	exampleName                = "shard_supervisor"
+	defaultChannelPrefix       = "agora_sdk_example"
+	defaultAgoraBaseDir        = "./agora_example"
+	defaultUserID              = "0"
+	defaultSampleRate          = 16000
+	defaultAudioChannelType    = agorasdk.AudioChannelTypeMono
+	defaultAudioFile           = "./examples/testdata/send_audio_16k_1ch.pcm"
+	defaultAudioBytesPerSample = 2
+	defaultPushInterval        = time.Second
+	defaultStatsInterval       = 10 * time.Second
+)
+
+var (
+	appID      = flag.String("app-id", "", "The required Agora App ID (default: uses AGORA_APP_ID env if empty)")
+	appCert    = flag.String("app-cert", "", "The required Agora App Certificate (default: uses AGORA_APP_CERT env if empty)")
+	channels   = flag.Int("channels", 8, "Number of channels to join, named <channel-prefix>_<n>")
+	prefix     = flag.String("channel-prefix", defaultChannelPrefix, "Prefix of the channel names")
+	userID     = flag.String("user-id", defaultUserID, "User ID for the connections (string identifier)")
+	workers    = flag.Int("workers", 0, "Number of worker processes (default: one per 8 CPUs)")
+	poolSize   = flag.Int("pool-size", 2, "Number of pre-warmed connections in each worker")
+	baseDir    = flag.String("base-dir", defaultAgoraBaseDir, "Directory of the SDK logs, configuration and data, one sub directory per worker")
+	audioFile  = flag.String("audio-file-path", defaultAudioFile, "Path to the audio file")
+	sampleRate = flag.Int("sample-rate", defaultSampleRate, "Sample rate of the audio file")
+)
+
+func main() {
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: %s [options]\n\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+	}
+
+	// The workers are started with the same arguments.
+	flag.Parse()
+
+	if shard.IsWorker() {
+		if err := shard.RunWorker(newConnectionHandler); err != nil {
+			logFatalf("worker failed: %v", err)
+		}
+		return
+	}
+
+	sup, err := shard.NewSupervisor(
+		shard.WithWorkers(*workers),
+		shard.WithOnChannelMoved(func(channel string, from int, to int) {
+			logf("Channel %s moved from worker %d to worker %d", channel, from, to)
+		}),
+		shard.WithOnError(func(err error) {
+			logf("Supervisor error: %v", err)
+		}),
+	)
+	if err != nil {
+		logFatalf("failed to start the workers: %v", err)
+	}
+	defer sup.Close()
+
+	names := make([]string, *channels)
+	for i := range names {
+		names[i] = fmt.Sprintf("%s_%d", *prefix, i)
+		worker, err := sup.Join(names[i], *userID, "")
+		if err != nil {
+			logFatalf("failed to join %s: %v", names[i], err)
+		}
+		logf("Joined %s on worker %d", names[i], worker)
+	}
+
+	pcm, err := os.ReadFile(*audioFile)
+	if err != nil {
+		logFatalf("failed to read %s: %v", *audioFile, err)
+	}
+
+	sigCh := make(chan os.Signal, 1)
+	signal.Notify(sigCh, os.Interrupt, syscall.SIGTERM)
+
+	// Push one second of audio to every channel per interval, the same audio to all of them.
+	chunkSize := *sampleRate * defaultAudioBytesPerSample
+	offset := 0
+	pushTicker := time.NewTicker(defaultPushInterval)
+	defer pushTicker.Stop()
+	statsTicker := time.NewTicker(defaultStatsInterval)
+	defer statsTicker.Stop()
+	for {
+		select {
+		case <-sigCh:
+			logf("Received termination signal, exiting application...")
+			return
+		case <-pushTicker.C:
+			if offset+chunkSize > len(pcm) {
+				offset = 0
+			}
+			for _, name := range names {
+				if err := sup.PushPCM(name, pcm[offset:offset+chunkSize]); err != nil {
+					logf("failed to push audio to %s: %v", name, err)
+				}
+			}
+			offset += chunkSize
+		case <-statsTicker.C:
+			for _, w := range sup.Stats().Workers {
+				logf("Worker %d: pid %d, alive %v, %d channels, %d restarts, %d dropped", w.Index, w.Pid, w.Alive,
+					w.Channels, w.Restarts, w.DroppedIn)
+			}
+		}
+	}
+}
+
+// connectionHandler runs in a worker process, with its own SDK instance and a pool of connections.
+type connectionHandler struct {
+	pool *agorasdk.ConnectionPool
+
+	mu    sync.Mutex
+	conns map[string]*agorasdk.RTCConnection
+}
+
+func newConnectionHandler(w *shard.Worker) shard.WorkerHandler {
+	dir := fmt.Sprintf("%s/worker_%d", *baseDir, w.Index())
+	// The service needs a channel, the connections of the pool connect to the channels of the supervisor.
+	svc, err := agorasdk.NewService(
+		agorasdk.WithAppID(*appID),
+		agorasdk.WithAppCert(*appCert),
+		agorasdk.WithChannelName(*prefix),
+		agorasdk.WithUserID(*userID),
+		agorasdk.WithLogPath(dir+"/logs/agorasdk.log"),
+		agorasdk.WithConfigDir(dir+"/config"),
+		agorasdk.WithDataDir(dir+"/data"),
+	)
+	if err != nil {
+		logFatalf("worker %d failed to create service: %v", w.Index(), err)
+	}
+
+	pool, err := svc.NewConnectionPool(*poolSize,
+		agorasdk.WithSampleRate(*sampleRate),
+		agorasdk.WithAudioChannelType(defaultAudioChannelType),
+	)
+	if err != nil {
+		logFatalf("worker %d failed to create connection pool: %v", w.Index(), err)
+	}
+
+	return &connectionHandler{
+		pool:  pool,
+		conns: make(map[string]*agorasdk.RTCConnection),
+	}
+}
+
+func (h *connectionHandler) OnJoin(channel string, userID string, token string) error {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	conn, err := h.pool.Acquire(ctx, channel, userID, token)
+	if err != nil {
+		return err
+	}
+	if err := conn.PublishAudio(); err != nil {
+		conn.Release()
+		return err
+	}
+
+	h.mu.Lock()
+	h.conns[channel] = conn
+	h.mu.Unlock()
+	return nil
+}
+
+func (h *connectionHandler) OnLeave(channel string) {
+	h.mu.Lock()
+	conn := h.conns[channel]
+	delete(h.conns, channel)
+	h.mu.Unlock()
+
+	if conn != nil {
+		conn.Disconnect()
+		conn.Release()
+	}
+}
+
+func (h *connectionHandler) OnPCM(channel string, data []byte) {
+	h.mu.Lock()
+	conn := h.conns[channel]
+	h.mu.Unlock()
+
+	if conn != nil {
+		if err := conn.PushAudioPCMData(data, 0); err != nil {
+			logf("failed to push audio PCM data to %s: %v", channel, err)
+		}
+	}
+}
+
+func (h *connectionHandler) OnError(err error) {
+	logf("Worker error: %v", err)
+}
+
+func logf(format string, args ...any) {
+	log.Printf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
+
+func logFatalf(format string, args ...any) {
+	log.Fatalf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
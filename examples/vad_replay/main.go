@@ -0,0 +1,124 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"log"
+	"os"
+
+	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
+)
+
+const (
+	exampleName       = "vad_replay"
+	defaultSampleRate = 16000
+	defaultChannels   = 1
+)
+
+func main() {
+	var (
+		dumpDir    = flag.String("dump-dir", "", "The required VadDump directory that contains source.pcm and label.bin")
+		sampleRate = flag.Int("sample-rate", defaultSampleRate, "Sample rate of source.pcm")
+		channels   = flag.Int("channels", defaultChannels, "Number of channels of source.pcm")
+		vadType    = flag.String("vad", "v2", "Which vad to replay: v2, v1 or all")
+		iterations = flag.Int("iterations", 1, "Number of replay rounds, the report of each round is printed")
+
+		preStartCount   = flag.Int("pre-start-count", 16, "AudioVadConfigV2.PreStartRecognizeCount")
+		startCount      = flag.Int("start-count", 30, "AudioVadConfigV2.StartRecognizeCount")
+		stopCount       = flag.Int("stop-count", 65, "AudioVadConfigV2.StopRecognizeCount")
+		startRms        = flag.Int("start-rms", -70, "AudioVadConfigV2.StartRms in db")
+		stopRms         = flag.Int("stop-rms", -70, "AudioVadConfigV2.StopRms in db")
+		adaptiveRms     = flag.Bool("adaptive-rms", true, "AudioVadConfigV2.EnableAdaptiveRmsThreshold")
+		adaptiveFactor  = flag.Float64("adaptive-factor", 0.67, "AudioVadConfigV2.AdaptiveRmsThresholdFactor")
+		lookahead       = flag.Int("lookahead", 0, "AudioVadConfigV2.StreamingLookaheadCount, 0 disables the streaming mode")
+		printTransition = flag.Bool("print-transitions", false, "Print the frame index of every replayed start and stop decision")
+		segment         = flag.Int("segment", -1, "Only replay this vad segment of a compact dump(dump.vdc), -1 replays the whole dump")
+		preFrames       = flag.Int("pre-frames", 100, "Frames to load before the start of -segment")
+	)
+
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: %s [options]\n\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+	}
+
+	flag.Parse()
+
+	if *dumpDir == "" {
+		flag.Usage()
+		os.Exit(1)
+	}
+
+	var frames []*agoraservice.VadReplayFrame
+	var err error
+	if *segment >= 0 {
+		frames, err = loadSegment(*dumpDir, *segment, *preFrames)
+	} else {
+		frames, err = agoraservice.LoadVadDump(*dumpDir, *sampleRate, *channels)
+	}
+	if err != nil {
+		logFatalf("Failed to load vad dump: %v", err)
+	}
+	logf("Loaded %d frames (%.1fs of audio) from %s", len(frames), float64(len(frames))/100, *dumpDir)
+
+	cfg := &agoraservice.AudioVadConfigV2{
+		PreStartRecognizeCount:     *preStartCount,
+		StartRecognizeCount:        *startCount,
+		StopRecognizeCount:         *stopCount,
+		ActivePercent:              0.7,
+		InactivePercent:            0.5,
+		StartVoiceProb:             70,
+		StartRms:                   *startRms,
+		StopVoiceProb:              70,
+		StopRms:                    *stopRms,
+		EnableAdaptiveRmsThreshold: *adaptiveRms,
+		AdaptiveRmsThresholdFactor: float32(*adaptiveFactor),
+		StreamingLookaheadCount:    *lookahead,
+	}
+
+	for i := 0; i < *iterations; i++ {
+		if *vadType == "v2" || *vadType == "all" {
+			stats := agoraservice.ReplayVadV2(frames, cfg)
+			report(i, stats, *printTransition)
+		}
+		if *vadType == "v1" || *vadType == "all" {
+			stats, err := agoraservice.ReplayVad(frames, nil)
+			if err != nil {
+				logFatalf("Failed to replay AudioVad: %v", err)
+			}
+			report(i, stats, *printTransition)
+		}
+	}
+}
+
+func loadSegment(dir string, segment int, preFrames int) ([]*agoraservice.VadReplayFrame, error) {
+	c, err := agoraservice.OpenVadDumpContainer(dir + "/dump.vdc")
+	if err != nil {
+		return nil, err
+	}
+	defer c.Close()
+	logf("%s has %d frames and %d vad segments", dir, c.Frames(), len(c.Segments()))
+	return c.ReadSegment(segment, preFrames)
+}
+
+func report(round int, stats *agoraservice.VadReplayStats, printTransition bool) {
+	logf("round %d\n%s", round, stats)
+	if !printTransition {
+		return
+	}
+	for i, state := range stats.States {
+		if state == agoraservice.VadStateStartSpeeking || state == agoraservice.VadStateStopSpeeking ||
+			state == agoraservice.VadStateRetractSpeaking ||
+			(state == agoraservice.VadStateMaybeSpeaking && (i == 0 || stats.States[i-1] != agoraservice.VadStateMaybeSpeaking)) {
+			logf("  frame %d (%dms): state %d", i, i*10, state)
+		}
+	}
+}
+
+func logf(format string, args ...any) {
+	log.Printf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
+
+func logFatalf(format string, args ...any) {
+	log.Fatalf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
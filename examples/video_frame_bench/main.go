@@ -0,0 +1,49 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"log"
+	"os"
+
+	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
+)
+
+const exampleName = "video_frame_bench"
+
+func main() {
+	var (
+		width  = flag.Int("width", 1280, "Width of the synthetic I420 frame")
+		height = flag.Int("height", 720, "Height of the synthetic I420 frame")
+		frames = flag.Int("frames", 2000, "Number of frames converted per mode")
+		users  = flag.Int("users", 40, "Number of remote users, only used to estimate the copy bandwidth")
+		fps    = flag.Int("fps", 15, "Frame rate of each remote user, only used to estimate the copy bandwidth")
+	)
+
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: %s [options]\n\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+	}
+
+	flag.Parse()
+
+	results := agoraservice.BenchVideoFrameCopy(*width, *height, *frames)
+	if results == nil {
+		logFatalf("Invalid options, width: %d, height: %d, frames: %d", *width, *height, *frames)
+	}
+	framesPerSecond := float64(*users) * float64(*fps)
+	for _, r := range results {
+		mbps := r.BytesCopiedPerFrame * framesPerSecond / (1 << 20)
+		cpu := r.NsPerFrame * framesPerSecond / 1e9 * 100
+		logf("%s\n  %d users x %d fps: %.1f MB/s copied, %.2f%% of one core", r, *users, *fps, mbps, cpu)
+	}
+}
+
+func logf(format string, args ...any) {
+	log.Printf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
+
+func logFatalf(format string, args ...any) {
+	log.Fatalf("[%s] %s", exampleName, fmt.Sprintf(format, args...))
+}
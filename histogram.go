@@ -0,0 +1,13 @@
+package agorasdk
+
+import (
+	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
+)
+
+// LatencyHistogram records durations in log-linear buckets of nanoseconds. It's safe for concurrent use
+// and Record doesn't allocate. It's the histogram of the SDK wrapper metrics, see agoraservice.Histogram.
+type LatencyHistogram = agoraservice.Histogram
+
+// LatencyHistogramSnapshot represents the state of a LatencyHistogram at a point in time: the count,
+// mean, max and the 50th, 90th and 99th percentiles.
+type LatencyHistogramSnapshot = agoraservice.HistogramSnapshot
@@ -0,0 +1,225 @@
+package agorasdk
+
+import (
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	// DefaultReleaseConcurrency is the default number of connections the service releases in parallel.
+	DefaultReleaseConcurrency = 8
+
+	// callbackGateClosed is the bit of RTCConnection.callbacks set once the release started, the other
+	// bits count the callbacks in flight.
+	callbackGateClosed = 1 << 30
+)
+
+// ReleaseStats represents the counters and latencies of the connection releases of a service.
+type ReleaseStats struct {
+	// The number of connections waiting to be released or being released.
+	Pending int
+
+	Released uint64
+
+	// The time from ReleaseAsync to the start of the release.
+	QueueWait LatencyHistogramSnapshot
+
+	// The time to release a connection, by Release or ReleaseAsync.
+	Release LatencyHistogramSnapshot
+}
+
+// releaseJob is a connection queued by ReleaseAsync.
+type releaseJob struct {
+	conn     *RTCConnection
+	queuedAt time.Time
+}
+
+// releaseExecutor releases connections on a bounded number of goroutines, which are started on demand
+// and exit when the queue is empty.
+type releaseExecutor struct {
+	concurrency int
+
+	mu      sync.Mutex
+	queue   []releaseJob
+	running int
+	// The connections whose release waits for their callbacks in flight, see hold.
+	held int
+	// Signaled when the queue is empty and no goroutine is running.
+	idle *sync.Cond
+
+	released  atomic.Uint64
+	queueWait LatencyHistogram
+	release   LatencyHistogram
+}
+
+func newReleaseExecutor(concurrency int) *releaseExecutor {
+	if concurrency <= 0 {
+		concurrency = DefaultReleaseConcurrency
+	}
+	e := &releaseExecutor{concurrency: concurrency}
+	e.idle = sync.NewCond(&e.mu)
+	return e
+}
+
+// hold counts a connection which is going to be released, so that wait waits for it. It's followed by
+// unhold or submitHeld.
+func (e *releaseExecutor) hold() {
+	e.mu.Lock()
+	e.held++
+	e.mu.Unlock()
+}
+
+func (e *releaseExecutor) unhold() {
+	e.mu.Lock()
+	e.held--
+	if e.held == 0 && len(e.queue) == 0 && e.running == 0 {
+		e.idle.Broadcast()
+	}
+	e.mu.Unlock()
+}
+
+// submitHeld queues a held conn and starts a goroutine if fewer than the concurrency are running.
+func (e *releaseExecutor) submitHeld(conn *RTCConnection) {
+	e.mu.Lock()
+	e.held--
+	e.queue = append(e.queue, releaseJob{conn: conn, queuedAt: time.Now()})
+	start := e.running < e.concurrency
+	if start {
+		e.running++
+	}
+	e.mu.Unlock()
+
+	if start {
+		go e.run()
+	}
+}
+
+func (e *releaseExecutor) run() {
+	for {
+		e.mu.Lock()
+		if len(e.queue) == 0 {
+			e.running--
+			if e.running == 0 && e.held == 0 {
+				e.idle.Broadcast()
+			}
+			e.mu.Unlock()
+			return
+		}
+		job := e.queue[0]
+		e.queue[0] = releaseJob{}
+		e.queue = e.queue[1:]
+		e.mu.Unlock()
+
+		e.queueWait.Record(time.Since(job.queuedAt))
+		job.conn.releaseOnce.Do(job.conn.release)
+	}
+}
+
+// record records a release, done by the executor or by RTCConnection.Release.
+func (e *releaseExecutor) record(d time.Duration) {
+	e.released.Add(1)
+	e.release.Record(d)
+}
+
+// wait blocks until all the queued and held connections are released.
+func (e *releaseExecutor) wait() {
+	e.mu.Lock()
+	for len(e.queue) > 0 || e.running > 0 || e.held > 0 {
+		e.idle.Wait()
+	}
+	e.mu.Unlock()
+}
+
+func (e *releaseExecutor) stats() ReleaseStats {
+	e.mu.Lock()
+	pending := len(e.queue) + e.running + e.held
+	e.mu.Unlock()
+
+	return ReleaseStats{
+		Pending:   pending,
+		Released:  e.released.Load(),
+		QueueWait: e.queueWait.Snapshot(),
+		Release:   e.release.Snapshot(),
+	}
+}
+
+// ReleaseAsync queues the connection to be released by the service, at most WithReleaseConcurrency at
+// a time, and returns a channel which is closed once it's released. If callbacks of the connection are
+// in flight, it's queued when the last of them returns. Calling it again, or after Release, returns the
+// same channel.
+func (c *RTCConnection) ReleaseAsync() <-chan struct{} {
+	if c.closeCallbackGate() {
+		c.svc.releaser.submitHeld(c)
+	}
+	return c.releaseDone
+}
+
+// ReleaseStats returns the counters and latency histograms of the connection releases.
+func (s *Service) ReleaseStats() ReleaseStats {
+	return s.releaser.stats()
+}
+
+// release releases the underlying connection, it runs once, after the callback gate is closed and the
+// callbacks in flight returned.
+func (c *RTCConnection) release() {
+	start := time.Now()
+	c.svc.tokens.untrack(c)
+	c.rtcConn.Release()
+	c.svc.releaser.record(time.Since(start))
+
+	// The callbacks are done, so nothing sends to the state channel anymore.
+	c.stateMu.Lock()
+	close(c.stateCh)
+	c.stateMu.Unlock()
+	close(c.releaseDone)
+}
+
+// closeCallbackGate makes the later callbacks return early. The first call holds the connection in the
+// release executor and returns true if no callback is in flight, the caller then releases it. Otherwise
+// the last callback in flight queues it, see exitCallback.
+func (c *RTCConnection) closeCallbackGate() bool {
+	if !c.releasing.CompareAndSwap(false, true) {
+		return false
+	}
+	c.svc.releaser.hold()
+	inFlight := c.callbacks.Add(callbackGateClosed) &^ callbackGateClosed
+	return inFlight == 0 && c.drained.CompareAndSwap(false, true)
+}
+
+// enterCallback is called by the observers before touching the connection or the user callbacks, it
+// returns false once the connection is being released. exitCallback must be called if it returns true.
+func (c *RTCConnection) enterCallback() bool {
+	if c.callbacks.Add(1)&callbackGateClosed != 0 {
+		c.exitCallback()
+		return false
+	}
+	return true
+}
+
+// exitCallback ends a callback, the last one in flight of a connection being released hands the
+// release to the service.
+func (c *RTCConnection) exitCallback() {
+	if c.callbacks.Add(-1) == callbackGateClosed && c.drained.CompareAndSwap(false, true) {
+		c.svc.releaser.submitHeld(c)
+	}
+}
+
+// guardCallback runs f behind the callback gate, every observer of the connection goes through it.
+func (c *RTCConnection) guardCallback(f func()) {
+	if !c.enterCallback() {
+		return
+	}
+	defer c.exitCallback()
+	f()
+}
+
+// guardCallbackResult is guardCallback for the observers returning a value, fallback is returned once
+// the connection is being released.
+func guardCallbackResult[T any](c *RTCConnection, fallback T, f func() T) T {
+	if !c.enterCallback() {
+		return fallback
+	}
+	defer c.exitCallback()
+	return f()
+}
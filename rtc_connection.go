@@ -1,8 +1,12 @@
 package agorasdk
 
 import (
+	"context"
 	"errors"
 	"fmt"
+	"sync"
+	"sync/atomic"
+	"time"
 
 	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
 )
@@ -46,6 +50,34 @@ type RTCConnection struct {
 
 	// The underlying RTC connection.
 	rtcConn *agoraservice.RtcConnection
+
+	// The service releasing the connection, see ReleaseAsync.
+	svc *Service
+	// The role of the tokens built for the connection.
+	tokenRole TokenRole
+	// The steps of the join and publish, nil if the tracing of the service is disabled.
+	tracing *connectionTrace
+	// The callback gate, the callbacks in flight and whether the release started, see closeCallbackGate.
+	callbacks   atomic.Int32
+	releasing   atomic.Bool
+	drained     atomic.Bool
+	releaseOnce sync.Once
+	releaseDone chan struct{}
+
+	// The state reported by the connection observer, see StateChanges.
+	state   atomic.Int32
+	stateMu sync.Mutex
+	stateCh chan ConnectionState
+
+	// The connect waiting for the connection to be established, if any.
+	pending atomic.Pointer[RTCConnectionFuture]
+
+	// The pool the connection was acquired from, nil if it was created by NewRTCConnection.
+	pool *ConnectionPool
+	// When the connection was acquired from the pool, in unix nanoseconds.
+	acquiredAt int64
+	// Set by the first successful PushAudioPCMData of an acquired connection.
+	firstAudio atomic.Bool
 }
 
 // RTCConnectionConfig represents the configuration for an Agora RTC connection.
@@ -333,8 +365,34 @@ func WithOnIntraRequestReceived(onIntraRequestReceived OnIntraRequestReceived) R
 	}
 }
 
-// NewRTCConnection creates a new Agora RTC connection instance.
+// NewRTCConnection creates a new Agora RTC connection instance and connects it to the channel of the service.
 func (s *Service) NewRTCConnection(opts ...RTCConnectionOption) (*RTCConnection, error) {
+	conn, err := s.newRTCConnection(opts...)
+	if err != nil {
+		return nil, err
+	}
+
+	token, err := conn.serviceToken()
+	if err != nil {
+		conn.teardown()
+		return nil, err
+	}
+
+	if err := conn.connect(context.Background(), token, s.channelName, s.userID); err != nil {
+		conn.teardown()
+		return nil, err
+	}
+
+	return conn, nil
+}
+
+// newRTCConnection creates a connection with its local user, tracks and observers, ready to connect.
+func (s *Service) newRTCConnection(opts ...RTCConnectionOption) (*RTCConnection, error) {
+	var tracing *connectionTrace
+	if s.tracer != nil {
+		tracing = s.tracer.newTrace()
+	}
+
 	cfg := &RTCConnectionConfig{
 		connCfg: &agoraservice.RtcConnectionConfig{
 			AutoSubscribeAudio: true,
@@ -357,6 +415,11 @@ func (s *Service) NewRTCConnection(opts ...RTCConnectionOption) (*RTCConnection,
 		audioMode:               cfg.audioMode,
 		enableReceiveAudioFrame: cfg.enableReceiveAudioFrame,
 		rtcConn:                 rtcConn,
+		svc:                     s,
+		tokenRole:               tokenRoleOf(cfg.connCfg.ClientRole),
+		tracing:                 tracing,
+		releaseDone:             make(chan struct{}),
+		stateCh:                 make(chan ConnectionState, 1),
 	}
 
 	if cfg.pcmQueueSize > 0 {
@@ -365,15 +428,14 @@ func (s *Service) NewRTCConnection(opts ...RTCConnectionOption) (*RTCConnection,
 
 	// Setup the channels and sample rate. You should setup it before registering the observers.
 	if err := conn.setupChannelsAndSampleRate(cfg.sampleRate, cfg.audioChannelType); err != nil {
+		rtcConn.Release()
 		return nil, fmt.Errorf("failed to setup channels and sample rate, %w", err)
 	}
 
-	// Create a channel to notify when the connection is established.
-	// When the onConnectedCallback is called, the channel will be notified.
-	connectedCh := make(chan struct{})
+	conn.state.Store(int32(ConnectionStateDisconnected))
 
-	// Register the connection observer.
-	conn.registerConnectionObserver(cfg, connectedCh)
+	// Register the connection observer. It records the state changes and completes the pending connect.
+	conn.registerConnectionObserver(cfg)
 
 	// Register the local user observer.
 	conn.registerLocalUserObserver(cfg)
@@ -381,17 +443,24 @@ func (s *Service) NewRTCConnection(opts ...RTCConnectionOption) (*RTCConnection,
 	// Register the audio frame observer.
 	conn.registerAudioFrameObserver(cfg)
 
-	// Connect to the channel.
-	if ret := conn.rtcConn.Connect(s.token, s.channelName, s.userID); ret != 0 {
-		return nil, fmt.Errorf("failed to connect to the channel, return %d", ret)
-	}
-
-	// Wait for the connection to be established.
-	<-connectedCh
+	conn.trace(tracePhaseCreated)
 
 	return conn, nil
 }
 
+// serviceToken returns the token to connect to the channel of the service. If the service built its
+// token, it's renewed until the connection is released.
+func (c *RTCConnection) serviceToken() (string, error) {
+	if !c.svc.tokenManaged {
+		return c.svc.token, nil
+	}
+	token, err := c.svc.tokens.track(c, c.svc.channelName, c.svc.userID)
+	if err != nil {
+		return "", fmt.Errorf("failed to generate token, %w", err)
+	}
+	return token, nil
+}
+
 func (s *Service) buildPublishConfig() *agoraservice.RtcConnectionPublishConfig {
 	publishCfg := agoraservice.NewRtcConPublishConfig()
 	publishCfg.AudioPublishType = agoraservice.AudioPublishTypePcm
@@ -406,6 +475,10 @@ func (c *RTCConnection) PushAudioPCMData(data []byte, startPtsInMs int64) error
 	if ret := c.rtcConn.PushAudioPcmData(data, int(c.sampleRate), int(c.channels), startPtsInMs); ret != 0 {
 		return fmt.Errorf("failed to push audio PCM data, return %d", ret)
 	}
+	c.trace(tracePhaseFirstPCM)
+	if c.pool != nil && !c.firstAudio.Load() && c.firstAudio.CompareAndSwap(false, true) {
+		c.pool.acquireToFirstAudio.Record(time.Since(time.Unix(0, c.acquiredAt)))
+	}
 	return nil
 }
 
@@ -440,6 +513,7 @@ func (c *RTCConnection) Disconnect() error {
 }
 
 func (c *RTCConnection) PublishAudio() error {
+	c.trace(tracePhasePublish)
 	if ret := c.rtcConn.PublishAudio(); ret != 0 {
 		return fmt.Errorf("failed to publish audio, return %d", ret)
 	}
@@ -453,65 +527,108 @@ func (c *RTCConnection) PublishVideo() error {
 	return nil
 }
 
-// Release releases the RTC connection resources.
+// Release releases the RTC connection resources. If callbacks of the connection are in flight, e.g. it's
+// called from one of them, it returns at once and the last of them queues the release on the service as
+// ReleaseAsync does.
 func (c *RTCConnection) Release() {
-	c.rtcConn.Release()
+	if c.closeCallbackGate() {
+		c.releaseOnce.Do(c.release)
+		c.svc.releaser.unhold()
+	} else if c.drained.Load() {
+		c.releaseOnce.Do(c.release)
+	}
 }
 
-func (c *RTCConnection) registerConnectionObserver(cfg *RTCConnectionConfig, connectedCh chan<- struct{}) {
+func (c *RTCConnection) registerConnectionObserver(cfg *RTCConnectionConfig) {
 	observer := &agoraservice.RtcConnectionObserver{
 		OnConnected: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo, reason int) {
-			if cfg.onConnected != nil {
-				cfg.onConnected(rtcConn, info, reason)
-			}
-			// Notify the channel that the connection is established.
-			connectedCh <- struct{}{}
+			c.guardCallback(func() {
+				if cfg.onConnected != nil {
+					cfg.onConnected(rtcConn, info, reason)
+				}
+				c.trace(tracePhaseConnected)
+				c.setState(ConnectionStateConnected, 0)
+			})
 		},
 		OnDisconnected: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo, reason int) {
-			if cfg.onDisconnected != nil {
-				cfg.onDisconnected(rtcConn, info, reason)
-			}
+			c.guardCallback(func() {
+				if cfg.onDisconnected != nil {
+					cfg.onDisconnected(rtcConn, info, reason)
+				}
+				c.setState(ConnectionStateDisconnected, 0)
+			})
 		},
 		OnConnecting: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo, reason int) {
-			if cfg.onConnecting != nil {
-				cfg.onConnecting(rtcConn, info, reason)
-			}
+			c.guardCallback(func() {
+				if cfg.onConnecting != nil {
+					cfg.onConnecting(rtcConn, info, reason)
+				}
+				c.setState(ConnectionStateConnecting, 0)
+			})
 		},
 		OnReconnecting: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo, reason int) {
-			if cfg.onReconnecting != nil {
-				cfg.onReconnecting(rtcConn, info, reason)
-			}
+			c.guardCallback(func() {
+				if cfg.onReconnecting != nil {
+					cfg.onReconnecting(rtcConn, info, reason)
+				}
+				c.setState(ConnectionStateReconnecting, 0)
+			})
 		},
 		OnReconnected: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo, reason int) {
-			if cfg.onReconnected != nil {
-				cfg.onReconnected(rtcConn, info, reason)
-			}
+			c.guardCallback(func() {
+				if cfg.onReconnected != nil {
+					cfg.onReconnected(rtcConn, info, reason)
+				}
+				c.setState(ConnectionStateConnected, 0)
+			})
 		},
 		OnConnectionLost: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo) {
-			if cfg.onConnectionLost != nil {
-				cfg.onConnectionLost(rtcConn, info)
-			}
+			c.guardCallback(func() {
+				if cfg.onConnectionLost != nil {
+					cfg.onConnectionLost(rtcConn, info)
+				}
+				c.setState(ConnectionStateReconnecting, 0)
+			})
 		},
 		OnConnectionFailure: func(rtcConn *agoraservice.RtcConnection, info *agoraservice.RtcConnectionInfo, errCode int) {
-			if cfg.onConnectionFailure != nil {
-				cfg.onConnectionFailure(rtcConn, info, errCode)
-			}
+			c.guardCallback(func() {
+				if cfg.onConnectionFailure != nil {
+					cfg.onConnectionFailure(rtcConn, info, errCode)
+				}
+				c.setState(ConnectionStateFailed, errCode)
+			})
+		},
+		OnTokenPrivilegeWillExpire: func(rtcConn *agoraservice.RtcConnection, token string) {
+			c.guardCallback(func() {
+				c.svc.tokens.renewNow(c)
+			})
+		},
+		OnTokenPrivilegeDidExpire: func(rtcConn *agoraservice.RtcConnection) {
+			c.guardCallback(func() {
+				c.svc.tokens.renewNow(c)
+			})
 		},
 		OnUserJoined: func(rtcConn *agoraservice.RtcConnection, uid string) {
-			if cfg.onUserJoined != nil {
-				cfg.onUserJoined(rtcConn, uid)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserJoined != nil {
+					cfg.onUserJoined(rtcConn, uid)
+				}
+			})
 		},
 		OnUserLeft: func(rtcConn *agoraservice.RtcConnection, uid string, reason int) {
-			if cfg.onUserLeft != nil {
-				cfg.onUserLeft(rtcConn, uid, reason)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserLeft != nil {
+					cfg.onUserLeft(rtcConn, uid, reason)
+				}
+			})
 		},
 		OnAIQoSCapabilityMissing: func(rtcConn *agoraservice.RtcConnection, defaultFallbackScenario int) int {
-			if cfg.onAIQoSCapabilityMissing != nil {
-				return cfg.onAIQoSCapabilityMissing(rtcConn, defaultFallbackScenario)
-			}
-			return defaultFallbackScenario
+			return guardCallbackResult(c, defaultFallbackScenario, func() int {
+				if cfg.onAIQoSCapabilityMissing != nil {
+					return cfg.onAIQoSCapabilityMissing(rtcConn, defaultFallbackScenario)
+				}
+				return defaultFallbackScenario
+			})
 		},
 	}
 
@@ -521,84 +638,117 @@ func (c *RTCConnection) registerConnectionObserver(cfg *RTCConnectionConfig, con
 func (c *RTCConnection) registerLocalUserObserver(cfg *RTCConnectionConfig) {
 	observer := &agoraservice.LocalUserObserver{
 		OnStreamMessage: func(localUser *agoraservice.LocalUser, uid string, streamId int, data []byte) {
-			if cfg.onStreamMessage != nil {
-				cfg.onStreamMessage(localUser, uid, streamId, data)
-			}
+			c.guardCallback(func() {
+				if cfg.onStreamMessage != nil {
+					cfg.onStreamMessage(localUser, uid, streamId, data)
+				}
+			})
 		},
 		OnUserInfoUpdated: func(localUser *agoraservice.LocalUser, uid string, userMediaInfo int, val int) {
-			if cfg.onUserInfoUpdated != nil {
-				cfg.onUserInfoUpdated(localUser, uid, userMediaInfo, val)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserInfoUpdated != nil {
+					cfg.onUserInfoUpdated(localUser, uid, userMediaInfo, val)
+				}
+			})
 		},
 		OnUserAudioTrackSubscribed: func(localUser *agoraservice.LocalUser, uid string, remoteAudioTrack *agoraservice.RemoteAudioTrack) {
-			if cfg.onUserAudioTrackSubscribed != nil {
-				cfg.onUserAudioTrackSubscribed(localUser, uid, remoteAudioTrack)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserAudioTrackSubscribed != nil {
+					cfg.onUserAudioTrackSubscribed(localUser, uid, remoteAudioTrack)
+				}
+			})
 		},
 		OnUserVideoTrackSubscribed: func(localUser *agoraservice.LocalUser, uid string, info *agoraservice.VideoTrackInfo, remoteVideoTrack *agoraservice.RemoteVideoTrack) {
-			if cfg.onUserVideoTrackSubscribed != nil {
-				cfg.onUserVideoTrackSubscribed(localUser, uid, info, remoteVideoTrack)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserVideoTrackSubscribed != nil {
+					cfg.onUserVideoTrackSubscribed(localUser, uid, info, remoteVideoTrack)
+				}
+			})
 		},
 		OnUserAudioTrackStateChanged: func(localUser *agoraservice.LocalUser, uid string, remoteAudioTrack *agoraservice.RemoteAudioTrack, state int, reason int, elapsed int) {
-			if cfg.onUserAudioTrackStateChanged != nil {
-				cfg.onUserAudioTrackStateChanged(localUser, uid, remoteAudioTrack, state, reason, elapsed)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserAudioTrackStateChanged != nil {
+					cfg.onUserAudioTrackStateChanged(localUser, uid, remoteAudioTrack, state, reason, elapsed)
+				}
+			})
 		},
 		OnUserVideoTrackStateChanged: func(localUser *agoraservice.LocalUser, uid string, remoteVideoTrack *agoraservice.RemoteVideoTrack, state int, reason int, elapsed int) {
-			if cfg.onUserVideoTrackStateChanged != nil {
-				cfg.onUserVideoTrackStateChanged(localUser, uid, remoteVideoTrack, state, reason, elapsed)
-			}
+			c.guardCallback(func() {
+				if cfg.onUserVideoTrackStateChanged != nil {
+					cfg.onUserVideoTrackStateChanged(localUser, uid, remoteVideoTrack, state, reason, elapsed)
+				}
+			})
 		},
 		OnAudioPublishStateChanged: func(localUser *agoraservice.LocalUser, channelId string, oldState int, newState int, elapsed int) {
-			if cfg.onAudioPublishStateChanged != nil {
-				cfg.onAudioPublishStateChanged(localUser, channelId, oldState, newState, elapsed)
-			}
+			c.guardCallback(func() {
+				if cfg.onAudioPublishStateChanged != nil {
+					cfg.onAudioPublishStateChanged(localUser, channelId, oldState, newState, elapsed)
+				}
+			})
 		},
 		OnAudioVolumeIndication: func(localUser *agoraservice.LocalUser, audioVolumeInfo []*agoraservice.AudioVolumeInfo, speakerNumber int, totalVolume int) {
-			if cfg.onAudioVolumeIndication != nil {
-				cfg.onAudioVolumeIndication(localUser, audioVolumeInfo, speakerNumber, totalVolume)
-			}
+			c.guardCallback(func() {
+				if cfg.onAudioVolumeIndication != nil {
+					cfg.onAudioVolumeIndication(localUser, audioVolumeInfo, speakerNumber, totalVolume)
+				}
+			})
 		},
 		OnAudioMetaDataReceived: func(localUser *agoraservice.LocalUser, uid string, metaData []byte) {
-			if cfg.onAudioMetaDataReceived != nil {
-				cfg.onAudioMetaDataReceived(localUser, uid, metaData)
-			}
+			c.guardCallback(func() {
+				if cfg.onAudioMetaDataReceived != nil {
+					cfg.onAudioMetaDataReceived(localUser, uid, metaData)
+				}
+			})
 		},
 		OnLocalAudioTrackStatistics: func(localUser *agoraservice.LocalUser, stats *agoraservice.LocalAudioTrackStats) {
-			if cfg.onLocalAudioTrackStatistics != nil {
-				cfg.onLocalAudioTrackStatistics(localUser, stats)
-			}
+			c.guardCallback(func() {
+				if cfg.onLocalAudioTrackStatistics != nil {
+					cfg.onLocalAudioTrackStatistics(localUser, stats)
+				}
+			})
 		},
 		OnRemoteAudioTrackStatistics: func(localUser *agoraservice.LocalUser, uid string, stats *agoraservice.RemoteAudioTrackStats) {
-			if cfg.onRemoteAudioTrackStatistics != nil {
-				cfg.onRemoteAudioTrackStatistics(localUser, uid, stats)
-			}
+			c.guardCallback(func() {
+				if cfg.onRemoteAudioTrackStatistics != nil {
+					cfg.onRemoteAudioTrackStatistics(localUser, uid, stats)
+				}
+			})
 		},
 		OnLocalVideoTrackStatistics: func(localUser *agoraservice.LocalUser, stats *agoraservice.LocalVideoTrackStats) {
-			if cfg.onLocalVideoTrackStatistics != nil {
-				cfg.onLocalVideoTrackStatistics(localUser, stats)
-			}
+			c.guardCallback(func() {
+				if cfg.onLocalVideoTrackStatistics != nil {
+					cfg.onLocalVideoTrackStatistics(localUser, stats)
+				}
+			})
 		},
 		OnRemoteVideoTrackStatistics: func(localUser *agoraservice.LocalUser, uid string, stats *agoraservice.RemoteVideoTrackStats) {
-			if cfg.onRemoteVideoTrackStatistics != nil {
-				cfg.onRemoteVideoTrackStatistics(localUser, uid, stats)
-			}
+			c.guardCallback(func() {
+				if cfg.onRemoteVideoTrackStatistics != nil {
+					cfg.onRemoteVideoTrackStatistics(localUser, uid, stats)
+				}
+			})
 		},
 		OnAudioTrackPublishSuccess: func(localUser *agoraservice.LocalUser, audioTrack *agoraservice.LocalAudioTrack) {
-			if cfg.onAudioTrackPublishSuccess != nil {
-				cfg.onAudioTrackPublishSuccess(localUser, audioTrack)
-			}
+			c.guardCallback(func() {
+				c.trace(tracePhasePublished)
+				if cfg.onAudioTrackPublishSuccess != nil {
+					cfg.onAudioTrackPublishSuccess(localUser, audioTrack)
+				}
+			})
 		},
 		OnAudioTrackUnpublished: func(localUser *agoraservice.LocalUser, audioTrack *agoraservice.LocalAudioTrack) {
-			if cfg.onAudioTrackUnpublished != nil {
-				cfg.onAudioTrackUnpublished(localUser, audioTrack)
-			}
+			c.guardCallback(func() {
+				if cfg.onAudioTrackUnpublished != nil {
+					cfg.onAudioTrackUnpublished(localUser, audioTrack)
+				}
+			})
 		},
 		OnIntraRequestReceived: func(localUser *agoraservice.LocalUser) {
-			if cfg.onIntraRequestReceived != nil {
-				cfg.onIntraRequestReceived(localUser)
-			}
+			c.guardCallback(func() {
+				if cfg.onIntraRequestReceived != nil {
+					cfg.onIntraRequestReceived(localUser)
+				}
+			})
 		},
 	}
 	c.rtcConn.RegisterLocalUserObserver(observer)
@@ -607,70 +757,91 @@ func (c *RTCConnection) registerLocalUserObserver(cfg *RTCConnectionConfig) {
 func (c *RTCConnection) registerAudioFrameObserver(cfg *RTCConnectionConfig) {
 	observer := &agoraservice.AudioFrameObserver{
 		OnRecordAudioFrame: func(localUser *agoraservice.LocalUser, channelId string, frame *agoraservice.AudioFrame) bool {
-			if cfg.onRecordAudioFrame != nil {
-				return cfg.onRecordAudioFrame(localUser, channelId, frame)
-			}
-			return true
+			return guardCallbackResult(c, true, func() bool {
+				if cfg.onRecordAudioFrame != nil {
+					return cfg.onRecordAudioFrame(localUser, channelId, frame)
+				}
+				return true
+			})
 		},
 		OnPlaybackAudioFrame: func(localUser *agoraservice.LocalUser, channelId string, frame *agoraservice.AudioFrame) bool {
-			if cfg.onPlaybackAudioFrame != nil {
-				return cfg.onPlaybackAudioFrame(localUser, channelId, frame)
-			}
-			return true
+			return guardCallbackResult(c, true, func() bool {
+				if cfg.onPlaybackAudioFrame != nil {
+					return cfg.onPlaybackAudioFrame(localUser, channelId, frame)
+				}
+				return true
+			})
 		},
 		OnMixedAudioFrame: func(localUser *agoraservice.LocalUser, channelId string, frame *agoraservice.AudioFrame) bool {
-			if cfg.onMixedAudioFrame != nil {
-				return cfg.onMixedAudioFrame(localUser, channelId, frame)
-			}
-			return true
+			return guardCallbackResult(c, true, func() bool {
+				if cfg.onMixedAudioFrame != nil {
+					return cfg.onMixedAudioFrame(localUser, channelId, frame)
+				}
+				return true
+			})
 		},
 		OnEarMonitoringAudioFrame: func(localUser *agoraservice.LocalUser, frame *agoraservice.AudioFrame) bool {
-			if cfg.onEarMonitoringAudioFrame != nil {
-				return cfg.onEarMonitoringAudioFrame(localUser, frame)
-			}
-			return true
+			return guardCallbackResult(c, true, func() bool {
+				if cfg.onEarMonitoringAudioFrame != nil {
+					return cfg.onEarMonitoringAudioFrame(localUser, frame)
+				}
+				return true
+			})
 		},
 		OnPlaybackAudioFrameBeforeMixing: func(localUser *agoraservice.LocalUser, channelId string, uid string, frame *agoraservice.AudioFrame,
 			vadResultStat agoraservice.VadState, vadResultFrame *agoraservice.AudioFrame) bool {
-			if c.enableReceiveAudioFrame {
-				if err := c.recvAudioFrame(frame); err != nil {
-					return false
+			return guardCallbackResult(c, true, func() bool {
+				c.trace(tracePhaseFirstRemoteAudio)
+				if c.enableReceiveAudioFrame {
+					if err := c.recvAudioFrame(frame); err != nil {
+						return false
+					}
+				}
+				if cfg.onPlaybackAudioFrameBeforeMixing != nil {
+					return cfg.onPlaybackAudioFrameBeforeMixing(localUser, channelId, uid, frame, vadResultStat, vadResultFrame)
 				}
-			}
-			if cfg.onPlaybackAudioFrameBeforeMixing != nil {
-				return cfg.onPlaybackAudioFrameBeforeMixing(localUser, channelId, uid, frame, vadResultStat, vadResultFrame)
-			}
-			return true
+				return true
+			})
 		},
 		OnGetAudioFramePosition: func(localUser *agoraservice.LocalUser) int {
-			if cfg.onGetAudioFramePosition != nil {
-				return cfg.onGetAudioFramePosition(localUser)
-			}
-			return 0
+			return guardCallbackResult(c, 0, func() int {
+				if cfg.onGetAudioFramePosition != nil {
+					return cfg.onGetAudioFramePosition(localUser)
+				}
+				return 0
+			})
 		},
 		OnGetPlaybackAudioFrameParam: func(localUser *agoraservice.LocalUser) agoraservice.AudioFrameObserverAudioParams {
-			if cfg.onGetPlaybackAudioFrameParam != nil {
-				return cfg.onGetPlaybackAudioFrameParam(localUser)
-			}
-			return agoraservice.AudioFrameObserverAudioParams{}
+			return guardCallbackResult(c, agoraservice.AudioFrameObserverAudioParams{}, func() agoraservice.AudioFrameObserverAudioParams {
+				if cfg.onGetPlaybackAudioFrameParam != nil {
+					return cfg.onGetPlaybackAudioFrameParam(localUser)
+				}
+				return agoraservice.AudioFrameObserverAudioParams{}
+			})
 		},
 		OnGetRecordAudioFrameParam: func(localUser *agoraservice.LocalUser) agoraservice.AudioFrameObserverAudioParams {
-			if cfg.onGetRecordAudioFrameParam != nil {
-				return cfg.onGetRecordAudioFrameParam(localUser)
-			}
-			return agoraservice.AudioFrameObserverAudioParams{}
+			return guardCallbackResult(c, agoraservice.AudioFrameObserverAudioParams{}, func() agoraservice.AudioFrameObserverAudioParams {
+				if cfg.onGetRecordAudioFrameParam != nil {
+					return cfg.onGetRecordAudioFrameParam(localUser)
+				}
+				return agoraservice.AudioFrameObserverAudioParams{}
+			})
 		},
 		OnGetMixedAudioFrameParam: func(localUser *agoraservice.LocalUser) agoraservice.AudioFrameObserverAudioParams {
-			if cfg.onGetMixedAudioFrameParam != nil {
-				return cfg.onGetMixedAudioFrameParam(localUser)
-			}
-			return agoraservice.AudioFrameObserverAudioParams{}
+			return guardCallbackResult(c, agoraservice.AudioFrameObserverAudioParams{}, func() agoraservice.AudioFrameObserverAudioParams {
+				if cfg.onGetMixedAudioFrameParam != nil {
+					return cfg.onGetMixedAudioFrameParam(localUser)
+				}
+				return agoraservice.AudioFrameObserverAudioParams{}
+			})
 		},
 		OnGetEarMonitoringAudioFrameParam: func(localUser *agoraservice.LocalUser) agoraservice.AudioFrameObserverAudioParams {
-			if cfg.onGetEarMonitoringAudioFrameParam != nil {
-				return cfg.onGetEarMonitoringAudioFrameParam(localUser)
-			}
-			return agoraservice.AudioFrameObserverAudioParams{}
+			return guardCallbackResult(c, agoraservice.AudioFrameObserverAudioParams{}, func() agoraservice.AudioFrameObserverAudioParams {
+				if cfg.onGetEarMonitoringAudioFrameParam != nil {
+					return cfg.onGetEarMonitoringAudioFrameParam(localUser)
+				}
+				return agoraservice.AudioFrameObserverAudioParams{}
+			})
 		},
 	}
 
@@ -4,8 +4,8 @@ import (
 	"errors"
 	"fmt"
 	"os"
+	"time"
 
-	rtctokenbuilder "github.com/AgoraIO/Tools/DynamicKey/AgoraDynamicKey/go/src/rtctokenbuilder2"
 	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
 )
 
@@ -44,6 +44,16 @@ type Service struct {
 	channelName string
 	userID      string
 	token       string
+
+	// Builds and renews the tokens. tokenManaged is true if token was built by it.
+	tokens       *TokenManager
+	tokenManaged bool
+
+	// Releases the connections for ReleaseAsync.
+	releaser *releaseExecutor
+
+	// Aggregates the traces of the connections, nil if the tracing is disabled.
+	tracer *connectionTracer
 }
 
 // ServiceConfig represents the configuration for an Agora RTC service.
@@ -53,6 +63,11 @@ type ServiceConfig struct {
 	channelName string
 	token       string
 	svcCfg      *agoraservice.AgoraServiceConfig
+
+	releaseConcurrency int
+	tokenRenewBefore   time.Duration
+	tokenRenewJitter   time.Duration
+	connectionTracing  bool
 }
 
 // NewService creates a new Agora RTC service instance.
@@ -82,21 +97,36 @@ func NewService(opts ...ServiceOption) (*Service, error) {
 		return nil, ErrEmptyChannelName
 	}
 
-	if cfg.token == "" {
-		if err := cfg.generateToken(); err != nil {
+	tokens, err := newTokenManager(cfg.svcCfg.AppId, cfg.appCert, cfg.tokenRenewBefore, cfg.tokenRenewJitter)
+	if err != nil {
+		return nil, err
+	}
+
+	tokenManaged := cfg.token == ""
+	if tokenManaged {
+		if cfg.token, err = tokens.Token(cfg.channelName, cfg.userID, TokenRolePublisher); err != nil {
 			return nil, fmt.Errorf("failed to generate token, %w", err)
 		}
 	}
 
+	var tracer *connectionTracer
+	if cfg.connectionTracing {
+		tracer = &connectionTracer{}
+	}
+
 	// Initialize the Agora RTC service.
 	if ret := agoraservice.Initialize(cfg.svcCfg); ret != 0 {
 		return nil, fmt.Errorf("failed to initialize Agora RTC service, return %d", ret)
 	}
 
 	return &Service{
-		userID:      cfg.userID,
-		channelName: cfg.channelName,
-		token:       cfg.token,
+		userID:       cfg.userID,
+		channelName:  cfg.channelName,
+		token:        cfg.token,
+		tokens:       tokens,
+		tokenManaged: tokenManaged,
+		releaser:     newReleaseExecutor(cfg.releaseConcurrency),
+		tracer:       tracer,
 	}, nil
 }
 
@@ -165,20 +195,40 @@ func WithDataDir(dir string) ServiceOption {
 	}
 }
 
-// Release releases the service resources.
-func (s *Service) Release() {
-	agoraservice.Release()
+// WithReleaseConcurrency sets the number of connections released in parallel by ReleaseAsync, the
+// default is DefaultReleaseConcurrency.
+func WithReleaseConcurrency(concurrency int) ServiceOption {
+	return func(cfg *ServiceConfig) {
+		cfg.releaseConcurrency = concurrency
+	}
 }
 
-func (cfg *ServiceConfig) generateToken() error {
-	token, err := rtctokenbuilder.BuildTokenWithUserAccount(cfg.svcCfg.AppId, cfg.appCert, cfg.channelName, cfg.userID,
-		rtctokenbuilder.RolePublisher, DefaultTokenExpirationInSeconds, DefaultPrivilegeExpirationInSeconds)
-	if err != nil {
-		return err
+// WithTokenRenewal sets when the tokens built by the service are renewed: a random time between before
+// and before+jitter ahead of their expiration. The defaults are DefaultTokenRenewBefore and
+// DefaultTokenRenewJitter.
+func WithTokenRenewal(before time.Duration, jitter time.Duration) ServiceOption {
+	return func(cfg *ServiceConfig) {
+		cfg.tokenRenewBefore = before
+		cfg.tokenRenewJitter = jitter
 	}
+}
 
-	// Set the token that requested from the Agora.
-	cfg.token = token
+// WithConnectionTracing enables the tracing of the join and publish of the connections, see
+// RTCConnection.Timeline and Service.TraceStats. It's cheap enough to keep enabled.
+func WithConnectionTracing(enabled bool) ServiceOption {
+	return func(cfg *ServiceConfig) {
+		cfg.connectionTracing = enabled
+	}
+}
+
+// TokenManager returns the token manager of the service.
+func (s *Service) TokenManager() *TokenManager {
+	return s.tokens
+}
 
-	return nil
+// Release releases the service resources, after the connections queued by ReleaseAsync.
+func (s *Service) Release() {
+	s.releaser.wait()
+	s.tokens.close()
+	agoraservice.Release()
 }
@@ -0,0 +1,75 @@
+package shard
+
+import (
+	"hash/fnv"
+	"sort"
+	"strconv"
+)
+
+// hashPoint is a virtual node of a worker on the hash ring.
+type hashPoint struct {
+	hash   uint32
+	worker int
+}
+
+// hashRing maps channels to workers by consistent hashing, so that adding or removing a worker only
+// moves the channels of that worker.
+type hashRing struct {
+	replicas int
+	points   []hashPoint
+}
+
+func newHashRing(replicas int) *hashRing {
+	return &hashRing{replicas: replicas}
+}
+
+// hashKey is fnv-1a with the murmur3 finalizer, fnv alone spreads similar keys like "1#2" poorly.
+func hashKey(key string) uint32 {
+	h := fnv.New64a()
+	h.Write([]byte(key))
+	x := h.Sum64()
+	x ^= x >> 33
+	x *= 0xff51afd7ed558ccd
+	x ^= x >> 33
+	x *= 0xc4ceb9fe1a85ec53
+	x ^= x >> 33
+	return uint32(x)
+}
+
+func (h *hashRing) add(worker int) {
+	h.remove(worker)
+	for i := 0; i < h.replicas; i++ {
+		h.points = append(h.points, hashPoint{
+			hash:   hashKey(strconv.Itoa(worker) + "#" + strconv.Itoa(i)),
+			worker: worker,
+		})
+	}
+	sort.Slice(h.points, func(i, j int) bool {
+		return h.points[i].hash < h.points[j].hash
+	})
+}
+
+func (h *hashRing) remove(worker int) {
+	points := h.points[:0]
+	for _, p := range h.points {
+		if p.worker != worker {
+			points = append(points, p)
+		}
+	}
+	h.points = points
+}
+
+// lookup returns the worker of key, or -1 if there is no worker.
+func (h *hashRing) lookup(key string) int {
+	if len(h.points) == 0 {
+		return -1
+	}
+	hash := hashKey(key)
+	i := sort.Search(len(h.points), func(i int) bool {
+		return h.points[i].hash >= hash
+	})
+	if i == len(h.points) {
+		i = 0
+	}
+	return h.points[i].worker
+}
@@ -0,0 +1,13 @@
+//go:build linux
+
+package shard
+
+import (
+	"os/exec"
+	"syscall"
+)
+
+// setWorkerProcAttr makes the kernel kill the worker if the supervisor dies.
+func setWorkerProcAttr(cmd *exec.Cmd) {
+	cmd.SysProcAttr = &syscall.SysProcAttr{Pdeathsig: syscall.SIGKILL}
+}
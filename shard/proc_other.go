@@ -0,0 +1,10 @@
+//go:build !linux
+
+package shard
+
+import "os/exec"
+
+// setWorkerProcAttr does nothing where there is no parent death signal, the worker exits when its
+// control pipe is closed.
+func setWorkerProcAttr(cmd *exec.Cmd) {
+}
@@ -0,0 +1,94 @@
+// Package shard runs the RTC connections of a host in several worker processes, each with its own SDK
+// instance, so that a crash or a long GC pause of one process only affects the channels of that process.
+//
+// The supervisor starts the workers by executing its own binary again, assigns channels to workers by
+// consistent hashing and moves PCM audio between itself and the workers over shared memory rings. It
+// checks the health of the workers and moves the channels of a dead worker to the others.
+package shard
+
+import "time"
+
+const (
+	// workerEnvVar holds the index of the worker in the environment of a worker process.
+	workerEnvVar = "AGORA_SHARD_WORKER"
+
+	// workerRingSizeEnvVar holds the size of the shared memory of each ring.
+	workerRingSizeEnvVar = "AGORA_SHARD_RING_SIZE"
+)
+
+// The descriptors of a worker process, after stdin, stdout and stderr.
+const (
+	workerControlInFd  = 3 // control messages from the supervisor
+	workerControlOutFd = 4 // control messages to the supervisor
+	workerRingInFd     = 5 // pcm from the supervisor
+	workerRingOutFd    = 6 // pcm to the supervisor
+)
+
+const (
+	// DefaultRingSize is the default size of a ring in bytes, about 20s of 16kHz mono pcm.
+	DefaultRingSize = 1 << 20
+
+	// DefaultHealthCheckInterval is the default interval of the health checks of the workers.
+	DefaultHealthCheckInterval = time.Second
+
+	// DefaultHealthCheckTimeout is the default time without answer after which a worker is killed.
+	DefaultHealthCheckTimeout = 5 * time.Second
+
+	// DefaultRestartDelay is the default delay before a dead worker is started again.
+	DefaultRestartDelay = time.Second
+
+	// DefaultJoinTimeout is the default time a worker has to join a channel.
+	DefaultJoinTimeout = 10 * time.Second
+
+	// hashRingReplicas is the number of virtual nodes of each worker.
+	hashRingReplicas = 64
+
+	// The polling intervals of the ring readers when the rings are empty.
+	ringPollMinInterval = 100 * time.Microsecond
+	ringPollMaxInterval = 2 * time.Millisecond
+)
+
+// The operations of the control messages.
+const (
+	opJoin  = "join"  // supervisor -> worker, replied
+	opLeave = "leave" // supervisor -> worker, replied
+	opPing  = "ping"  // supervisor -> worker
+	opPong  = "pong"  // worker -> supervisor
+	opReply = "reply" // worker -> supervisor
+)
+
+// controlMessage is a message of the control pipes, one json object per line.
+type controlMessage struct {
+	Op      string `json:"op"`
+	Seq     uint64 `json:"seq,omitempty"`
+	Channel string `json:"channel,omitempty"`
+	ID      uint32 `json:"id,omitempty"`
+	UserID  string `json:"user_id,omitempty"`
+	Token   string `json:"token,omitempty"`
+	Error   string `json:"error,omitempty"`
+	// The pcm dropped by Worker.SendPCM, in pongs.
+	Dropped uint64 `json:"dropped,omitempty"`
+}
+
+// pollRing reads the records of r until stop is closed, with an increasing sleep while r is empty.
+func pollRing(r *ring, stop <-chan struct{}, fn func(id uint32, payload []byte)) {
+	interval := ringPollMinInterval
+	timer := time.NewTimer(interval)
+	defer timer.Stop()
+	<-timer.C
+	for {
+		if r.read(fn) {
+			interval = ringPollMinInterval
+			continue
+		}
+		timer.Reset(interval)
+		select {
+		case <-stop:
+			return
+		case <-timer.C:
+		}
+		if interval < ringPollMaxInterval {
+			interval *= 2
+		}
+	}
+}
@@ -0,0 +1,129 @@
+package shard
+
+import (
+	"encoding/binary"
+	"math"
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+const (
+	// The head (written by the producer) and the tail (written by the consumer) are on their own cache lines.
+	ringHeadOffset = 0
+	ringTailOffset = 64
+	ringHeaderSize = 128
+
+	// A record is the payload length, the channel id and the payload, padded to 8 bytes.
+	ringRecordHeaderSize = 8
+
+	// The length of the record which skips the end of the data region.
+	ringPadding = math.MaxUint32
+)
+
+// ring is a single producer single consumer queue of records in shared memory. The producer and the
+// consumer are in different processes and only synchronize through the atomic head and tail; the
+// goroutines of one side are serialized by mu.
+type ring struct {
+	mu     sync.Mutex
+	closed bool
+
+	head *uint64
+	tail *uint64
+	data []byte
+	size uint64
+}
+
+// ringMemorySize returns the size of the shared memory of a ring of capacity bytes of records.
+func ringMemorySize(capacity int) int {
+	return ringHeaderSize + (capacity+7)&^7
+}
+
+func newRing(mem []byte) *ring {
+	data := mem[ringHeaderSize:]
+	data = data[:len(data)&^7]
+	return &ring{
+		head: (*uint64)(unsafe.Pointer(&mem[ringHeadOffset])),
+		tail: (*uint64)(unsafe.Pointer(&mem[ringTailOffset])),
+		data: data,
+		size: uint64(len(data)),
+	}
+}
+
+// maxPayload returns the largest payload which fits in the ring.
+func (r *ring) maxPayload() int {
+	return int(r.size/2) - ringRecordHeaderSize
+}
+
+// write appends a record, it returns false if the ring is full or closed and the record is dropped.
+func (r *ring) write(id uint32, payload []byte) bool {
+	if len(payload) > r.maxPayload() {
+		return false
+	}
+	need := uint64(ringRecordHeaderSize+len(payload)+7) &^ 7
+
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if r.closed {
+		return false
+	}
+
+	head := atomic.LoadUint64(r.head)
+	tail := atomic.LoadUint64(r.tail)
+	pos := head % r.size
+	pad := uint64(0)
+	if pos+need > r.size {
+		pad = r.size - pos
+	}
+	if head+pad+need-tail > r.size {
+		return false
+	}
+	if pad > 0 {
+		binary.LittleEndian.PutUint32(r.data[pos:], ringPadding)
+		pos = 0
+	}
+	binary.LittleEndian.PutUint32(r.data[pos:], uint32(len(payload)))
+	binary.LittleEndian.PutUint32(r.data[pos+4:], id)
+	copy(r.data[pos+ringRecordHeaderSize:], payload)
+	// Publish the record after its bytes.
+	atomic.StoreUint64(r.head, head+pad+need)
+	return true
+}
+
+// read passes the next record to fn and returns true, or returns false if the ring is empty.
+// The payload is only valid during fn.
+func (r *ring) read(fn func(id uint32, payload []byte)) bool {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if r.closed {
+		return false
+	}
+
+	tail := atomic.LoadUint64(r.tail)
+	for {
+		head := atomic.LoadUint64(r.head)
+		if tail == head {
+			return false
+		}
+		pos := tail % r.size
+		length := binary.LittleEndian.Uint32(r.data[pos:])
+		if length == ringPadding {
+			tail += r.size - pos
+			atomic.StoreUint64(r.tail, tail)
+			continue
+		}
+		id := binary.LittleEndian.Uint32(r.data[pos+4:])
+		start := pos + ringRecordHeaderSize
+		fn(id, r.data[start:start+uint64(length)])
+		atomic.StoreUint64(r.tail, tail+(uint64(ringRecordHeaderSize)+uint64(length)+7)&^7)
+		return true
+	}
+}
+
+// close makes the following reads and writes fail, once the running one returns. The memory may be
+// unmapped after close.
+func (r *ring) close() {
+	r.mu.Lock()
+	r.closed = true
+	r.mu.Unlock()
+}
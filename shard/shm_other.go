@@ -0,0 +1,21 @@
+//go:build !unix
+
+package shard
+
+import (
+	"errors"
+	"os"
+)
+
+var errSharedMemoryUnsupported = errors.New("shared memory is not supported on this platform")
+
+func createSharedMemory(size int) (*os.File, []byte, error) {
+	return nil, nil, errSharedMemoryUnsupported
+}
+
+func mapSharedMemory(f *os.File, size int) ([]byte, error) {
+	return nil, errSharedMemoryUnsupported
+}
+
+func unmapSharedMemory(mem []byte) {
+}
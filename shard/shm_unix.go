@@ -0,0 +1,43 @@
+//go:build unix
+
+package shard
+
+import (
+	"os"
+	"syscall"
+)
+
+// createSharedMemory creates an unlinked file of size bytes, in /dev/shm if it exists, and maps it.
+// The file is passed to the worker, which maps the same pages.
+func createSharedMemory(size int) (*os.File, []byte, error) {
+	dir := "/dev/shm"
+	if info, err := os.Stat(dir); err != nil || !info.IsDir() {
+		dir = os.TempDir()
+	}
+	f, err := os.CreateTemp(dir, "agora-shard-*")
+	if err != nil {
+		return nil, nil, err
+	}
+	// Only the open descriptors keep the memory.
+	os.Remove(f.Name())
+	if err := f.Truncate(int64(size)); err != nil {
+		f.Close()
+		return nil, nil, err
+	}
+	mem, err := mapSharedMemory(f, size)
+	if err != nil {
+		f.Close()
+		return nil, nil, err
+	}
+	return f, mem, nil
+}
+
+func mapSharedMemory(f *os.File, size int) ([]byte, error) {
+	return syscall.Mmap(int(f.Fd()), 0, size, syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_SHARED)
+}
+
+func unmapSharedMemory(mem []byte) {
+	if len(mem) > 0 {
+		syscall.Munmap(mem)
+	}
+}
@@ -0,0 +1,699 @@
+package shard
+
+import (
+	"bufio"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"os"
+	"os/exec"
+	"runtime"
+	"strconv"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+var (
+	// ErrSupervisorClosed is the error returned when using a closed supervisor.
+	ErrSupervisorClosed = errors.New("the supervisor is closed")
+
+	// ErrNoWorker is the error returned when no worker is alive to take a channel.
+	ErrNoWorker = errors.New("no worker is alive")
+
+	// ErrJoinTimeout is the error returned when a worker doesn't answer a join in time.
+	ErrJoinTimeout = errors.New("the worker didn't answer in time")
+)
+
+// Supervisor starts worker processes and spreads channels over them.
+//
+// A channel stays on its worker until it leaves or the worker dies; consistent hashing only decides
+// where a new channel goes, so a restarted worker doesn't take channels back from the others.
+type Supervisor struct {
+	cfg *supervisorConfig
+
+	mu       sync.Mutex
+	workers  []*worker
+	hash     *hashRing
+	channels map[string]*channelState
+	nextID   uint32
+	closed   bool
+
+	// Lock-free lookups of PushPCM and of the ring readers.
+	byName sync.Map // string -> *channelState
+	byID   sync.Map // uint32 -> *channelState
+
+	pendingMu sync.Mutex
+	pending   map[uint64]chan controlMessage
+	seq       atomic.Uint64
+
+	moves atomic.Uint64
+	done  chan struct{}
+	wg    sync.WaitGroup
+}
+
+// SupervisorStats represents the state of the workers of a supervisor.
+type SupervisorStats struct {
+	Workers  []WorkerStats
+	Channels int
+	// The number of channels moved from a dead worker to another one.
+	Moves uint64
+}
+
+// WorkerStats represents the state of a worker process.
+type WorkerStats struct {
+	Index    int
+	Pid      int
+	Alive    bool
+	Channels int
+	Restarts int
+
+	// The pcm dropped because a ring was full, to and from the worker.
+	DroppedIn  uint64
+	DroppedOut uint64
+}
+
+type supervisorConfig struct {
+	workers             int
+	path                string
+	args                []string
+	env                 []string
+	ringSize            int
+	healthCheckInterval time.Duration
+	healthCheckTimeout  time.Duration
+	restartDelay        time.Duration
+	joinTimeout         time.Duration
+	onPCM               func(channel string, data []byte)
+	onChannelMoved      func(channel string, from int, to int)
+	onError             func(err error)
+}
+
+// SupervisorOption is a function that configures a supervisor.
+type SupervisorOption func(*supervisorConfig)
+
+// WithWorkers sets the number of worker processes, 0 means one per 8 CPUs.
+func WithWorkers(workers int) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.workers = workers
+	}
+}
+
+// WithWorkerCommand sets the command of the workers, by default the binary of the supervisor with the
+// same arguments. The command must call RunWorker when IsWorker returns true.
+func WithWorkerCommand(path string, args ...string) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.path = path
+		cfg.args = args
+	}
+}
+
+// WithWorkerEnv adds environment variables to the workers.
+func WithWorkerEnv(env ...string) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.env = append(cfg.env, env...)
+	}
+}
+
+// WithRingSize sets the size in bytes of the shared memory rings, one in each direction per worker.
+func WithRingSize(size int) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.ringSize = size
+	}
+}
+
+// WithHealthCheck sets the interval of the health checks and the time without answer after which a worker
+// is killed and its channels are moved.
+func WithHealthCheck(interval time.Duration, timeout time.Duration) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.healthCheckInterval = interval
+		cfg.healthCheckTimeout = timeout
+	}
+}
+
+// WithRestartDelay sets the delay before a dead worker is started again.
+func WithRestartDelay(delay time.Duration) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.restartDelay = delay
+	}
+}
+
+// WithJoinTimeout sets the time a worker has to join a channel.
+func WithJoinTimeout(timeout time.Duration) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.joinTimeout = timeout
+	}
+}
+
+// WithOnPCM sets the callback of the pcm sent by the workers with Worker.SendPCM.
+// The data is only valid during the call.
+func WithOnPCM(onPCM func(channel string, data []byte)) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.onPCM = onPCM
+	}
+}
+
+// WithOnChannelMoved sets the callback called when a channel of a dead worker is joined on another worker.
+func WithOnChannelMoved(onChannelMoved func(channel string, from int, to int)) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.onChannelMoved = onChannelMoved
+	}
+}
+
+// WithOnError sets the callback of the errors which no call returns, e.g. a worker which exited or a
+// channel which failed to move. It may be called from different goroutines.
+func WithOnError(onError func(err error)) SupervisorOption {
+	return func(cfg *supervisorConfig) {
+		cfg.onError = onError
+	}
+}
+
+type channelState struct {
+	name   string
+	id     uint32
+	userID string
+	token  string
+	// The worker of the channel, the one it's joined on or being moved to.
+	worker atomic.Pointer[worker]
+	// The index of the worker, kept while no worker is alive.
+	index int
+}
+
+type worker struct {
+	index    int
+	restarts int
+
+	cmd        *exec.Cmd
+	control    *json.Encoder
+	controlMu  sync.Mutex
+	controlOut *os.File
+
+	in     *ring // to the worker
+	out    *ring // from the worker
+	inMem  []byte
+	outMem []byte
+
+	alive      atomic.Bool
+	lastPong   atomic.Int64
+	droppedIn  atomic.Uint64
+	droppedOut atomic.Uint64
+
+	stop       chan struct{}
+	readerDone chan struct{}
+	exited     chan struct{}
+}
+
+// NewSupervisor starts the workers. It returns an error if one of them can't be started.
+func NewSupervisor(opts ...SupervisorOption) (*Supervisor, error) {
+	cfg := &supervisorConfig{
+		path:                os.Args[0],
+		args:                os.Args[1:],
+		ringSize:            DefaultRingSize,
+		healthCheckInterval: DefaultHealthCheckInterval,
+		healthCheckTimeout:  DefaultHealthCheckTimeout,
+		restartDelay:        DefaultRestartDelay,
+		joinTimeout:         DefaultJoinTimeout,
+	}
+
+	// Apply the options.
+	for _, opt := range opts {
+		opt(cfg)
+	}
+
+	if cfg.workers <= 0 {
+		cfg.workers = runtime.NumCPU() / 8
+		if cfg.workers < 1 {
+			cfg.workers = 1
+		}
+	}
+
+	if IsWorker() {
+		return nil, fmt.Errorf("a worker can't start a supervisor")
+	}
+
+	s := &Supervisor{
+		cfg:      cfg,
+		workers:  make([]*worker, cfg.workers),
+		hash:     newHashRing(hashRingReplicas),
+		channels: make(map[string]*channelState),
+		pending:  make(map[uint64]chan controlMessage),
+		done:     make(chan struct{}),
+	}
+
+	for i := range s.workers {
+		w, err := s.startWorker(i)
+		if err != nil {
+			s.Close()
+			return nil, fmt.Errorf("failed to start worker %d, %w", i, err)
+		}
+		s.mu.Lock()
+		s.workers[i] = w
+		s.hash.add(i)
+		s.mu.Unlock()
+	}
+
+	s.wg.Add(1)
+	go s.healthCheckLoop()
+
+	return s, nil
+}
+
+// Join assigns the channel to a worker, which joins it as userID, and returns the index of the worker.
+// Joining a channel twice returns the worker of the channel.
+func (s *Supervisor) Join(channel string, userID string, token string) (int, error) {
+	s.mu.Lock()
+	if s.closed {
+		s.mu.Unlock()
+		return -1, ErrSupervisorClosed
+	}
+	if cs, ok := s.channels[channel]; ok {
+		s.mu.Unlock()
+		return cs.index, nil
+	}
+	index := s.hash.lookup(channel)
+	if index < 0 {
+		s.mu.Unlock()
+		return -1, ErrNoWorker
+	}
+	s.nextID++
+	cs := &channelState{name: channel, id: s.nextID, userID: userID, token: token, index: index}
+	w := s.workers[index]
+	cs.worker.Store(w)
+	s.channels[channel] = cs
+	s.byName.Store(channel, cs)
+	s.byID.Store(cs.id, cs)
+	s.mu.Unlock()
+
+	if err := s.join(w, cs); err != nil {
+		s.remove(cs)
+		return -1, err
+	}
+	return index, nil
+}
+
+// Leave makes the worker of the channel leave it.
+func (s *Supervisor) Leave(channel string) error {
+	s.mu.Lock()
+	cs, ok := s.channels[channel]
+	s.mu.Unlock()
+	if !ok {
+		return ErrUnknownChannel
+	}
+	s.remove(cs)
+
+	w := cs.worker.Load()
+	if w == nil || !w.alive.Load() {
+		return nil
+	}
+	reply, err := s.request(w, controlMessage{Op: opLeave, Channel: channel, ID: cs.id})
+	if err != nil {
+		return err
+	}
+	if reply.Error != "" {
+		return errors.New(reply.Error)
+	}
+	return nil
+}
+
+// PushPCM queues pcm for the worker of the channel, which passes it to WorkerHandler.OnPCM.
+// It doesn't block, ErrRingFull is returned if the worker doesn't keep up and the pcm is dropped.
+func (s *Supervisor) PushPCM(channel string, data []byte) error {
+	v, ok := s.byName.Load(channel)
+	if !ok {
+		return ErrUnknownChannel
+	}
+	cs := v.(*channelState)
+	w := cs.worker.Load()
+	if w == nil || !w.alive.Load() {
+		return ErrNoWorker
+	}
+	if !w.in.write(cs.id, data) {
+		w.droppedIn.Add(1)
+		return ErrRingFull
+	}
+	return nil
+}
+
+// Stats returns the state of the workers.
+func (s *Supervisor) Stats() SupervisorStats {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	stats := SupervisorStats{
+		Workers:  make([]WorkerStats, len(s.workers)),
+		Channels: len(s.channels),
+		Moves:    s.moves.Load(),
+	}
+	for i, w := range s.workers {
+		ws := WorkerStats{Index: i}
+		if w != nil {
+			ws.Alive = w.alive.Load()
+			ws.Restarts = w.restarts
+			ws.DroppedIn = w.droppedIn.Load()
+			ws.DroppedOut = w.droppedOut.Load()
+			if w.cmd.Process != nil {
+				ws.Pid = w.cmd.Process.Pid
+			}
+		}
+		stats.Workers[i] = ws
+	}
+	for _, cs := range s.channels {
+		stats.Workers[cs.index].Channels++
+	}
+	return stats
+}
+
+// Close stops the workers, which leave their channels, and waits for them to exit.
+func (s *Supervisor) Close() {
+	s.mu.Lock()
+	if s.closed {
+		s.mu.Unlock()
+		return
+	}
+	s.closed = true
+	close(s.done)
+	workers := append([]*worker(nil), s.workers...)
+	s.mu.Unlock()
+	s.wg.Wait()
+
+	for _, w := range workers {
+		if w == nil {
+			continue
+		}
+		// The worker leaves its channels and exits when the control pipe is closed.
+		w.controlOut.Close()
+		select {
+		case <-w.exited:
+		case <-time.After(s.cfg.healthCheckTimeout):
+			w.cmd.Process.Kill()
+			<-w.exited
+		}
+	}
+}
+
+func (s *Supervisor) startWorker(index int) (*worker, error) {
+	size := ringMemorySize(s.cfg.ringSize)
+	inFile, inMem, err := createSharedMemory(size)
+	if err != nil {
+		return nil, err
+	}
+	defer inFile.Close()
+	outFile, outMem, err := createSharedMemory(size)
+	if err != nil {
+		unmapSharedMemory(inMem)
+		return nil, err
+	}
+	defer outFile.Close()
+
+	// The worker reads controlInR and writes controlOutW.
+	controlInR, controlInW, err := os.Pipe()
+	if err != nil {
+		unmapSharedMemory(inMem)
+		unmapSharedMemory(outMem)
+		return nil, err
+	}
+	controlOutR, controlOutW, err := os.Pipe()
+	if err != nil {
+		controlInR.Close()
+		controlInW.Close()
+		unmapSharedMemory(inMem)
+		unmapSharedMemory(outMem)
+		return nil, err
+	}
+
+	cmd := exec.Command(s.cfg.path, s.cfg.args...)
+	cmd.Env = append(os.Environ(), s.cfg.env...)
+	cmd.Env = append(cmd.Env, workerEnvVar+"="+strconv.Itoa(index), workerRingSizeEnvVar+"="+strconv.Itoa(size))
+	cmd.Stdout = os.Stdout
+	cmd.Stderr = os.Stderr
+	// The descriptors 3 to 6 of the worker.
+	cmd.ExtraFiles = []*os.File{controlInR, controlOutW, inFile, outFile}
+	setWorkerProcAttr(cmd)
+
+	err = cmd.Start()
+	// The worker has its copies.
+	controlInR.Close()
+	controlOutW.Close()
+	if err != nil {
+		controlInW.Close()
+		controlOutR.Close()
+		unmapSharedMemory(inMem)
+		unmapSharedMemory(outMem)
+		return nil, err
+	}
+
+	w := &worker{
+		index:      index,
+		cmd:        cmd,
+		control:    json.NewEncoder(controlInW),
+		controlOut: controlInW,
+		in:         newRing(inMem),
+		out:        newRing(outMem),
+		inMem:      inMem,
+		outMem:     outMem,
+		stop:       make(chan struct{}),
+		readerDone: make(chan struct{}),
+		exited:     make(chan struct{}),
+	}
+	w.alive.Store(true)
+	w.lastPong.Store(time.Now().UnixNano())
+
+	go s.readControl(w, controlOutR)
+	go func() {
+		defer close(w.readerDone)
+		pollRing(w.out, w.stop, func(id uint32, payload []byte) {
+			if s.cfg.onPCM == nil {
+				return
+			}
+			if v, ok := s.byID.Load(id); ok {
+				s.cfg.onPCM(v.(*channelState).name, payload)
+			}
+		})
+	}()
+	go func() {
+		err := cmd.Wait()
+		s.onWorkerExit(w, err)
+	}()
+
+	return w, nil
+}
+
+// readControl handles the messages of the worker until its control pipe is closed.
+func (s *Supervisor) readControl(w *worker, r *os.File) {
+	defer r.Close()
+	scanner := bufio.NewScanner(r)
+	for scanner.Scan() {
+		var msg controlMessage
+		if err := json.Unmarshal(scanner.Bytes(), &msg); err != nil {
+			continue
+		}
+		switch msg.Op {
+		case opPong:
+			w.lastPong.Store(time.Now().UnixNano())
+			w.droppedOut.Store(msg.Dropped)
+		case opReply:
+			s.pendingMu.Lock()
+			ch, ok := s.pending[msg.Seq]
+			delete(s.pending, msg.Seq)
+			s.pendingMu.Unlock()
+			if ok {
+				ch <- msg
+			}
+		}
+	}
+}
+
+func (s *Supervisor) send(w *worker, msg controlMessage) error {
+	w.controlMu.Lock()
+	defer w.controlMu.Unlock()
+	return w.control.Encode(msg)
+}
+
+// request sends msg and waits for the reply of the worker.
+func (s *Supervisor) request(w *worker, msg controlMessage) (controlMessage, error) {
+	msg.Seq = s.seq.Add(1)
+	ch := make(chan controlMessage, 1)
+	s.pendingMu.Lock()
+	s.pending[msg.Seq] = ch
+	s.pendingMu.Unlock()
+	defer func() {
+		s.pendingMu.Lock()
+		delete(s.pending, msg.Seq)
+		s.pendingMu.Unlock()
+	}()
+
+	if err := s.send(w, msg); err != nil {
+		return controlMessage{}, err
+	}
+
+	timer := time.NewTimer(s.cfg.joinTimeout)
+	defer timer.Stop()
+	select {
+	case reply := <-ch:
+		return reply, nil
+	case <-w.exited:
+		return controlMessage{}, fmt.Errorf("worker %d exited", w.index)
+	case <-timer.C:
+		return controlMessage{}, ErrJoinTimeout
+	}
+}
+
+// join makes w join cs. A join which times out is cancelled, the worker leaves the channel if the join
+// completes later.
+func (s *Supervisor) join(w *worker, cs *channelState) error {
+	reply, err := s.request(w, controlMessage{Op: opJoin, Channel: cs.name, ID: cs.id, UserID: cs.userID, Token: cs.token})
+	if errors.Is(err, ErrJoinTimeout) {
+		// Nobody waits for the reply of the leave, it has no seq.
+		if leaveErr := s.send(w, controlMessage{Op: opLeave, Channel: cs.name, ID: cs.id}); leaveErr != nil {
+			s.reportError(fmt.Errorf("failed to cancel the join of channel %s on worker %d, %w", cs.name, w.index, leaveErr))
+		}
+	}
+	if err != nil {
+		return err
+	}
+	if reply.Error != "" {
+		return errors.New(reply.Error)
+	}
+	return nil
+}
+
+// reportError passes err to the OnError option, if any.
+func (s *Supervisor) reportError(err error) {
+	if s.cfg.onError != nil {
+		s.cfg.onError(err)
+	}
+}
+
+func (s *Supervisor) remove(cs *channelState) {
+	s.mu.Lock()
+	if s.channels[cs.name] == cs {
+		delete(s.channels, cs.name)
+	}
+	s.mu.Unlock()
+	s.byName.CompareAndDelete(cs.name, cs)
+	s.byID.Delete(cs.id)
+}
+
+func (s *Supervisor) healthCheckLoop() {
+	defer s.wg.Done()
+	ticker := time.NewTicker(s.cfg.healthCheckInterval)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-s.done:
+			return
+		case now := <-ticker.C:
+			s.mu.Lock()
+			workers := append([]*worker(nil), s.workers...)
+			s.mu.Unlock()
+			for _, w := range workers {
+				if w == nil || !w.alive.Load() {
+					continue
+				}
+				if now.Sub(time.Unix(0, w.lastPong.Load())) > s.cfg.healthCheckTimeout {
+					s.reportError(fmt.Errorf("worker %d doesn't answer, killing it", w.index))
+					w.cmd.Process.Kill()
+					continue
+				}
+				s.send(w, controlMessage{Op: opPing})
+			}
+		}
+	}
+}
+
+// onWorkerExit moves the channels of a dead worker and schedules its restart.
+func (s *Supervisor) onWorkerExit(w *worker, err error) {
+	w.alive.Store(false)
+	close(w.exited)
+	close(w.stop)
+	<-w.readerDone
+	w.in.close()
+	w.out.close()
+	unmapSharedMemory(w.inMem)
+	unmapSharedMemory(w.outMem)
+	w.controlOut.Close()
+
+	s.mu.Lock()
+	if s.closed {
+		s.mu.Unlock()
+		return
+	}
+	s.hash.remove(w.index)
+	for _, cs := range s.channels {
+		if cs.worker.Load() == w {
+			s.move(cs, s.hash.lookup(cs.name))
+		}
+	}
+
+	time.AfterFunc(s.cfg.restartDelay, func() {
+		s.restartWorker(w.index, w.restarts+1)
+	})
+	s.mu.Unlock()
+
+	if err != nil {
+		s.reportError(fmt.Errorf("worker %d exited, %w", w.index, err))
+	} else {
+		s.reportError(fmt.Errorf("worker %d exited", w.index))
+	}
+}
+
+// move joins cs on the worker to, or leaves it waiting for a worker if to is -1. It's called with s.mu held.
+func (s *Supervisor) move(cs *channelState, to int) {
+	if to < 0 {
+		cs.worker.Store(nil)
+		return
+	}
+	from := cs.index
+	w := s.workers[to]
+	cs.index = to
+	cs.worker.Store(w)
+	s.moves.Add(1)
+	go func() {
+		if err := s.join(w, cs); err != nil {
+			s.reportError(fmt.Errorf("failed to move channel %s to worker %d, %w", cs.name, to, err))
+			// Leave the channel without worker, so PushPCM doesn't feed a worker which dropped it and
+			// the next restart of a worker retries it.
+			s.mu.Lock()
+			if s.channels[cs.name] == cs {
+				cs.worker.CompareAndSwap(w, nil)
+			}
+			s.mu.Unlock()
+			return
+		}
+		if s.cfg.onChannelMoved != nil {
+			s.cfg.onChannelMoved(cs.name, from, to)
+		}
+	}()
+}
+
+func (s *Supervisor) restartWorker(index int, restarts int) {
+	s.mu.Lock()
+	closed := s.closed
+	s.mu.Unlock()
+	if closed {
+		return
+	}
+
+	w, err := s.startWorker(index)
+	if err != nil {
+		s.reportError(fmt.Errorf("failed to restart worker %d, %w", index, err))
+		time.AfterFunc(s.cfg.restartDelay, func() {
+			s.restartWorker(index, restarts)
+		})
+		return
+	}
+	w.restarts = restarts
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.closed {
+		w.controlOut.Close()
+		return
+	}
+	s.workers[index] = w
+	s.hash.add(index)
+	// The channels which were left without worker.
+	for _, cs := range s.channels {
+		if cs.worker.Load() == nil {
+			s.move(cs, s.hash.lookup(cs.name))
+		}
+	}
+}
@@ -0,0 +1,257 @@
+package shard
+
+import (
+	"bufio"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"os"
+	"strconv"
+	"sync"
+	"sync/atomic"
+)
+
+var (
+	// ErrNotWorker is the error returned by RunWorker in a process which wasn't started by a supervisor.
+	ErrNotWorker = errors.New("the process is not a shard worker")
+
+	// ErrUnknownChannel is the error returned for a channel which isn't joined.
+	ErrUnknownChannel = errors.New("unknown channel")
+
+	// ErrRingFull is the error returned when the pcm can't be queued, the pcm is dropped.
+	ErrRingFull = errors.New("the shared memory ring is full")
+)
+
+// WorkerHandler handles the channels assigned to a worker, typically with an RTC connection per channel.
+// The methods are called from different goroutines.
+type WorkerHandler interface {
+	// OnJoin joins the channel, the error is returned by Supervisor.Join.
+	OnJoin(channel string, userID string, token string) error
+
+	// OnLeave leaves the channel, also when the supervisor goes away.
+	OnLeave(channel string)
+
+	// OnPCM handles the pcm pushed by Supervisor.PushPCM. The data is only valid during the call.
+	OnPCM(channel string, data []byte)
+}
+
+// WorkerErrorHandler may be implemented by a WorkerHandler to be told about the errors which no call
+// returns, e.g. an invalid control message.
+type WorkerErrorHandler interface {
+	OnError(err error)
+}
+
+// Worker is the worker side of a supervisor, it's passed to the handler factory of RunWorker.
+type Worker struct {
+	index int
+
+	control *json.Encoder
+	// Serializes the writes to the control pipe.
+	controlMu sync.Mutex
+
+	in      *ring
+	out     *ring
+	dropped atomic.Uint64
+	// The OnError of the handler, nil if it doesn't implement WorkerErrorHandler.
+	onError func(err error)
+
+	mu       sync.RWMutex
+	channels map[string]uint32
+	names    map[uint32]string
+	// The joins in progress, by the seq of their message.
+	joining map[uint64]*pendingJoin
+}
+
+// pendingJoin is a join in progress, which a leave cancels: the channel is left as soon as it's joined.
+type pendingJoin struct {
+	channel   string
+	id        uint32
+	cancelled bool
+}
+
+// IsWorker returns true in a process started by a supervisor, which should call RunWorker.
+func IsWorker() bool {
+	return os.Getenv(workerEnvVar) != ""
+}
+
+// Index returns the index of the worker in the supervisor.
+func (w *Worker) Index() int {
+	return w.index
+}
+
+// SendPCM queues pcm of channel for the OnPCM option of the supervisor, it doesn't block.
+func (w *Worker) SendPCM(channel string, data []byte) error {
+	w.mu.RLock()
+	id, ok := w.channels[channel]
+	w.mu.RUnlock()
+	if !ok {
+		return ErrUnknownChannel
+	}
+	if !w.out.write(id, data) {
+		w.dropped.Add(1)
+		return ErrRingFull
+	}
+	return nil
+}
+
+// RunWorker serves the supervisor which started the process, with the handler returned by newHandler.
+// It returns when the supervisor closes the control pipe or exits, after leaving all the channels.
+func RunWorker(newHandler func(w *Worker) WorkerHandler) error {
+	if !IsWorker() {
+		return ErrNotWorker
+	}
+	index, err := strconv.Atoi(os.Getenv(workerEnvVar))
+	if err != nil {
+		return fmt.Errorf("invalid worker index, %w", err)
+	}
+	ringSize, err := strconv.Atoi(os.Getenv(workerRingSizeEnvVar))
+	if err != nil {
+		return fmt.Errorf("invalid ring size, %w", err)
+	}
+
+	controlIn := os.NewFile(workerControlInFd, "control-in")
+	controlOut := os.NewFile(workerControlOutFd, "control-out")
+	defer controlIn.Close()
+	defer controlOut.Close()
+
+	inMem, err := mapSharedMemory(os.NewFile(workerRingInFd, "ring-in"), ringSize)
+	if err != nil {
+		return fmt.Errorf("failed to map the input ring, %w", err)
+	}
+	defer unmapSharedMemory(inMem)
+	outMem, err := mapSharedMemory(os.NewFile(workerRingOutFd, "ring-out"), ringSize)
+	if err != nil {
+		return fmt.Errorf("failed to map the output ring, %w", err)
+	}
+	defer unmapSharedMemory(outMem)
+
+	w := &Worker{
+		index:    index,
+		control:  json.NewEncoder(controlOut),
+		in:       newRing(inMem),
+		out:      newRing(outMem),
+		channels: make(map[string]uint32),
+		names:    make(map[uint32]string),
+		joining:  make(map[uint64]*pendingJoin),
+	}
+	handler := newHandler(w)
+	if h, ok := handler.(WorkerErrorHandler); ok {
+		w.onError = h.OnError
+	}
+
+	stop := make(chan struct{})
+	var wg sync.WaitGroup
+	wg.Add(1)
+	go func() {
+		defer wg.Done()
+		pollRing(w.in, stop, func(id uint32, payload []byte) {
+			w.mu.RLock()
+			channel, ok := w.names[id]
+			w.mu.RUnlock()
+			if ok {
+				handler.OnPCM(channel, payload)
+			}
+		})
+	}()
+
+	scanner := bufio.NewScanner(controlIn)
+	for scanner.Scan() {
+		var msg controlMessage
+		if err := json.Unmarshal(scanner.Bytes(), &msg); err != nil {
+			w.reportError(fmt.Errorf("invalid control message, %w", err))
+			continue
+		}
+		switch msg.Op {
+		case opPing:
+			w.send(controlMessage{Op: opPong, Seq: msg.Seq, Dropped: w.dropped.Load()})
+		case opJoin:
+			// Joining may take a while, it mustn't delay the health checks.
+			go w.join(handler, msg)
+		case opLeave:
+			go w.leave(handler, msg)
+		}
+	}
+
+	// The supervisor is gone, leave everything.
+	close(stop)
+	wg.Wait()
+	w.in.close()
+	w.out.close()
+	w.mu.Lock()
+	channels := w.channels
+	w.channels = make(map[string]uint32)
+	w.names = make(map[uint32]string)
+	for _, j := range w.joining {
+		j.cancelled = true
+	}
+	w.mu.Unlock()
+	for channel := range channels {
+		handler.OnLeave(channel)
+	}
+	return scanner.Err()
+}
+
+func (w *Worker) join(handler WorkerHandler, msg controlMessage) {
+	reply := controlMessage{Op: opReply, Seq: msg.Seq, Channel: msg.Channel}
+	j := &pendingJoin{channel: msg.Channel, id: msg.ID}
+	w.mu.Lock()
+	w.joining[msg.Seq] = j
+	w.mu.Unlock()
+
+	err := handler.OnJoin(msg.Channel, msg.UserID, msg.Token)
+
+	w.mu.Lock()
+	delete(w.joining, msg.Seq)
+	cancelled := j.cancelled
+	if err == nil && !cancelled {
+		w.channels[msg.Channel] = msg.ID
+		w.names[msg.ID] = msg.Channel
+	}
+	w.mu.Unlock()
+
+	if err != nil {
+		reply.Error = err.Error()
+	} else if cancelled {
+		// The supervisor gave up on the join, e.g. after a timeout.
+		handler.OnLeave(msg.Channel)
+		reply.Error = "the join was cancelled"
+	}
+	w.send(reply)
+}
+
+// leave leaves the channel, or cancels its joins in progress. A leave with an ID only applies to the
+// channel joined with this ID.
+func (w *Worker) leave(handler WorkerHandler, msg controlMessage) {
+	w.mu.Lock()
+	for _, j := range w.joining {
+		if j.channel == msg.Channel && (msg.ID == 0 || j.id == msg.ID) {
+			j.cancelled = true
+		}
+	}
+	id, ok := w.channels[msg.Channel]
+	if ok && (msg.ID == 0 || id == msg.ID) {
+		delete(w.channels, msg.Channel)
+		delete(w.names, id)
+	} else {
+		ok = false
+	}
+	w.mu.Unlock()
+	if ok {
+		handler.OnLeave(msg.Channel)
+	}
+	w.send(controlMessage{Op: opReply, Seq: msg.Seq, Channel: msg.Channel})
+}
+
+func (w *Worker) send(msg controlMessage) {
+	w.controlMu.Lock()
+	defer w.controlMu.Unlock()
+	if err := w.control.Encode(msg); err != nil {
+		w.reportError(fmt.Errorf("failed to send control message, %w", err))
+	}
+}
+
+func (w *Worker) reportError(err error) {
+	if w.onError != nil {
+		w.onError(err)
+	}
+}
@@ -0,0 +1,297 @@
+package agorasdk
+
+import (
+	"fmt"
+	"math/rand"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	rtctokenbuilder "github.com/AgoraIO/Tools/DynamicKey/AgoraDynamicKey/go/src/rtctokenbuilder2"
+	agoraservice "github.com/zyy17/agora-server-sdk/agora/rtc"
+)
+
+const (
+	// DefaultTokenRenewBefore is the default time before the expiration at which a token is renewed.
+	DefaultTokenRenewBefore = 5 * time.Minute
+
+	// DefaultTokenRenewJitter is the default random time added to DefaultTokenRenewBefore, so that the
+	// connections created together don't renew their tokens together.
+	DefaultTokenRenewJitter = time.Minute
+
+	// tokenRenewRetryInterval is the delay before renewing a token again after a failure.
+	tokenRenewRetryInterval = 10 * time.Second
+
+	// tokenCacheSweepSize is the minimum number of cached tokens before the expired ones are removed.
+	tokenCacheSweepSize = 1024
+)
+
+// TokenRole represents the privileges of a token.
+type TokenRole int
+
+const (
+	// TokenRolePublisher represents a token which can publish and subscribe streams.
+	TokenRolePublisher TokenRole = 1
+
+	// TokenRoleSubscriber represents a token which can only subscribe streams.
+	TokenRoleSubscriber TokenRole = 2
+)
+
+// tokenRoleOf returns the role of the tokens of a connection with the client role.
+func tokenRoleOf(role agoraservice.ClientRole) TokenRole {
+	if role == agoraservice.ClientRoleBroadcaster {
+		return TokenRolePublisher
+	}
+	return TokenRoleSubscriber
+}
+
+// tokenKey identifies the cached tokens.
+type tokenKey struct {
+	channelName string
+	userID      string
+	role        TokenRole
+}
+
+// cachedToken is a token with its expiration.
+type cachedToken struct {
+	token     string
+	expiresAt time.Time
+}
+
+// tokenRenewal is the renewal of the token of a connection.
+type tokenRenewal struct {
+	key   tokenKey
+	timer *time.Timer
+}
+
+// TokenManager builds the tokens of a service with its app certificate and caches them per channel,
+// user and role. The connections which use its tokens have them renewed in the background before they
+// expire, through RenewToken, until they are released.
+type TokenManager struct {
+	appID       string
+	appCert     string
+	lifetime    time.Duration
+	renewBefore time.Duration
+	jitter      time.Duration
+
+	mu       sync.Mutex
+	tokens   map[tokenKey]cachedToken
+	sweepAt  int
+	renewals map[*RTCConnection]*tokenRenewal
+	closed   bool
+
+	minted        atomic.Uint64
+	hits          atomic.Uint64
+	renewed       atomic.Uint64
+	renewFailures atomic.Uint64
+}
+
+// TokenManagerStats represents the counters of a token manager.
+type TokenManagerStats struct {
+	// The number of cached tokens, and of connections whose token is renewed.
+	Cached  int
+	Tracked int
+
+	// Tokens built, and tokens served from the cache.
+	Minted uint64
+	Hits   uint64
+
+	Renewed       uint64
+	RenewFailures uint64
+}
+
+func newTokenManager(appID string, appCert string, renewBefore time.Duration, jitter time.Duration) (*TokenManager, error) {
+	if renewBefore <= 0 {
+		renewBefore = DefaultTokenRenewBefore
+	}
+	if jitter < 0 {
+		jitter = 0
+	}
+	lifetime := DefaultTokenExpirationInSeconds * time.Second
+	if renewBefore+jitter >= lifetime {
+		return nil, fmt.Errorf("the token renewal window %v is longer than the token lifetime %v", renewBefore+jitter, lifetime)
+	}
+
+	return &TokenManager{
+		appID:       appID,
+		appCert:     appCert,
+		lifetime:    lifetime,
+		renewBefore: renewBefore,
+		jitter:      jitter,
+		tokens:      make(map[tokenKey]cachedToken),
+		sweepAt:     tokenCacheSweepSize,
+		renewals:    make(map[*RTCConnection]*tokenRenewal),
+	}, nil
+}
+
+// Token returns a token of the user in the channel with the role, from the cache unless the cached one
+// is about to be renewed.
+func (m *TokenManager) Token(channelName string, userID string, role TokenRole) (string, error) {
+	t, err := m.token(tokenKey{channelName: channelName, userID: userID, role: role})
+	if err != nil {
+		return "", err
+	}
+	return t.token, nil
+}
+
+// Stats returns the counters of the token manager.
+func (m *TokenManager) Stats() TokenManagerStats {
+	m.mu.Lock()
+	cached, tracked := len(m.tokens), len(m.renewals)
+	m.mu.Unlock()
+
+	return TokenManagerStats{
+		Cached:        cached,
+		Tracked:       tracked,
+		Minted:        m.minted.Load(),
+		Hits:          m.hits.Load(),
+		Renewed:       m.renewed.Load(),
+		RenewFailures: m.renewFailures.Load(),
+	}
+}
+
+func (m *TokenManager) token(key tokenKey) (cachedToken, error) {
+	now := time.Now()
+
+	// A token within the renewal window isn't reused, the connections renewing it need a new one.
+	m.mu.Lock()
+	t, ok := m.tokens[key]
+	m.mu.Unlock()
+	if ok && t.expiresAt.Sub(now) > m.renewBefore+m.jitter {
+		m.hits.Add(1)
+		return t, nil
+	}
+
+	token, err := buildToken(m.appID, m.appCert, key.channelName, key.userID, key.role)
+	if err != nil {
+		return cachedToken{}, err
+	}
+	m.minted.Add(1)
+	t = cachedToken{token: token, expiresAt: now.Add(m.lifetime)}
+
+	m.mu.Lock()
+	m.tokens[key] = t
+	if len(m.tokens) >= m.sweepAt {
+		for k, cached := range m.tokens {
+			if !cached.expiresAt.After(now) {
+				delete(m.tokens, k)
+			}
+		}
+		m.sweepAt = max(2*len(m.tokens), tokenCacheSweepSize)
+	}
+	m.mu.Unlock()
+
+	return t, nil
+}
+
+// track returns a token for conn to connect with and renews it until untrack is called.
+func (m *TokenManager) track(conn *RTCConnection, channelName string, userID string) (string, error) {
+	key := tokenKey{channelName: channelName, userID: userID, role: conn.tokenRole}
+	t, err := m.token(key)
+	if err != nil {
+		return "", err
+	}
+
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.closed {
+		return t.token, nil
+	}
+	if r := m.renewals[conn]; r != nil {
+		r.timer.Stop()
+	}
+	r := &tokenRenewal{key: key}
+	r.timer = time.AfterFunc(m.renewDelay(t), func() {
+		m.renew(conn)
+	})
+	m.renewals[conn] = r
+	return t.token, nil
+}
+
+// untrack stops renewing the token of conn.
+func (m *TokenManager) untrack(conn *RTCConnection) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if r := m.renewals[conn]; r != nil {
+		r.timer.Stop()
+		delete(m.renewals, conn)
+	}
+}
+
+// renewNow renews the token of conn as soon as possible, off the calling goroutine. It's called when
+// the SDK reports that the token expires, so the callback thread isn't held by the renewal.
+func (m *TokenManager) renewNow(conn *RTCConnection) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if r := m.renewals[conn]; r != nil {
+		r.timer.Reset(0)
+	}
+}
+
+// renewDelay returns the time until t is renewed, at a random point of the renewal window.
+func (m *TokenManager) renewDelay(t cachedToken) time.Duration {
+	before := m.renewBefore
+	if m.jitter > 0 {
+		before += time.Duration(rand.Int63n(int64(m.jitter)))
+	}
+	return max(time.Until(t.expiresAt)-before, 0)
+}
+
+func (m *TokenManager) renew(conn *RTCConnection) {
+	m.mu.Lock()
+	r := m.renewals[conn]
+	m.mu.Unlock()
+	if r == nil {
+		return
+	}
+
+	next := tokenRenewRetryInterval
+	if t, err := m.token(r.key); err != nil {
+		m.renewFailures.Add(1)
+	} else if ret, ok := conn.renewToken(t.token); !ok {
+		// The connection is being released.
+		return
+	} else if ret != 0 {
+		m.renewFailures.Add(1)
+	} else {
+		m.renewed.Add(1)
+		next = m.renewDelay(t)
+	}
+
+	m.mu.Lock()
+	if m.renewals[conn] == r {
+		r.timer.Reset(next)
+	}
+	m.mu.Unlock()
+}
+
+// close stops all the renewals.
+func (m *TokenManager) close() {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.closed = true
+	for conn, r := range m.renewals {
+		r.timer.Stop()
+		delete(m.renewals, conn)
+	}
+}
+
+// renewToken renews the token of the connection unless it's being released, in which case ok is false.
+// It goes through the callback gate, so the release waits for it.
+func (c *RTCConnection) renewToken(token string) (ret int, ok bool) {
+	if !c.enterCallback() {
+		return 0, false
+	}
+	defer c.exitCallback()
+	return c.rtcConn.RenewToken(token), true
+}
+
+// buildToken builds a token of the user in the channel with the role.
+func buildToken(appID string, appCert string, channelName string, userID string, role TokenRole) (string, error) {
+	builderRole := rtctokenbuilder.RolePublisher
+	if role == TokenRoleSubscriber {
+		builderRole = rtctokenbuilder.RoleSubscriber
+	}
+	return rtctokenbuilder.BuildTokenWithUserAccount(appID, appCert, channelName, userID,
+		builderRole, DefaultTokenExpirationInSeconds, DefaultPrivilegeExpirationInSeconds)
+}
@@ -0,0 +1,168 @@
+package agorasdk
+
+import (
+	"sync/atomic"
+	"time"
+)
+
+// tracePhase is a step of the join and publish of a connection.
+type tracePhase int
+
+const (
+	tracePhaseCreated tracePhase = iota
+	tracePhaseConnect
+	tracePhaseConnected
+	tracePhasePublish
+	tracePhasePublished
+	tracePhaseFirstPCM
+	tracePhaseFirstRemoteAudio
+	tracePhases
+)
+
+// ConnectionTimeline represents when a connection reached the steps of its join and publish, as
+// monotonic offsets from the start of its creation. A step which wasn't reached is zero.
+type ConnectionTimeline struct {
+	Start time.Time
+
+	// The connection, its local user and observers are created.
+	Created time.Duration
+
+	// Connect is called, and the SDK reports the connection as established.
+	Connect   time.Duration
+	Connected time.Duration
+
+	// PublishAudio is called, and the SDK reports the audio track as published.
+	Publish   time.Duration
+	Published time.Duration
+
+	// The first successful PushAudioPCMData.
+	FirstPCM time.Duration
+
+	// The first audio frame received from a remote user.
+	FirstRemoteAudio time.Duration
+}
+
+// TraceStats represents the latencies of the steps of the connections of a service.
+type TraceStats struct {
+	// From the start of the creation to Created.
+	Create LatencyHistogramSnapshot
+
+	// From Connect to Connected.
+	Connect LatencyHistogramSnapshot
+
+	// From Publish to Published.
+	Publish LatencyHistogramSnapshot
+
+	// From Connect to FirstPCM, the time until a joining connection sends audio.
+	FirstPCM LatencyHistogramSnapshot
+
+	// From Connect to FirstRemoteAudio.
+	FirstRemoteAudio LatencyHistogramSnapshot
+}
+
+// connectionTracer aggregates the traces of the connections of a service.
+type connectionTracer struct {
+	create           LatencyHistogram
+	connect          LatencyHistogram
+	publish          LatencyHistogram
+	firstPCM         LatencyHistogram
+	firstRemoteAudio LatencyHistogram
+}
+
+// connectionTrace records the steps of a connection. Every step is recorded once, so a reconnection or
+// a publish after an unpublish doesn't move it.
+type connectionTrace struct {
+	tracer *connectionTracer
+	start  time.Time
+	// The offsets from start in nanoseconds, 0 if the step isn't reached.
+	marks [tracePhases]atomic.Int64
+}
+
+func (t *connectionTracer) stats() TraceStats {
+	return TraceStats{
+		Create:           t.create.Snapshot(),
+		Connect:          t.connect.Snapshot(),
+		Publish:          t.publish.Snapshot(),
+		FirstPCM:         t.firstPCM.Snapshot(),
+		FirstRemoteAudio: t.firstRemoteAudio.Snapshot(),
+	}
+}
+
+func (t *connectionTracer) newTrace() *connectionTrace {
+	return &connectionTrace{tracer: t, start: time.Now()}
+}
+
+// reached returns true if the step is recorded, it's the cheap check of the per-frame steps.
+func (t *connectionTrace) reached(phase tracePhase) bool {
+	return t.marks[phase].Load() != 0
+}
+
+// mark records the step at the current time and the span it ends, unless the step is already recorded.
+func (t *connectionTrace) mark(phase tracePhase) {
+	if t.reached(phase) {
+		return
+	}
+	// time.Since uses the monotonic clock of start, an offset of 0 is stored as 1 to mean reached.
+	offset := max(int64(time.Since(t.start)), 1)
+	if !t.marks[phase].CompareAndSwap(0, offset) {
+		return
+	}
+
+	switch phase {
+	case tracePhaseCreated:
+		t.tracer.create.Record(time.Duration(offset))
+	case tracePhaseConnected:
+		t.recordSpan(&t.tracer.connect, tracePhaseConnect, offset)
+	case tracePhasePublished:
+		t.recordSpan(&t.tracer.publish, tracePhasePublish, offset)
+	case tracePhaseFirstPCM:
+		t.recordSpan(&t.tracer.firstPCM, tracePhaseConnect, offset)
+	case tracePhaseFirstRemoteAudio:
+		t.recordSpan(&t.tracer.firstRemoteAudio, tracePhaseConnect, offset)
+	}
+}
+
+// recordSpan records the time from the from step to offset, if the from step is reached.
+func (t *connectionTrace) recordSpan(h *LatencyHistogram, from tracePhase, offset int64) {
+	if begin := t.marks[from].Load(); begin != 0 {
+		h.Record(time.Duration(offset - begin))
+	}
+}
+
+// trace records a step of the connection if tracing is enabled, it doesn't allocate.
+func (c *RTCConnection) trace(phase tracePhase) {
+	if c.tracing != nil {
+		c.tracing.mark(phase)
+	}
+}
+
+// Timeline returns the steps reached by the connection, it's zero if the tracing of the service is
+// disabled, see WithConnectionTracing.
+func (c *RTCConnection) Timeline() ConnectionTimeline {
+	t := c.tracing
+	if t == nil {
+		return ConnectionTimeline{}
+	}
+	offset := func(phase tracePhase) time.Duration {
+		return time.Duration(t.marks[phase].Load())
+	}
+	return ConnectionTimeline{
+		Start:            t.start,
+		Created:          offset(tracePhaseCreated),
+		Connect:          offset(tracePhaseConnect),
+		Connected:        offset(tracePhaseConnected),
+		Publish:          offset(tracePhasePublish),
+		Published:        offset(tracePhasePublished),
+		FirstPCM:         offset(tracePhaseFirstPCM),
+		FirstRemoteAudio: offset(tracePhaseFirstRemoteAudio),
+	}
+}
+
+// TraceStats returns the latency histograms of the steps of the connections, they are empty if the
+// tracing is disabled.
+func (s *Service) TraceStats() TraceStats {
+	if s.tracer == nil {
+		return TraceStats{}
+	}
+	return s.tracer.stats()
+}